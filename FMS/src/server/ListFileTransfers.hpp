@@ -109,7 +109,8 @@ public:
 
     std::vector<std::string>::iterator iter;
     std::vector<std::string> results;
-    vishnu::validateAuthKey(mauthKey, mdatabaseInstance, muserSessionInfo);
+    // the session is checked on the primary, a replica may lag behind
+    vishnu::validateAuthKey(mauthKey, DbFactory().getDatabaseInstance(), muserSessionInfo);
 
     FMS_Data::FMS_DataFactory_ptr ecoreFactory = FMS_Data::FMS_DataFactory::_instance();
     mlistObject = ecoreFactory->createFileTransferList();
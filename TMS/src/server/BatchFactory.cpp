@@ -6,50 +6,182 @@
  */
 
 #include "BatchFactory.hpp"
+#include <map>
 #include <string>
+#include <vector>
 #include <boost/format.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
 #include <iostream>
 #include "tmsUtils.hpp"
 #include "SharedLibrary.hh"
 
 
-static int created = 0;
-
 /**
  * \brief Constructor
  */
-BatchFactory::BatchFactory() : mbatchServer(NULL) {
+BatchFactory::BatchFactory() {
 }
 
 
-BatchServer*
-loadPluginBatch(const char *name) {
-  dadi::SharedLibrary *plugin(NULL);
-  BatchServer *instance(NULL);
+// anonymous namespace
+namespace {
+  /**
+   * \brief A plugin loaded once, with its unused instances
+   */
+  struct BatchPlugin {
+    /**
+     * \brief The library, never unloaded since instances may be in use
+     */
+    dadi::SharedLibrary* library;
+    /**
+     * \brief The factory of the instances
+     */
+    factory_function factory;
+    /**
+     * \brief Whether an instance can serve several callers in turn
+     */
+    bool reusable;
+    /**
+     * \brief The instances released, for the next callers
+     */
+    std::vector<BatchServer*> idle;
+  };
+
+  /**
+   * \class BatchPluginRegistry
+   * \brief The plugins loaded by the process
+   */
+  class BatchPluginRegistry : public boost::noncopyable {
+  public:
+    /**
+     * \brief Get the registry of the process
+     * \return the registry
+     */
+    static BatchPluginRegistry&
+    getInstance() {
+      // never destroyed: the instances may be released at exit
+      static BatchPluginRegistry* instance = new BatchPluginRegistry();
+      return *instance;
+    }
+
+    /**
+     * \brief Get an instance of a plugin, loading it if needed
+     * \param libname the name of the plugin library
+     * \param reusable whether the instances keep no state from a call to
+     * the next one
+     * \return the instance, or an empty pointer if the plugin cannot be loaded
+     */
+    boost::shared_ptr<BatchServer>
+    acquire(const std::string& libname, bool reusable);
+
+    /**
+     * \brief Give an instance back
+     * \param libname the name of the plugin library
+     * \param instance the instance
+     */
+    void
+    release(const std::string& libname, BatchServer* instance);
+
+  private:
+    /**
+     * \brief Protects the plugins
+     */
+    boost::mutex mmutex;
+    /**
+     * \brief The plugins loaded, by library name
+     */
+    std::map<std::string, BatchPlugin> mplugins;
+  };
+
+  /**
+   * \brief Gives the instances back to the registry instead of deleting them
+   */
+  struct BatchServerReleaser {
+    /**
+     * \brief The name of the plugin library
+     */
+    std::string libname;
 
-  std::string libname = boost::str(boost::format("%1%%2%%3%")
-                                   % dadi::SharedLibrary::prefix()
-                                   % name
-                                   % dadi::SharedLibrary::suffix());
+    /**
+     * \brief Give an instance back
+     * \param instance the instance
+     */
+    void
+    operator()(BatchServer* instance) const {
+      BatchPluginRegistry::getInstance().release(libname, instance);
+    }
+  };
 
-  plugin = new dadi::SharedLibrary(libname);
-  if (plugin->isLoaded()) {
-    void *factory = plugin->symbol("create_plugin_instance");
-    reinterpret_cast<factory_function>(factory)(reinterpret_cast<void**>(&instance));
+  boost::shared_ptr<BatchServer>
+  BatchPluginRegistry::acquire(const std::string& libname, bool reusable) {
+    BatchServer* instance(NULL);
+    factory_function factory(NULL);
+    {
+      boost::lock_guard<boost::mutex> lock(mmutex);
+      std::map<std::string, BatchPlugin>::iterator it = mplugins.find(libname);
+      if (it == mplugins.end()) {
+        std::string path = boost::str(boost::format("%1%%2%%3%")
+                                      % dadi::SharedLibrary::prefix()
+                                      % libname
+                                      % dadi::SharedLibrary::suffix());
+        dadi::SharedLibrary* library = new dadi::SharedLibrary(path);
+        void* symbol = library->isLoaded() ? library->symbol("create_plugin_instance") : NULL;
+        if (!symbol) {
+          // not kept, a later call may find the plugin installed
+          delete library;
+          return boost::shared_ptr<BatchServer>();
+        }
+        BatchPlugin plugin;
+        plugin.library = library;
+        plugin.factory = reinterpret_cast<factory_function>(symbol);
+        plugin.reusable = reusable;
+        it = mplugins.insert(std::make_pair(libname, plugin)).first;
+      }
+      if (!it->second.idle.empty()) {
+        instance = it->second.idle.back();
+        it->second.idle.pop_back();
+      }
+      factory = it->second.factory;
+    }
+
+    // the plugin constructors may read their configuration, out of the lock
+    if (!instance) {
+      factory(reinterpret_cast<void**>(&instance));
+      if (!instance) {
+        return boost::shared_ptr<BatchServer>();
+      }
+    }
+    BatchServerReleaser releaser;
+    releaser.libname = libname;
+    return boost::shared_ptr<BatchServer>(instance, releaser);
+  }
+
+  void
+  BatchPluginRegistry::release(const std::string& libname, BatchServer* instance) {
+    {
+      boost::lock_guard<boost::mutex> lock(mmutex);
+      std::map<std::string, BatchPlugin>::iterator it = mplugins.find(libname);
+      if (it != mplugins.end() && it->second.reusable
+          && it->second.idle.size() < BATCH_PLUGIN_MAX_IDLE) {
+        it->second.idle.push_back(instance);
+        return;
+      }
+    }
+    delete instance;
   }
-  return instance;
 }
 
 /**
- * \brief Function to create a batchServer.
- * \param batchType The type of batchServer to create
- * \param batchVersion The version of batchServer to create
- * \return an instance of BatchServer, or NULL
+ * \brief Function to get a batchServer.
+ * \param batchType The type of batchServer to get
+ * \param batchVersion The version of batchServer to get
+ * \return an instance of BatchServer, or an empty pointer
  */
-BatchServer*
+boost::shared_ptr<BatchServer>
 BatchFactory::getBatchServerInstance(int batchType,
                                      const std::string &batchVersion) {
-  BatchServer *instance(NULL);
   std::string libname = "vishnu-tms-";
   // batchVersion is set to n/a when not applicable but MUST be not be taken into account when loading the lib
   std::string realBatchVersion = (batchVersion!="n/a")? batchVersion : "";
@@ -89,18 +221,12 @@ BatchFactory::getBatchServerInstance(int batchType,
   }
 
   libname += realBatchVersion;
-  instance = loadPluginBatch(libname.c_str());
-  return static_cast<BatchServer *>(instance);
+  // the cloud plugins keep the parameters of a submission in their instance
+  bool reusable = (batchType != DELTACLOUD && batchType != OPENNEBULA);
+  return BatchPluginRegistry::getInstance().acquire(libname, reusable);
 }
 
 
-/**
- * \brief Function to delete a batchServer.
- */
-void
-BatchFactory::deleteBatchServerInstance() {
-  delete mbatchServer;
-}
 /**
  * \brief Destructor
  */
@@ -9,11 +9,17 @@
 #define TMS_BATCH_FACTORY_H
 
 #include <string>
+#include <boost/shared_ptr.hpp>
 #include "utilVishnu.hpp"
 #include "TMSVishnuException.hpp"
 #include "UMSVishnuException.hpp"
 #include "BatchServer.hpp"
 
+/**
+ * \brief Maximum number of unused instances kept by plugin
+ */
+const size_t BATCH_PLUGIN_MAX_IDLE = 8;
+
 /**
  * \class BatchFactory
  * \brief A factory class to manage the life of BatchServer instance
@@ -33,27 +39,17 @@ class BatchFactory
     ~BatchFactory();
 
     /**
-     * \brief Function to create a batchServer.
-     * \param BatchType The type of batchServer to create
-     * \param batchVersion The version of batchServer to create
-     * \return an instance of BatchServer, or NULL
+     * \brief Function to get a batchServer.
+     * The plugins are loaded once per process. The instance is for the
+     * exclusive use of the caller, and the batch scheduler ones are reused
+     * by the next callers once released.
+     * \param BatchType The type of batchServer to get
+     * \param batchVersion The version of batchServer to get
+     * \return an instance of BatchServer, or an empty pointer
      */
-    BatchServer*
+    boost::shared_ptr<BatchServer>
     getBatchServerInstance(int BatchType,
                            const std::string &batchVersion);
-
-    /**
-     * \brief Function to delete a batchServer.
-     */
-    void deleteBatchServerInstance();
-
-  private :
-
-    /**
-     * \brief an instance of the batchServer
-     */
-    BatchServer* mbatchServer;
-
 };
 
 #endif
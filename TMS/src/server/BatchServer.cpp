@@ -6,6 +6,7 @@
  */
 
 #include "BatchServer.hpp"
+#include "VishnuException.hpp"
 
 /**
  * \brief Constructor
@@ -19,3 +20,21 @@ BatchServer::BatchServer() {
 BatchServer::~BatchServer() {
     
 }
+
+/**
+ * \brief Function to get the status of several jobs
+ * \param jobIds the identifiers of the jobs
+ * \return the states in the order of jobIds, -1 when unknown
+ */
+std::vector<int>
+BatchServer::getJobStates(const std::vector<std::string>& jobIds) {
+  std::vector<int> states(jobIds.size(), -1);
+  for (size_t i = 0; i < jobIds.size(); ++i) {
+    try {
+      states[i] = getJobState(jobIds[i]);
+    } catch (VishnuException&) {
+      // the other jobs are still worth polling
+    }
+  }
+  return states;
+}
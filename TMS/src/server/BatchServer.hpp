@@ -9,6 +9,7 @@
 #define TMS_BATCH_SERVER_H
 
 #include <string>
+#include <vector>
 #include <iostream>
 
 //EMF
@@ -72,6 +73,17 @@ public:
   virtual int
   getJobState(const std::string& jobId)=0;
 
+  /**
+   * \brief Function to get the status of several jobs with a single query
+   * to the batch scheduler where it allows it, the default calls
+   * getJobState for each job
+   * \param jobIds the identifiers of the jobs
+   * \return the states in the order of jobIds, -1 for the jobs whose state
+   * could not be got
+   */
+  virtual std::vector<int>
+  getJobStates(const std::vector<std::string>& jobIds);
+
   /**
    * \brief Function to get the start time of the job
    * \param jobId the identifier of the job
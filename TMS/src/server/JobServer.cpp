@@ -6,6 +6,7 @@
  */
 
 #include <fcntl.h>
+#include <vector>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <sys/stat.h>
@@ -58,6 +59,7 @@ JobServer::JobServer(const std::string& authKey,
   if (! msedConfig->getConfigValue<int>(vishnu::STANDALONE, mstandaloneSed)) {
     mstandaloneSed = false;
   }
+  msedConfig->getConfigValue<std::string>(vishnu::JOBEVENTDIR, mjobEventDir);
   checkMachineId(machineId);
   vishnu::validateAuthKey(mauthKey, mmachineId, mdatabaseInstance, muserSessionInfo);
 }
@@ -168,7 +170,8 @@ JobServer::handleSshBatchExec(int action,
                         static_cast<BatchType>(batchType),
                         batchVersion, // ignored for POSIX backend
                         JsonObject::serialize(baseJobInfo),
-                        options->encode());
+                        options->encode(),
+                        mjobEventDir);
 
   sshJobExec.setDebugLevel(mdebugLevel);
   TMS_Data::ListJobs jobSteps;
@@ -212,7 +215,7 @@ JobServer::handleNativeBatchExec(int action,
                                  int batchType,
                                  const std::string& batchVersion) {
   BatchFactory factory;
-  BatchServer* batchServer = factory.getBatchServerInstance(batchType, batchVersion);
+  boost::shared_ptr<BatchServer> batchServer = factory.getBatchServerInstance(batchType, batchVersion);
   if (! batchServer) {
     throw TMSVishnuException(ERRCODE_BATCH_SCHEDULER_ERROR,
                              boost::str(boost::format("getBatchServerInstance return NULL (batch: %1%, version: %2%)")
@@ -257,6 +260,11 @@ JobServer::handleNativeBatchExec(int action,
             vishnu::createDir(jobInfo.getOutputDir());
           }
 
+          // tms-posix reports there the end of the job
+          if (! mjobEventDir.empty()) {
+            setenv(JOB_EVENT_DIR_ENV.c_str(), mjobEventDir.c_str(), 1);
+          }
+
           // submit the job
           TMS_Data::ListJobs jobSteps;
           handlerExitCode = batchServer->submit(vishnu::copyFileToUserHome(scriptPath), options->getSubmitOptions(), jobSteps, NULL);
@@ -574,20 +582,23 @@ JobServer::getJobInfo(const std::string& jobId)
 void
 JobServer::getJobStepInfo(const std::string& jobId, TMS_Data::ListJobs& jobSteps)
 {
-  std::string sqlQuery = boost::str(boost::format(
-                                      "SELECT vsessionid, submitMachineId, submitMachineName, "
-                                      "   jobId, jobName, batchJobId, jobPath, workId, relatedSteps, "
-                                      "   outputPath, errorPath, outputDir, jobWorkingDir, "
-                                      "   jobPrio, nbCpus, job.status, submitDate, endDate, "
-                                      "   owner, jobQueue,wallClockLimit, groupName, memLimit,"
-                                      "   nbNodes, nbNodesAndCpuPerNode, userid, vmId, vmIp, jobDescription"
-                                      " FROM job, vsession, users "
-                                      " WHERE vsession.numsessionid=job.vsession_numsessionid "
-                                      "   AND vsession.users_numuserid=users.numuserid"
-                                      "   AND (job.jobId='%1%' OR job.jobId like '%1%._%%');"
-                                      ) % mdatabaseInstance->escapeData(jobId));
-
-  boost::scoped_ptr<DatabaseResult> sqlResult(mdatabaseInstance->getResult(sqlQuery));
+  mdatabaseInstance->prepare("getJobStepInfo",
+                             "SELECT vsessionid, submitMachineId, submitMachineName, "
+                             "   jobId, jobName, batchJobId, jobPath, workId, relatedSteps, "
+                             "   outputPath, errorPath, outputDir, jobWorkingDir, "
+                             "   jobPrio, nbCpus, job.status, submitDate, endDate, "
+                             "   owner, jobQueue,wallClockLimit, groupName, memLimit,"
+                             "   nbNodes, nbNodesAndCpuPerNode, userid, vmId, vmIp, jobDescription"
+                             " FROM job, vsession, users "
+                             " WHERE vsession.numsessionid=job.vsession_numsessionid "
+                             "   AND vsession.users_numuserid=users.numuserid"
+                             "   AND (job.jobId=? OR job.jobId like ?)");
+
+  boost::scoped_ptr<DatabaseResult> sqlResult(
+        mdatabaseInstance->getPreparedResult("getJobStepInfo",
+                                             DbParams()
+                                             .add(jobId)
+                                             .add(jobId + "._%")));
   if (sqlResult->getNbTuples() == 0) {
     throw TMSVishnuException(ERRCODE_UNKNOWN_JOBID);
   }
@@ -917,14 +928,21 @@ JobServer::updateAndSaveJobSteps(TMS_Data::ListJobs& jobSteps, TMS_Data::Job& ba
       currentJobPtr->setJobPath(baseJobInfo.getJobPath());
       currentJobPtr->setOwner(baseJobInfo.getOwner());
       currentJobPtr->setOutputDir(baseJobInfo.getOutputDir());
+    }
 
-      // create an entry to the database for the step
-      mdatabaseInstance->process(boost::str(boost::format("INSERT INTO job (jobid, vsession_numsessionid)"
-                                                          " VALUES ('%1%', %2%)"
-                                                          ) % currentJobPtr->getJobId() % muserSessionInfo.num_session));
+    // the entries of all the steps go to the database together
+    std::vector<std::string> requests;
+    requests.reserve(2 * nbSteps);
+    std::string values;
+    for (int step = 0; step < nbSteps; ++step) {
+      if (! values.empty()) values+=",";
+      values+=boost::str(boost::format("('%1%', %2%)")
+                         % mdatabaseInstance->escapeData(jobSteps.getJobs().get(step)->getJobId())
+                         % muserSessionInfo.num_session);
     }
+    requests.push_back("INSERT INTO job (jobid, vsession_numsessionid) VALUES "+values);
 
-    // now each job's related steps and record to database
+    // now each job's related steps
     for (int step = 0; step < nbSteps; ++step) {
       std::string relatedStepList =  "";
       for (int relatedStep = 0; relatedStep < nbSteps; ++relatedStep) {
@@ -934,7 +952,12 @@ JobServer::updateAndSaveJobSteps(TMS_Data::ListJobs& jobSteps, TMS_Data::Job& ba
       }
       TMS_Data::Job_ptr currentJobPtr = jobSteps.getJobs().get(step);
       currentJobPtr->setRelatedSteps(relatedStepList);
-      updateJobRecordIntoDatabase(SubmitBatchAction, *currentJobPtr);
+      requests.push_back(getSubmitRecordQuery(*currentJobPtr));
+    }
+    mdatabaseInstance->processBatch(requests);
+
+    for (int step = 0; step < nbSteps; ++step) {
+      logJobSubmission(*jobSteps.getJobs().get(step));
     }
   }
 }
@@ -956,62 +979,83 @@ JobServer::updateJobRecordIntoDatabase(int action, TMS_Data::Job& job)
                    % job.getJobId()), LogInfo);
 
   } else if (action == SubmitBatchAction) {
-    // Append the machine name to the error and output path if necessary
-    size_t pos = job.getOutputPath().find(":");
-    std::string prefixOutputPath = (pos == std::string::npos)? muserSessionInfo.machine_name+":" : "";
-    job.setOutputPath(prefixOutputPath+job.getOutputPath());
-    pos = job.getErrorPath().find(":");
-    std::string prefixErrorPath = (pos == std::string::npos)? muserSessionInfo.machine_name+":" : "";
-    job.setErrorPath(prefixErrorPath+job.getErrorPath());
-
-    // Update the database with the result
-    std::string query = "UPDATE job set ";
-    query+="vsession_numsessionid="+vishnu::convertToString(muserSessionInfo.num_session)+", ";
-    query+="job_owner_id="+vishnu::convertToString(muserSessionInfo.num_user)+", ";
-    query+="owner='"+mdatabaseInstance->escapeData(job.getOwner())+"', ";
-    query+="submitMachineId='"+mdatabaseInstance->escapeData(mmachineId)+"', ";
-    query+="submitMachineName='"+mdatabaseInstance->escapeData(muserSessionInfo.machine_name)+"', ";
-    query+="batchJobId='"+mdatabaseInstance->escapeData(job.getBatchJobId())+"', ";
-    query+="batchType="+vishnu::convertToString(mbatchType)+", ";
-    query+="jobName='"+mdatabaseInstance->escapeData(job.getJobName())+"', ";
-    query+="jobPath='"+mdatabaseInstance->escapeData(job.getJobPath())+"', ";
-    query+="outputPath='"+mdatabaseInstance->escapeData(job.getOutputPath())+"',";
-    query+="errorPath='"+mdatabaseInstance->escapeData(job.getErrorPath())+"',";
-    query+="scriptContent='job', ";
-    query+="jobPrio="+vishnu::convertToString(job.getJobPrio())+", ";
-    query+="nbCpus="+vishnu::convertToString(job.getNbCpus())+", ";
-    query+="jobWorkingDir='"+mdatabaseInstance->escapeData(job.getJobWorkingDir())+"', ";
-    query+="status="+vishnu::convertToString(job.getStatus())+", ";
-    query+="submitDate=CURRENT_TIMESTAMP, ";
-    query+="jobQueue='"+mdatabaseInstance->escapeData(job.getJobQueue())+"', ";
-    query+="wallClockLimit="+vishnu::convertToString(job.getWallClockLimit())+", ";
-    query+="groupName='"+mdatabaseInstance->escapeData(job.getGroupName())+"',";
-    query+="jobDescription='"+mdatabaseInstance->escapeData(job.getJobDescription())+"', ";
-    query+="memLimit="+vishnu::convertToString(job.getMemLimit())+", ";
-    query+="nbNodes="+vishnu::convertToString(job.getNbNodes())+", ";
-    query+="nbNodesAndCpuPerNode='"+mdatabaseInstance->escapeData(job.getNbNodesAndCpuPerNode())+"', ";
-    query+="outputDir='"+mdatabaseInstance->escapeData(job.getOutputDir())+"', ";
-    query+= job.getWorkId()? "workId="+vishnu::convertToString(job.getWorkId())+", " : "";
-    query+="vmId='"+mdatabaseInstance->escapeData(job.getVmId())+"', ";
-    query+="vmIp='"+mdatabaseInstance->escapeData(job.getVmIp())+"', ";
-    query+="relatedSteps='"+mdatabaseInstance->escapeData(job.getRelatedSteps())+"'";
-    query+=" WHERE jobid='"+mdatabaseInstance->escapeData(job.getJobId())+"';";
+    mdatabaseInstance->process(getSubmitRecordQuery(job));
+    logJobSubmission(job);
+  } else {
+    throw TMSVishnuException(ERRCODE_INVALID_PARAM, "unknown batch action");
+  }
+}
 
-    mdatabaseInstance->process(query);
 
-    // logging
-    if (job.getSubmitError().empty()) {
-      LOG(boost::str(boost::format("[INFO] job submitted: %1%. User: %2%. Owner: %3%")
-                     % job.getJobId()
-                     % muserSessionInfo.userid
-                     % muserSessionInfo.user_aclogin), LogInfo);
-    } else {
-      LOG((boost::str(boost::format("[WARN] submission error: %1% [%2%]")
-                      % job.getJobId()
-                      % job.getSubmitError())), LogWarning);
-    }
+/**
+ * \brief Build the request saving a submitted job into the database
+ * @param job The submitted job, its output and error paths get the
+ * machine name if they lack it
+ * @return the request
+ */
+std::string
+JobServer::getSubmitRecordQuery(TMS_Data::Job& job)
+{
+  // Append the machine name to the error and output path if necessary
+  size_t pos = job.getOutputPath().find(":");
+  std::string prefixOutputPath = (pos == std::string::npos)? muserSessionInfo.machine_name+":" : "";
+  job.setOutputPath(prefixOutputPath+job.getOutputPath());
+  pos = job.getErrorPath().find(":");
+  std::string prefixErrorPath = (pos == std::string::npos)? muserSessionInfo.machine_name+":" : "";
+  job.setErrorPath(prefixErrorPath+job.getErrorPath());
+
+  // Update the database with the result
+  std::string query = "UPDATE job set ";
+  query+="vsession_numsessionid="+vishnu::convertToString(muserSessionInfo.num_session)+", ";
+  query+="job_owner_id="+vishnu::convertToString(muserSessionInfo.num_user)+", ";
+  query+="owner='"+mdatabaseInstance->escapeData(job.getOwner())+"', ";
+  query+="submitMachineId='"+mdatabaseInstance->escapeData(mmachineId)+"', ";
+  query+="submitMachineName='"+mdatabaseInstance->escapeData(muserSessionInfo.machine_name)+"', ";
+  query+="batchJobId='"+mdatabaseInstance->escapeData(job.getBatchJobId())+"', ";
+  query+="batchType="+vishnu::convertToString(mbatchType)+", ";
+  query+="jobName='"+mdatabaseInstance->escapeData(job.getJobName())+"', ";
+  query+="jobPath='"+mdatabaseInstance->escapeData(job.getJobPath())+"', ";
+  query+="outputPath='"+mdatabaseInstance->escapeData(job.getOutputPath())+"',";
+  query+="errorPath='"+mdatabaseInstance->escapeData(job.getErrorPath())+"',";
+  query+="scriptContent='job', ";
+  query+="jobPrio="+vishnu::convertToString(job.getJobPrio())+", ";
+  query+="nbCpus="+vishnu::convertToString(job.getNbCpus())+", ";
+  query+="jobWorkingDir='"+mdatabaseInstance->escapeData(job.getJobWorkingDir())+"', ";
+  query+="status="+vishnu::convertToString(job.getStatus())+", ";
+  query+="submitDate=CURRENT_TIMESTAMP, ";
+  query+="jobQueue='"+mdatabaseInstance->escapeData(job.getJobQueue())+"', ";
+  query+="wallClockLimit="+vishnu::convertToString(job.getWallClockLimit())+", ";
+  query+="groupName='"+mdatabaseInstance->escapeData(job.getGroupName())+"',";
+  query+="jobDescription='"+mdatabaseInstance->escapeData(job.getJobDescription())+"', ";
+  query+="memLimit="+vishnu::convertToString(job.getMemLimit())+", ";
+  query+="nbNodes="+vishnu::convertToString(job.getNbNodes())+", ";
+  query+="nbNodesAndCpuPerNode='"+mdatabaseInstance->escapeData(job.getNbNodesAndCpuPerNode())+"', ";
+  query+="outputDir='"+mdatabaseInstance->escapeData(job.getOutputDir())+"', ";
+  query+= job.getWorkId()? "workId="+vishnu::convertToString(job.getWorkId())+", " : "";
+  query+="vmId='"+mdatabaseInstance->escapeData(job.getVmId())+"', ";
+  query+="vmIp='"+mdatabaseInstance->escapeData(job.getVmIp())+"', ";
+  query+="relatedSteps='"+mdatabaseInstance->escapeData(job.getRelatedSteps())+"'";
+  query+=" WHERE jobid='"+mdatabaseInstance->escapeData(job.getJobId())+"'";
+
+  return query;
+}
+
+/**
+ * \brief Log the submission of a job
+ * @param job The submitted job
+ */
+void
+JobServer::logJobSubmission(const TMS_Data::Job& job)
+{
+  if (job.getSubmitError().empty()) {
+    LOG(boost::str(boost::format("[INFO] job submitted: %1%. User: %2%. Owner: %3%")
+                   % job.getJobId()
+                   % muserSessionInfo.userid
+                   % muserSessionInfo.user_aclogin), LogInfo);
   } else {
-    throw TMSVishnuException(ERRCODE_INVALID_PARAM, "unknown batch action");
+    LOG((boost::str(boost::format("[WARN] submission error: %1% [%2%]")
+                    % job.getJobId()
+                    % job.getSubmitError())), LogWarning);
   }
 }
 
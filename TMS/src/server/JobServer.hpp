@@ -187,6 +187,22 @@ private:
   void
   updateJobRecordIntoDatabase(int action, TMS_Data::Job& job);
 
+  /**
+   * \brief Build the request saving a submitted job into the database
+   * @param job The submitted job, its output and error paths get the
+   * machine name if they lack it
+   * @return the request
+   */
+  std::string
+  getSubmitRecordQuery(TMS_Data::Job& job);
+
+  /**
+   * \brief Log the submission of a job
+   * @param job The submitted job
+   */
+  void
+  logJobSubmission(const TMS_Data::Job& job);
+
   /**
    * \brief Function to set the Working Directory
    * \param scriptContent The script content
@@ -315,6 +331,11 @@ private:
    */
   int mstandaloneSed;
 
+  /**
+   * \brief The directory where the end of the POSIX jobs is reported
+   */
+  std::string mjobEventDir;
+
   /**
    * \brief Holds the level of debug
    */
@@ -6,6 +6,7 @@
  */
 
 
+#include <map>
 #include <vector>
 #include <sstream>
 #include <algorithm>
@@ -468,6 +469,46 @@ LSFServer::getJobState(const std::string& jobId) {
   return state;
 }
 
+/**
+ * \brief Function to get the status of several jobs
+ * \param jobIds the identifiers of the jobs
+ * \return the states in the order of jobIds, -1 if LSF is unavailable
+ */
+std::vector<int>
+LSFServer::getJobStates(const std::vector<std::string>& jobIds) {
+
+  std::vector<int> states(jobIds.size(), -1);
+
+  if (lsb_init(NULL) < 0) {
+    return states;
+  }
+
+  // the jobs of all the users, the recently finished ones included, as
+  // bjobs -a -u all would list them
+  int numJobs = lsb_openjobinfo(0, NULL, (char*)"all", NULL, NULL, ALL_JOB);
+  if (numJobs < 0 && lsberrno != LSBE_NO_JOB) {
+    lsb_closejobinfo();
+    return states;
+  }
+  std::map<LS_LONG_INT, int> snapshot;
+  int more;
+  for (int i = 0; i < numJobs; ++i) {
+    struct jobInfoEnt *jobInfo = lsb_readjobinfo(&more);
+    if (jobInfo == NULL) {
+      break;
+    }
+    snapshot[jobInfo->jobId] = convertLSFStateToVishnuState(jobInfo->status);
+  }
+  lsb_closejobinfo();
+
+  for (size_t i = 0; i < jobIds.size(); ++i) {
+    std::map<LS_LONG_INT, int>::const_iterator it = snapshot.find(convertToLSFJobId(jobIds[i]));
+    // as in getJobState, a job LSF does not know anymore is terminated
+    states[i] = (it != snapshot.end()) ? it->second : vishnu::STATE_COMPLETED;
+  }
+  return states;
+}
+
 /**
  * \brief Function to get the start time of the job
  * \param jobId the identifier of the job
@@ -37,7 +37,8 @@ public:
     : QueryServer<TMS_Data::ListJobsOptions, TMS_Data::ListJobs>() {
     mcommandName = "vishnu_list_jobs";
     UserSessionInfo userSessionInfo;
-    vishnu::validateAuthKey(authkey, mdatabaseInstance, userSessionInfo);
+    // the session is checked on the primary, a replica may lag behind
+    vishnu::validateAuthKey(authkey, DbFactory().getDatabaseInstance(), userSessionInfo);
   }
 
   /**
@@ -158,7 +159,7 @@ public:
       BatchFactory factory;
       BatchType batchType  = ServerXMS::getInstance()->getBatchType();
       std::string batchVersion  = ServerXMS::getInstance()->getBatchVersion();
-      boost::scoped_ptr<BatchServer> batchServer(factory.getBatchServerInstance(batchType, batchVersion));
+      boost::shared_ptr<BatchServer> batchServer = factory.getBatchServerInstance(batchType, batchVersion);
       batchServer->listQueues(options->getQueue()); //raise an exception if options->getQueue does not exist
 
       addOptionRequest("jobQueue", options->getQueue(), sqlRequest);
@@ -189,67 +190,55 @@ public:
       sqlQuery.append(" and job.submitMachineId='"+mdatabaseInstance->escapeData(options->getMachineId())+"'");
     }
 
-    std::vector<std::string>::iterator ii;
-    std::vector<std::string> results;
-
     TMS_Data::TMS_DataFactory_ptr ecoreFactory = TMS_Data::TMS_DataFactory::_instance();
     mlistObject = ecoreFactory->createListJobs();
 
     processOptions(options, sqlQuery);
     sqlQuery.append(" order by submitDate");
 
-    boost::scoped_ptr<DatabaseResult> ListOfJobs (mdatabaseInstance->getResult(sqlQuery));
+    // the rows are read as they come, the jobs being the only copy
+    boost::scoped_ptr<DatabaseCursor> cursor(mdatabaseInstance->getCursor(sqlQuery));
     long nbRunningJobs = 0;
     long nbWaitingJobs = 0;
-    std::string batchJobId;
-    std::vector<std::string> ignoredIds;
-
-    int nbJobs = ListOfJobs->getNbTuples();
-    if (nbJobs != 0) {
-
-      for (size_t i = 0; i < nbJobs; ++i) {
-        results.clear();
-        results = ListOfJobs->get(i);
-        ii = results.begin();
-
-        TMS_Data::Job_ptr job = ecoreFactory->createJob();
 
-        job->setSessionId(*ii);
-        job->setSubmitMachineId(*(++ii));
-        job->setSubmitMachineName(*(++ii));
-        job->setJobId(*(++ii));
-        job->setJobName(*(++ii));
-        job->setWorkId(vishnu::convertToLong(*(++ii)));
-        job->setJobPath(*(++ii));
-        job->setOutputPath(*(++ii));
-        job->setErrorPath(*(++ii));
-        job->setJobPrio(vishnu::convertToInt(*(++ii)));
-        job->setNbCpus(vishnu::convertToInt(*(++ii)));
-        job->setJobWorkingDir(*(++ii));
-        job->setStatus(vishnu::convertToInt(*(++ii)));
-
-        if (job->getStatus() == vishnu::STATE_RUNNING) {
-          nbRunningJobs++;
-        } else if(job->getStatus() >= vishnu::STATE_SUBMITTED
-                  && job->getStatus() <= vishnu::STATE_WAITING) {
-          nbWaitingJobs++;
-        }
-        job->setSubmitDate( vishnu::string_to_time_t(*(++ii)) );
-        job->setEndDate( vishnu::string_to_time_t(*(++ii)) );
-        job->setOwner(*(++ii));
-        job->setJobQueue(*(++ii));
-        job->setWallClockLimit(vishnu::convertToInt(*(++ii)));
-        job->setGroupName(*(++ii));
-        job->setJobDescription(*(++ii));
-        job->setMemLimit(vishnu::convertToInt(*(++ii)));
-        job->setNbNodes(vishnu::convertToInt(*(++ii)));
-        job->setNbNodesAndCpuPerNode(*(++ii));
-        batchJobId = *(++ii);
-        job->setBatchJobId(batchJobId);
-        ignoredIds.push_back(batchJobId);
-        job->setUserId(*(++ii));
-        mlistObject->getJobs().push_back(job);
+    while (cursor->next()) {
+      TMS_Data::Job_ptr job = ecoreFactory->createJob();
+
+      job->setSessionId(cursor->getString(0));
+      job->setSubmitMachineId(cursor->getString(1));
+      job->setSubmitMachineName(cursor->getString(2));
+      job->setJobId(cursor->getString(3));
+      job->setJobName(cursor->getString(4));
+      job->setWorkId(cursor->getInt64(5));
+      job->setJobPath(cursor->getString(6));
+      job->setOutputPath(cursor->getString(7));
+      job->setErrorPath(cursor->getString(8));
+      job->setJobPrio(cursor->getInt(9));
+      job->setNbCpus(cursor->getInt(10));
+      job->setJobWorkingDir(cursor->getString(11));
+      job->setStatus(cursor->getInt(12));
+
+      if (job->getStatus() == vishnu::STATE_RUNNING) {
+        nbRunningJobs++;
+      } else if(job->getStatus() >= vishnu::STATE_SUBMITTED
+                && job->getStatus() <= vishnu::STATE_WAITING) {
+        nbWaitingJobs++;
       }
+      job->setSubmitDate(cursor->getTime(13));
+      job->setEndDate(cursor->getTime(14));
+      job->setOwner(cursor->getString(15));
+      job->setJobQueue(cursor->getString(16));
+      job->setWallClockLimit(cursor->getInt(17));
+      job->setGroupName(cursor->getString(18));
+      job->setJobDescription(cursor->getString(19));
+      job->setMemLimit(cursor->getInt(20));
+      job->setNbNodes(cursor->getInt(21));
+      job->setNbNodesAndCpuPerNode(cursor->getString(22));
+      job->setBatchJobId(cursor->getString(23));
+      job->setUserId(cursor->getString(24));
+      mlistObject->getJobs().push_back(job);
+    }
+    if (mlistObject->getJobs().size() != 0) {
       mlistObject->setNbJobs(mlistObject->getJobs().size());
       mlistObject->setNbRunningJobs(nbRunningJobs);
       mlistObject->setNbWaitingJobs(nbWaitingJobs);
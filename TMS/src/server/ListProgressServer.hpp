@@ -38,7 +38,8 @@ public:
     mcommandName("vishnu_get_job_progress")
   {
     UserSessionInfo userSessionInfo;
-    vishnu::validateAuthKey(authkey, mdatabaseInstance, userSessionInfo);
+    // the session is checked on the primary, a replica may lag behind
+    vishnu::validateAuthKey(authkey, DbFactory().getDatabaseInstance(), userSessionInfo);
   }
 
   /**
@@ -105,8 +106,8 @@ public:
         BatchFactory factory;
         BatchType batchType  = ServerXMS::getInstance()->getBatchType();
         std::string batchVersion  = ServerXMS::getInstance()->getBatchVersion();
-        boost::scoped_ptr<BatchServer> batchServer(factory.getBatchServerInstance(batchType,
-                                                                                  batchVersion));
+        boost::shared_ptr<BatchServer> batchServer = factory.getBatchServerInstance(batchType,
+                                                                                    batchVersion);
 
         startTime = batchServer->getJobStartTime(batchJobId);
         if(startTime!=0) {
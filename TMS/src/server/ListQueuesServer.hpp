@@ -8,6 +8,7 @@
 #define _LIST_QUEUES_H_SERVER_
 
 #include <string>
+#include <boost/shared_ptr.hpp>
 
 #include "SessionServer.hpp"
 #include "ListQueues.hpp"
@@ -63,7 +64,7 @@ public:
   /**
   * \brief The BatchServer instance
   */
-  BatchServer* mbatchServer;
+  boost::shared_ptr<BatchServer> mbatchServer;
 };
 
 #endif
@@ -6,6 +6,8 @@
  */
 
 
+#include <cstring>
+#include <map>
 #include <vector>
 #include <sstream>
 
@@ -419,6 +421,72 @@ PbsProServer::getJobState(const std::string& jobId) {
 return state;
 }
 
+/**
+ * \brief Function to get the status of several jobs
+ * \param jobIds the identifiers of the jobs
+ * \return the states in the order of jobIds, -1 if the server is unavailable
+ */
+std::vector<int>
+PbsProServer::getJobStates(const std::vector<std::string>& jobIds) {
+
+  std::vector<int> states(jobIds.size(), -1);
+
+  // the jobs are grouped by server, a malformed id is left unknown
+  std::map<std::string, std::vector<size_t> > jobsByServer;
+  char tmsJobIdOut[PBS_MAXSERVERNAME + PBS_MAXPORTNUM + 2];
+  for (size_t i = 0; i < jobIds.size(); ++i) {
+    std::vector<char> jobId(jobIds[i].begin(), jobIds[i].end());
+    jobId.push_back('\0');
+    if (get_server(&jobId[0], tmsJobIdOut, serverOut) == 0) {
+      jobsByServer[serverOut].push_back(i);
+    }
+  }
+
+  // a single pbs_statjob per server, asking for the state only
+  struct attrl stateAttr;
+  memset(&stateAttr, 0, sizeof(stateAttr));
+  stateAttr.name = const_cast<char*>(ATTR_state);
+
+  std::map<std::string, std::vector<size_t> >::const_iterator server;
+  for (server = jobsByServer.begin(); server != jobsByServer.end(); ++server) {
+    strncpy(serverOut, server->first.c_str(), sizeof(serverOut) - 1);
+    serverOut[sizeof(serverOut) - 1] = '\0';
+    int connect = cnt2server(serverOut);
+    if (connect <= 0) {
+      continue;
+    }
+    struct batch_status *p_status = pbs_statjob(connect, NULL, &stateAttr, NULL);
+    int statErrno = pbs_errno;
+    pbs_disconnect(connect);
+    if (p_status == NULL && statErrno != PBSE_NONE) {
+      continue;
+    }
+
+    // the server part of the ids may differ (short or full host name), the
+    // sequence number identifies the job on its server
+    std::map<std::string, int> snapshot;
+    for (struct batch_status *p = p_status; p != NULL; p = p->next) {
+      std::string name = p->name;
+      for (struct attrl *a = p->attribs; a != NULL; a = a->next) {
+        if (!strcmp(a->name, ATTR_state)) {
+          snapshot[name.substr(0, name.find('.'))] = convertPbsProStateToVishnuState(std::string(a->value));
+          break;
+        }
+      }
+    }
+    pbs_statfree(p_status);
+
+    std::vector<size_t>::const_iterator job;
+    for (job = server->second.begin(); job != server->second.end(); ++job) {
+      const std::string& jobId = jobIds[*job];
+      std::map<std::string, int>::const_iterator it = snapshot.find(jobId.substr(0, jobId.find('.')));
+      // as in getJobState, a job the server does not know anymore is terminated
+      states[*job] = (it != snapshot.end()) ? it->second : vishnu::STATE_COMPLETED;
+    }
+  }
+  return states;
+}
+
 /**
  * \brief Function to get the start time of the job
  * \param jobId the identifier of the job
@@ -1115,6 +1183,7 @@ PbsProServer::convertPbsProMem(const std::string& memStr) {
 void PbsProServer::fillListOfJobs(TMS_Data::ListJobs*& listOfJobs,
                                   const std::vector<string>& ignoredIds) {
 
+   serverOut[0] = '\0'; // the default server, the instance may have served another job
    int connect = cnt2server(serverOut);
 
    if (connect <= 0)
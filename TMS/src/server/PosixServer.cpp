@@ -5,6 +5,7 @@
 
 #include <iostream>
 #include <unistd.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include <boost/lexical_cast.hpp>
@@ -39,6 +40,11 @@ PosixServer::submit(const std::string& scriptPath,
   strncpy(op.outPutPath, options.getOutputPath().c_str(), sizeof(op.outPutPath)-1);
   strncpy(op.errorPath, options.getErrorPath().c_str(), sizeof(op.errorPath)-1);
   strncpy(op.workDir, options.getWorkingDir().c_str(), sizeof(op.workDir)-1);
+  // set by the slave or the server, sent with each job to the daemon
+  const char* eventDir = getenv(JOB_EVENT_DIR_ENV.c_str());
+  if (eventDir != NULL) {
+    strncpy(op.eventDir, eventDir, sizeof(op.eventDir)-1);
+  }
 
   switch(fork()) {
   case -1:
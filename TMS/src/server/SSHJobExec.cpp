@@ -49,16 +49,19 @@ const std::string DEFAULT_SSH_OPTIONS =
  * \param batchVersion the version of the batch scheduler
  * \param jobSerialized the job serialized
  * \param submitOptionsSerialized the job options serialized
+ * \param jobEventDir the directory where tms-posix reports the end of the jobs
  */
 SSHJobExec::SSHJobExec(const std::string& user,
                        const std::string& hostname,
                        const BatchType& batchType,
                        const std::string& batchVersion,
                        const std::string& jobSerialized,
-                       const std::string& submitOptionsSerialized):
+                       const std::string& submitOptionsSerialized,
+                       const std::string& jobEventDir):
   muser(user), mhostname(hostname), mbatchType(batchType),
   mjobSerialized(jobSerialized),
-  msubmitOptionsSerialized(submitOptionsSerialized)
+  msubmitOptionsSerialized(submitOptionsSerialized),
+  mjobEventDir(jobEventDir)
 {
   if (batchVersion.empty()) {
     mbatchVersion = "n/a";  // batchVersion MUST be not empty otherwise the call to the slave will failed
@@ -115,6 +118,10 @@ SSHJobExec::sshexec(const std::string& actionName,
                                   % jobUpdateSerializedPath
                                   % submitOptionsSerializedPath
                                   % script_path);
+    // the environment of the server does not reach the remote tms-posix
+    if (mbatchType == POSIX && ! mjobEventDir.empty()) {
+      detailsForSubmit += " " + mjobEventDir;
+    }
   }
 
   // For traditional batch scheduler we need to submit the job through ssh
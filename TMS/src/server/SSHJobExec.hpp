@@ -29,13 +29,15 @@ public:
      * \param batchVersion the version of the batch scheduler
      * \param jobSerialized the job serialized
      * \param submitOptionsSerialized the job options serialized
+     * \param jobEventDir the directory where tms-posix reports the end of the jobs
      */
   SSHJobExec(const std::string& user,
              const std::string& hostname,
              const BatchType& batchType = UNDEFINED,
              const std::string& batchVersion = "-",
              const std::string& jobSerialized = "",
-             const std::string& submitOptionsSerialized="");
+             const std::string& submitOptionsSerialized="",
+             const std::string& jobEventDir="");
 
   /**
      * \brief Destructor
@@ -190,6 +192,11 @@ private:
      */
   std::string mhostname;
 
+  /**
+     * \brief The directory where tms-posix reports the end of the jobs
+     */
+  std::string mjobEventDir;
+
   /**
      * \brief Holds the level of debug
      */
@@ -6,6 +6,7 @@
  */
 
 
+#include <map>
 #include <vector>
 #include <sstream>
 #include <algorithm>
@@ -13,6 +14,7 @@
 #include <iomanip>
 #include <boost/algorithm/string.hpp>
 #include <boost/format.hpp>
+#include <boost/lexical_cast.hpp>
 #include <unistd.h>
 #include <pwd.h>
 #include <grp.h>
@@ -502,6 +504,46 @@ SlurmServer::getJobState(const std::string& jobId) {
   return state;
 }
 
+/**
+ * \brief Function to get the status of several jobs
+ * \param jobIds the identifiers of the jobs
+ * \return the states in the order of jobIds, -1 if the controller is
+ * unavailable or the job is not known to it
+ */
+std::vector<int>
+SlurmServer::getJobStates(const std::vector<std::string>& jobIds) {
+
+  std::vector<int> states(jobIds.size(), -1);
+
+  // a single RPC to slurmctld for all the jobs
+  job_info_msg_t * job_buffer_ptr = NULL;
+  if (slurm_load_jobs((time_t) NULL, &job_buffer_ptr, SHOW_ALL) != 0 || ! job_buffer_ptr) {
+    return states;
+  }
+
+  std::map<uint32_t, int> snapshot;
+  for (uint32_t i = 0; i < job_buffer_ptr->record_count; i++) {
+    snapshot[job_buffer_ptr->job_array[i].job_id] =
+      convertSlurmStateToVishnuState(job_buffer_ptr->job_array[i].job_state);
+  }
+  slurm_free_job_info_msg(job_buffer_ptr);
+
+  for (size_t i = 0; i < jobIds.size(); ++i) {
+    try {
+      std::map<uint32_t, int>::const_iterator it = snapshot.find(convertToSlurmJobId(jobIds[i]));
+      // as with getJobState, a job missing from the controller is left
+      // unknown: it may be purged after its end, or submitted after the
+      // snapshot, and its outcome can't be told
+      if (it != snapshot.end()) {
+        states[i] = it->second;
+      }
+    } catch (const boost::bad_lexical_cast&) {
+      // not a Slurm id, left unknown
+    }
+  }
+  return states;
+}
+
 /**
  * \brief Function to get the start time of the job
  * \param jobId the identifier of the job
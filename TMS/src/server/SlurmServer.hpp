@@ -54,6 +54,16 @@ class SlurmServer : public BatchServer
     int
     getJobState(const std::string& jobId);
 
+    /**
+     * \brief Function to get the status of several jobs from a single
+     * snapshot of the jobs known by the scheduler
+     * \param jobIds the identifiers of the jobs
+     * \return the states in the order of jobIds, -1 if the scheduler is
+     * unavailable
+     */
+    std::vector<int>
+    getJobStates(const std::vector<std::string>& jobIds);
+
     /**
      * \brief Function to get the start time of the job
      * \param jobId the identifier of the job
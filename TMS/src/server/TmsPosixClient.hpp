@@ -91,6 +91,10 @@ struct trameSubmit {
  * \brief the Job name
  */
   char jobName[256];
+/**
+ * \brief the directory where the end of the job is reported, empty if none
+ */
+  char eventDir[256];
 };
 
 /**
@@ -191,6 +195,10 @@ struct trameJob {
  * \brief the scriptPath
  */
   char scriptPath[255];
+/**
+ * \brief the directory where the end of the job is reported, empty if none
+ */
+  char eventDir[256];
 };
 
 /**
@@ -57,6 +57,21 @@ static char homeDir[255];
  * Function SignalHandler for SIGCHLD
  */
 
+/*
+ * Function reporting the end of a job to the VISHNU monitor
+ */
+static void
+notifyJobEnd(const struct trameJob& job) {
+  if (job.eventDir[0] == '\0') {
+    return;
+  }
+  std::string eventFile = std::string(job.eventDir) + "/" + job.jobId;
+  int fd = open(eventFile.c_str(), O_CREAT|O_WRONLY, S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH);
+  if (fd >= 0) {
+    close(fd);
+  }
+}
+
 static bool isDead(const struct trameJob& test) {
   return (test.state == TERMINATED);
 }
@@ -88,6 +103,7 @@ checkJobs() {
       if (kill(it->pid, 0) == -1) {
         it->state = TERMINATED;
         unlink(it->scriptPath);
+        notifyJobEnd(*it);
       }
     }
   }
@@ -97,6 +113,7 @@ checkJobs() {
     if ( kill(it->pid,0) == -1 ) {
       it->state = TERMINATED;
       unlink(it->scriptPath);
+      notifyJobEnd(*it);
       checkIn5s = true;
     }
   }
@@ -500,6 +517,9 @@ requestSubmit(struct Request* req, struct Response* ret) {
   sigprocmask(SIG_SETMASK, &emptyMask, NULL);
 
   strncpy(currentState.scriptPath,fileScript.c_str(),sizeof(currentState.scriptPath));
+  // given by each submit, the daemon may outlive the slave that launched it
+  strncpy(currentState.eventDir, req->data.submit.eventDir, sizeof(currentState.eventDir)-1);
+  currentState.eventDir[sizeof(currentState.eventDir)-1] = '\0';
   Board.push_back(currentState);
 
   AlarmSig = 1;
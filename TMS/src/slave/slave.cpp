@@ -42,7 +42,7 @@ using namespace vishnu;
 void usage(char* cmd) {
   cerr << "Usage: " << cmd << " COMMAND_TYPE[SUBMIT] <BatchType> <BatchVersion>"
        << " <JobSerializedPath> <SlaveErrorPath> <JobUpdatedSerializedPath>"
-       << " <SubmitOptionsSerializedPath> <job_script_path>\n"
+       << " <SubmitOptionsSerializedPath> <job_script_path> [<JobEventDir>]\n"
        << "\t\t\t\t\t" << " or\n"
        << "Usage: " << cmd << " COMMAND_TYPE[CANCEL] <BatchType> <BatchVersion>"
        << " <JobSerializedPath> <SlaveErrorPath>\n";
@@ -85,6 +85,10 @@ main(int argc, char* argv[]) {
     slaveJobFile = argv[6];
     optionsPath = argv[7];
     jobScriptPath = argv[8];
+    // tms-posix reports there the end of the job
+    if (argc > 9) {
+      setenv(JOB_EVENT_DIR_ENV.c_str(), argv[9], 1);
+    }
   }
 
   if(batchType == UNDEFINED) {
@@ -94,7 +98,7 @@ main(int argc, char* argv[]) {
     throw UMSVishnuException(ERRCODE_INVALID_PARAM, msg);
   }
 
-  BatchServer* batchServer;
+  boost::shared_ptr<BatchServer> batchServer;
   try {
     //To create batchServer Factory
     BatchFactory factory;
@@ -144,6 +148,5 @@ main(int argc, char* argv[]) {
     vishnu::saveInFile(slaveErrorPath, e.what());
     ret = EXIT_FAILURE;
   }
-  delete batchServer;
   return ret;
 }
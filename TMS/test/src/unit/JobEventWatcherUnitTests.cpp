@@ -0,0 +1,144 @@
+#include <boost/test/unit_test.hpp>
+#include <string>
+#include <fstream>
+#include <boost/filesystem.hpp>
+#include "JobEventWatcher.hpp"
+
+namespace bfs = boost::filesystem;
+
+/**
+ * \brief A temporary accounting directory, removed at the end of the test
+ */
+struct AccountingFixture {
+  AccountingFixture()
+    : dir(bfs::temp_directory_path() / bfs::unique_path("vishnu-accounting-%%%%%%")) {
+    bfs::create_directory(dir);
+  }
+
+  ~AccountingFixture() {
+    boost::system::error_code ec;
+    bfs::remove_all(dir, ec);
+  }
+
+  void
+  append(const std::string& log, const std::string& data) {
+    std::ofstream file((dir / log).string().c_str(), std::ios::app);
+    file << data;
+  }
+
+  void
+  truncate(const std::string& log, const std::string& data) {
+    std::ofstream file((dir / log).string().c_str(), std::ios::trunc);
+    file << data;
+  }
+
+  bfs::path dir;
+};
+
+static const std::string START = "10/18/2026 10:00:00;S;12.server;user=vishnu\n";
+static const std::string END = "10/18/2026 10:05:00;E;12.server;user=vishnu Exit_status=0\n";
+static const std::string QUEUED = "10/18/2026 10:00:00;Q;13.server;queue=batch\n";
+
+BOOST_AUTO_TEST_SUITE( JobEventWatcher_unit_tests )
+
+BOOST_AUTO_TEST_CASE( test_isStateRecord_n )
+{
+  BOOST_CHECK(JobEventWatcher::isStateRecord("10/18/2026 10:00:00;S;12.server;user=vishnu"));
+  BOOST_CHECK(JobEventWatcher::isStateRecord("10/18/2026 10:00:00;E;12.server;Exit_status=0"));
+  BOOST_CHECK(JobEventWatcher::isStateRecord("10/18/2026 10:00:00;D;12.server;requestor=root"));
+  BOOST_CHECK(JobEventWatcher::isStateRecord("10/18/2026 10:00:00;A;12.server;"));
+  BOOST_CHECK(JobEventWatcher::isStateRecord("10/18/2026 10:00:00;R;12.server;"));
+  BOOST_CHECK(! JobEventWatcher::isStateRecord("10/18/2026 10:00:00;Q;12.server;queue=batch"));
+  BOOST_CHECK(! JobEventWatcher::isStateRecord("10/18/2026 10:00:00;L;license;"));
+}
+
+BOOST_AUTO_TEST_CASE( test_isStateRecord_b )
+{
+  BOOST_CHECK(! JobEventWatcher::isStateRecord(""));
+  BOOST_CHECK(! JobEventWatcher::isStateRecord("no separator"));
+  BOOST_CHECK(! JobEventWatcher::isStateRecord("10/18/2026 10:00:00;E"));
+  BOOST_CHECK(! JobEventWatcher::isStateRecord("10/18/2026 10:00:00;E12.server"));
+  BOOST_CHECK(! JobEventWatcher::isStateRecord("10/18/2026 10:00:00;EQ;12.server;"));
+}
+
+BOOST_FIXTURE_TEST_CASE( test_readAccounting_skip_existing_n, AccountingFixture )
+{
+  append("20261018", START + END);
+  JobEventWatcher watcher;
+  BOOST_REQUIRE(watcher.watchAccountingDirectory(dir.string()));
+  BOOST_REQUIRE(watcher.isWatching());
+
+  // the records written before the watch are not reported again
+  append("20261018", QUEUED);
+  BOOST_CHECK(! watcher.wait(1));
+
+  append("20261018", END);
+  BOOST_CHECK(watcher.wait(1));
+}
+
+BOOST_FIXTURE_TEST_CASE( test_readAccounting_offset_n, AccountingFixture )
+{
+  append("20261018", "");
+  JobEventWatcher watcher;
+  BOOST_REQUIRE(watcher.watchAccountingDirectory(dir.string()));
+
+  append("20261018", START);
+  BOOST_CHECK(watcher.wait(1));
+
+  // only the records added since the last read are considered
+  append("20261018", QUEUED);
+  BOOST_CHECK(! watcher.wait(1));
+
+  // nothing new, the watcher times out
+  BOOST_CHECK(! watcher.wait(0));
+}
+
+BOOST_FIXTURE_TEST_CASE( test_readAccounting_partial_line_n, AccountingFixture )
+{
+  append("20261018", "");
+  JobEventWatcher watcher;
+  BOOST_REQUIRE(watcher.watchAccountingDirectory(dir.string()));
+
+  // the record is only read once terminated by a newline
+  append("20261018", END.substr(0, 20));
+  BOOST_CHECK(! watcher.wait(1));
+
+  append("20261018", END.substr(20, 10));
+  BOOST_CHECK(! watcher.wait(1));
+
+  append("20261018", END.substr(30));
+  BOOST_CHECK(watcher.wait(1));
+
+  append("20261018", QUEUED);
+  BOOST_CHECK(! watcher.wait(1));
+}
+
+BOOST_FIXTURE_TEST_CASE( test_readAccounting_truncated_b, AccountingFixture )
+{
+  append("20261018", QUEUED + QUEUED + QUEUED);
+  JobEventWatcher watcher;
+  BOOST_REQUIRE(watcher.watchAccountingDirectory(dir.string()));
+
+  // shorter than the position read, the log is read from its start
+  truncate("20261018", END);
+  BOOST_CHECK(watcher.wait(1));
+}
+
+BOOST_FIXTURE_TEST_CASE( test_readAccounting_new_log_n, AccountingFixture )
+{
+  append("20261018", QUEUED);
+  JobEventWatcher watcher;
+  BOOST_REQUIRE(watcher.watchAccountingDirectory(dir.string()));
+
+  // the log of the next day is read from its start
+  append("20261019", START);
+  BOOST_CHECK(watcher.wait(1));
+
+  // the former log is no longer followed
+  append("20261018", END);
+  BOOST_CHECK(! watcher.wait(1));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+// THE END
@@ -0,0 +1,206 @@
+/**
+ * \file CommandJournal.cpp
+ * \brief This file implements the write-behind journal of the commands
+ * \author Haikel Guemar (haikel.guemar@sysfera.com)
+ */
+
+#include "CommandJournal.hpp"
+
+#include <algorithm>
+#include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/format.hpp>
+#include <boost/thread/locks.hpp>
+#include "Database.hpp"
+#include "DbFactory.hpp"
+#include "Logger.hpp"
+
+CommandJournal&
+CommandJournal::getInstance() {
+  static CommandJournal instance;
+  return instance;
+}
+
+CommandJournal::CommandJournal()
+  : mdelay(DEFAULT_COMMAND_JOURNAL_DELAY), mstopping(false) {}
+
+void
+CommandJournal::start(int delay) {
+  boost::lock_guard<boost::mutex> lock(mmutex);
+  if (delay <= 0 || mwriter) {
+    return;
+  }
+  mdelay = delay;
+  mstopping = false;
+  mwriter.reset(new boost::thread(boost::bind(&CommandJournal::run, this)));
+}
+
+void
+CommandJournal::stop() {
+  {
+    boost::lock_guard<boost::mutex> lock(mmutex);
+    if (!mwriter || mstopping) {
+      return;
+    }
+    mstopping = true;
+    mwakeup.notify_all();
+  }
+  mwriter->join();
+  {
+    boost::lock_guard<boost::mutex> lock(mmutex);
+    mwriter.reset();
+    mstopping = false;
+    mspace.notify_all();
+  }
+  flush();
+}
+
+bool
+CommandJournal::isStarted() {
+  boost::lock_guard<boost::mutex> lock(mmutex);
+  return mwriter && !mstopping;
+}
+
+void
+CommandJournal::record(const std::string& sessionKey,
+                       const std::string& cmdDescription,
+                       vishnu::CmdType cmdType,
+                       vishnu::CmdStatus cmdStatus,
+                       const std::string& newVishnuObjectID) {
+  Entry entry;
+  entry.sessionKey = sessionKey;
+  entry.description = cmdDescription;
+  entry.type = cmdType;
+  entry.status = cmdStatus;
+  entry.objectId = newVishnuObjectID;
+  entry.time = std::time(NULL);
+
+  bool stopped;
+  {
+    boost::unique_lock<boost::mutex> lock(mmutex);
+    // the callers wait for the writer rather than dropping commands
+    while (mentries.size() >= COMMAND_JOURNAL_MAX_SIZE && mwriter) {
+      mwakeup.notify_all();
+      mspace.wait(lock);
+    }
+    mentries.push_back(entry);
+    msessions.insert(sessionKey);
+    stopped = !mwriter;
+  }
+  // stopped meanwhile, nobody would write it
+  if (stopped) {
+    flush();
+  }
+}
+
+void
+CommandJournal::flush() {
+  write();
+}
+
+void
+CommandJournal::run() {
+  boost::unique_lock<boost::mutex> lock(mmutex);
+  while (!mstopping) {
+    mwakeup.timed_wait(lock, boost::posix_time::seconds(mdelay));
+    lock.unlock();
+    write();
+    lock.lock();
+  }
+}
+
+void
+CommandJournal::write() {
+  boost::lock_guard<boost::mutex> writeLock(mwriteMutex);
+
+  std::vector<Entry> entries;
+  std::set<std::string> sessions;
+  {
+    boost::lock_guard<boost::mutex> lock(mmutex);
+    entries.assign(mentries.begin(), mentries.end());
+    mentries.clear();
+    sessions.swap(msessions);
+    mspace.notify_all();
+  }
+  if (entries.empty() && sessions.empty()) {
+    return;
+  }
+
+  try {
+    Database* database = DbFactory().getDatabaseInstance();
+    time_t now = std::time(NULL);
+
+    std::set<std::string>::const_iterator it = sessions.begin();
+    while (it != sessions.end()) {
+      std::string keys;
+      for (size_t i = 0; i < COMMAND_JOURNAL_BATCH_SIZE && it != sessions.end(); ++i, ++it) {
+        if (!keys.empty()) {
+          keys += ",";
+        }
+        keys += "'" + database->escapeData(*it) + "'";
+      }
+      try {
+        database->process("UPDATE vsession SET lastconnect=CURRENT_TIMESTAMP"
+                          " WHERE sessionkey IN (" + keys + ")");
+      } catch (const std::exception& e) {
+        LOG(boost::str(boost::format("[WARNING] Cannot save the last connections: %1%")
+                       % e.what()), LogWarning);
+      }
+    }
+
+    for (size_t first = 0; first < entries.size(); first += COMMAND_JOURNAL_BATCH_SIZE) {
+      writeBatch(database, entries, first,
+                 std::min(first + COMMAND_JOURNAL_BATCH_SIZE, entries.size()), now);
+    }
+  } catch (const std::exception& e) {
+    LOG(boost::str(boost::format("[ERROR] Cannot record %1% commands: %2%")
+                   % entries.size() % e.what()), LogErr);
+  }
+}
+
+void
+CommandJournal::writeBatch(Database* database,
+                           const std::vector<Entry>& entries,
+                           size_t first, size_t last, time_t now) {
+  const std::string insert = "INSERT INTO command (vsession_numsessionid, starttime,"
+                             " endtime, description, ctype, status, vishnuobjectid) VALUES ";
+  std::string sqlCommand = insert;
+  for (size_t i = first; i < last; ++i) {
+    if (i != first) {
+      sqlCommand += ",";
+    }
+    sqlCommand += getValues(database, entries[i], now);
+  }
+
+  try {
+    database->process(sqlCommand);
+  } catch (const std::exception& e) {
+    // a single bad row must not lose the others
+    for (size_t i = first; i < last; ++i) {
+      try {
+        database->process(insert + getValues(database, entries[i], now));
+      } catch (const std::exception& rowError) {
+        LOG(boost::str(boost::format("[WARNING] Cannot record the command %1%: %2%")
+                       % entries[i].description % rowError.what()), LogWarning);
+      }
+    }
+  }
+}
+
+std::string
+CommandJournal::getValues(Database* database, const Entry& entry, time_t now) {
+  // the start time is taken from the database clock, like CURRENT_TIMESTAMP
+  long age = static_cast<long>(now - entry.time);
+  std::string time = "CURRENT_TIMESTAMP";
+  if (age > 0) {
+    time = boost::str(boost::format("(CURRENT_TIMESTAMP - INTERVAL '%1%' SECOND)") % age);
+  }
+  return boost::str(boost::format("((SELECT numsessionid FROM vsession WHERE sessionkey='%1%'),"
+                                  " %2%, %2%, '%3%', %4%, %5%, '%6%')")
+                    % database->escapeData(entry.sessionKey)
+                    % time
+                    % database->escapeData(entry.description)
+                    % entry.type
+                    % entry.status
+                    % database->escapeData(entry.objectId));
+}
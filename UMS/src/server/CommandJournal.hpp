@@ -0,0 +1,195 @@
+/**
+ * \file CommandJournal.hpp
+ * \brief This file presents the write-behind journal of the commands
+ * \author Haikel Guemar (haikel.guemar@sysfera.com)
+ */
+
+#ifndef _COMMANDJOURNAL_HPP_
+#define _COMMANDJOURNAL_HPP_
+
+#include <ctime>
+#include <deque>
+#include <set>
+#include <string>
+#include <vector>
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include "utilServer.hpp"
+
+class Database;
+
+/**
+ * \brief Default time in seconds the commands wait before being written
+ */
+const int DEFAULT_COMMAND_JOURNAL_DELAY = 1;
+
+/**
+ * \brief Number of queued commands above which the callers wait for the writer
+ */
+const size_t COMMAND_JOURNAL_MAX_SIZE = 10000;
+
+/**
+ * \brief Number of rows written by a single request
+ */
+const size_t COMMAND_JOURNAL_BATCH_SIZE = 200;
+
+/**
+ * \class CommandJournal
+ * \brief Records the commands and the last connection of the sessions in
+ * the background, so that SessionServer::finish does not write to the
+ * database on the path of each call.
+ *
+ * The commands are queued in memory and written every few seconds by a
+ * single thread, with multi-row INSERTs, and the sessions used meanwhile
+ * get a single lastconnect UPDATE. The start time of each command is kept
+ * relative to the database clock. The queue is written when the journal
+ * stops and on flush(), which is called when a session is closed or
+ * exported. Until start() is called, nothing is queued.
+ */
+class CommandJournal : public boost::noncopyable {
+public:
+  /**
+   * \brief Get the journal of the process
+   * \return the journal
+   */
+  static CommandJournal&
+  getInstance();
+
+  /**
+   * \brief Start the writer thread
+   * \param delay the time in seconds between two writes, 0 keeps the
+   * journal stopped
+   */
+  void
+  start(int delay);
+
+  /**
+   * \brief Write the queued commands and stop the writer thread
+   */
+  void
+  stop();
+
+  /**
+   * \brief Tell whether the commands are queued
+   * \return true if the writer thread runs
+   */
+  bool
+  isStarted();
+
+  /**
+   * \brief Queue a command and the connection of its session
+   * \param sessionKey the key of the session
+   * \param cmdDescription the description of the command
+   * \param cmdType the type of the command (UMS, TMS, FMS)
+   * \param cmdStatus the status of the command
+   * \param newVishnuObjectID the new vishnu object Id
+   */
+  void
+  record(const std::string& sessionKey,
+         const std::string& cmdDescription,
+         vishnu::CmdType cmdType,
+         vishnu::CmdStatus cmdStatus,
+         const std::string& newVishnuObjectID);
+
+  /**
+   * \brief Write the queued commands now
+   */
+  void
+  flush();
+
+private:
+  /**
+   * \brief Constructor
+   */
+  CommandJournal();
+
+  /**
+   * \struct Entry
+   * \brief A queued command
+   */
+  struct Entry {
+    std::string sessionKey;
+    std::string description;
+    int type;
+    int status;
+    std::string objectId;
+    time_t time;
+  };
+
+  /**
+   * \brief The loop of the writer thread
+   */
+  void
+  run();
+
+  /**
+   * \brief Write the queued commands, in the order they were recorded
+   */
+  void
+  write();
+
+  /**
+   * \brief Write a batch of commands with a single INSERT
+   * \param database the database
+   * \param entries the commands
+   * \param first the first command of the batch
+   * \param last the end of the batch
+   * \param now the time of the write
+   */
+  void
+  writeBatch(Database* database,
+             const std::vector<Entry>& entries,
+             size_t first, size_t last, time_t now);
+
+  /**
+   * \brief Build the values of a row of the command table
+   * \param database the database
+   * \param entry the command
+   * \param now the time of the write
+   * \return the values, between parenthesis
+   */
+  std::string
+  getValues(Database* database, const Entry& entry, time_t now);
+
+  /**
+   * \brief The commands waiting to be written
+   */
+  std::deque<Entry> mentries;
+  /**
+   * \brief The sessions whose last connection must be saved
+   */
+  std::set<std::string> msessions;
+  /**
+   * \brief Protects the queue
+   */
+  boost::mutex mmutex;
+  /**
+   * \brief Serializes the writes so that they keep the order of the queue
+   */
+  boost::mutex mwriteMutex;
+  /**
+   * \brief Wakes the writer up when stopping or when the queue is full
+   */
+  boost::condition_variable mwakeup;
+  /**
+   * \brief Wakes the callers up when the queue has been taken
+   */
+  boost::condition_variable mspace;
+  /**
+   * \brief The writer thread, NULL when stopped
+   */
+  boost::scoped_ptr<boost::thread> mwriter;
+  /**
+   * \brief The time in seconds between two writes
+   */
+  int mdelay;
+  /**
+   * \brief Set to stop the writer thread
+   */
+  bool mstopping;
+};
+
+#endif // _COMMANDJOURNAL_HPP_
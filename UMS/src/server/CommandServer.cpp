@@ -46,32 +46,25 @@ CommandServer::getCommand() {
 * \param cmdType The type of the command (UMS, TMS, FMS)
 * \param cmdStatus The status of the command
 * \param newVishnuObjectID the new vishnu object Id
-* \param startTime The start time of command
-* \param endTime The end time of command
 * \return raises an exception on error
 */
 int
 CommandServer::record(CmdType cmdType,
                       CmdStatus cmdStatus,
-                      std::string newVishnuObjectID,
-                      std::string startTime,
-                      std::string endTime) {
+                      std::string newVishnuObjectID) {
 
   std::string numsess = msessionServer.getAttribut("WHERE sessionkey='"+msessionServer.getData().getSessionKey()+"'", "numsessionid");
-  std::string sqlCmd = (boost::format("INSERT INTO command (vsession_numsessionid, starttime,"
-                                      "   endtime, description, ctype, status, vishnuobjectid)"
-                                      " VALUES (%1%,%2%,%3%,'%4%',%5%,%6%,'%7%');"
-                                      )
-                        %numsess
-                        %startTime
-                        %endTime
-                        %mdatabaseVishnu->escapeData(mcommand)
-                        %convertToString(cmdType)
-                        %convertToString(cmdStatus)
-                        %mdatabaseVishnu->escapeData(newVishnuObjectID)
-                        ).str();
-
-  mdatabaseVishnu->process(sqlCmd.c_str());
+  mdatabaseVishnu->prepare("recordCommand",
+                           "INSERT INTO command (vsession_numsessionid, starttime,"
+                           "   endtime, description, ctype, status, vishnuobjectid)"
+                           " VALUES (?,CURRENT_TIMESTAMP,CURRENT_TIMESTAMP,?,?,?,?)");
+  mdatabaseVishnu->processPrepared("recordCommand",
+                                   DbParams()
+                                   .add(numsess)
+                                   .add(mcommand)
+                                   .add(cmdType)
+                                   .add(cmdStatus)
+                                   .add(newVishnuObjectID));
   return 0;
 }
 
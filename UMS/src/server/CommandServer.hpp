@@ -40,16 +40,12 @@ public:
   * \param cmdType The type of the command (UMS, TMS, FMS)
   * \param cmdStatus The status of the command
   * \param newVishnuObjectID the new vishnu object Id
-  * \param startTime The start time of command
-  * \param endTime The end time of command
   * \return raises an exception on error
   */
   int
   record(vishnu::CmdType cmdType,
          vishnu::CmdStatus cmdStatus,
-         std::string newVishnuObjectID = " ",
-         std::string startTime = "CURRENT_TIMESTAMP",
-         std::string endTime = "CURRENT_TIMESTAMP");
+         std::string newVishnuObjectID = " ");
   /**
   * \brief Function to check if commands are running
   * \return true if commands are running else false
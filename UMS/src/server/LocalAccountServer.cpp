@@ -7,6 +7,7 @@
 
 #include "LocalAccountServer.hpp"
 #include "DbFactory.hpp"
+#include "SessionCache.hpp"
 #include <boost/format.hpp>
 
 /**
@@ -150,6 +151,7 @@ LocalAccountServer::update() {
                                              " WHERE machine_nummachineid=%2%"
                                              "   AND users_numuserid=%3%")%fields %numMachine %numUser).str();
             mdatabaseVishnu->process(sql);
+            SessionCache::getInstance().invalidateUser(mlocalAccount->getUserId());
           }
           mmutex.unlock();
         } else {
@@ -212,6 +214,7 @@ LocalAccountServer::deleteLocalAccount() {
                                            " AND users_numuserid=%3%"
                                            )%vishnu::STATUS_DELETED %numMachine %numUser).str();
           mdatabaseVishnu->process(sql);
+          SessionCache::getInstance().invalidateUser(mlocalAccount->getUserId());
         }//END if the local account exists
         else {
           UMSVishnuException e (ERRCODE_UNKNOWN_LOCAL_ACCOUNT);
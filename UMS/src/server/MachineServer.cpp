@@ -7,6 +7,7 @@
 
 #include "MachineServer.hpp"
 #include "DbFactory.hpp"
+#include "SessionCache.hpp"
 #include "RequestFactory.hpp"
 #include "utilVishnu.hpp"
 #include "utilServer.hpp"
@@ -166,6 +167,8 @@ MachineServer::update() {
         //If there is a change
         if (!sqlCommand.empty()) {
           mdatabaseVishnu->process(sqlCommand.c_str());
+          // the sessions resolve the machine names and statuses
+          SessionCache::getInstance().clear();
         }
 
       } //End if the machine to update exists
@@ -203,7 +206,8 @@ MachineServer::deleteMachine() {
                              %mdatabaseVishnu->escapeData(mmachine->getMachineId())
                              ).str();
 
-    return mdatabaseVishnu->process(sqlUpdate.c_str());
+    ret = mdatabaseVishnu->process(sqlUpdate.c_str());
+    SessionCache::getInstance().clear();
   }
   return ret;
 } //END: deleteMachine()
@@ -4,6 +4,7 @@
 #include <boost/algorithm/string.hpp>
 
 #include "DbFactory.hpp"
+#include "IdAllocator.hpp"
 
 ObjectIdServer::ObjectIdServer(const UserServer session):msession(session) {
   DbFactory factory;
@@ -36,6 +37,7 @@ ObjectIdServer::setformat(std::string fmt, std::string entry){
     e.appendMsgComp("Failed to set the "+entry+" format to "+fmt);
     throw(e);
   }
+  IdAllocator::getInstance().invalidateFormats();
 }
 
 
@@ -7,7 +7,9 @@
 
 #include "SessionServer.hpp"
 #include "CommandServer.hpp"
+#include "CommandJournal.hpp"
 #include "DbFactory.hpp"
+#include "SessionCache.hpp"
 #include "boost/format.hpp"
 
 
@@ -179,6 +181,7 @@ SessionServer::close() {
         mdatabaseVishnu->process((boost::format("UPDATE vsession"
                                                 " SET closure=CURRENT_TIMESTAMP"
                                                 " WHERE sessionkey='%1%';")%mdatabaseVishnu->escapeData(msession.getSessionKey())).str());
+        SessionCache::getInstance().invalidateSession(msession.getSessionKey());
       } else {
         //To get the close policy associated to the session
         closePolicyStr = (boost::format(" WHERE sessionkey='%1%';")%mdatabaseVishnu->escapeData(msession.getSessionKey())).str();
@@ -281,7 +284,11 @@ SessionServer::check() {
 
   int retCode = -1;
 
-  std::string sqlQuery = (boost::format("SELECT state, status, passwordstate"
+  if (SessionCache::getInstance().isChecked(msession.getSessionKey())) {
+    return 0;
+  }
+
+  std::string sqlQuery = (boost::format("SELECT state, status, passwordstate, userid"
                                         " FROM users, vsession "
                                         " WHERE users.numuserid = vsession.users_numuserid"
                                         " AND vsession.sessionkey='%1%'"
@@ -298,6 +305,7 @@ SessionServer::check() {
       if (convertToInt(tmp[1]) == vishnu::STATUS_ACTIVE) {
         if (convertToInt(tmp[2]) == vishnu::STATUS_ACTIVE) {
           retCode = 0;
+          SessionCache::getInstance().setChecked(msession.getSessionKey(), tmp[3]);
         } else {
           throw UMSVishnuException (ERRCODE_TEMPORARY_PASSWORD);
         }
@@ -332,6 +340,12 @@ SessionServer::finish(std::string cmdDescription,
   if (checkSession) {
     check();
   }
+  CommandJournal& journal = CommandJournal::getInstance();
+  if (journal.isStarted()) {
+    journal.record(msession.getSessionKey(), cmdDescription,
+                   cmdType, cmdStatus, newVishnuObjectID);
+    return 0;
+  }
   saveConnection();
   //To save the command
   CommandServer commandServer = CommandServer(cmdDescription, *this);
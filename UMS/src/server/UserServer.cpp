@@ -8,6 +8,7 @@
 #include <boost/scoped_ptr.hpp>
 #include "UserServer.hpp"
 #include "DbFactory.hpp"
+#include "SessionCache.hpp"
 #include "DatabaseResult.hpp"
 #include "RequestFactory.hpp"
 #include "LocalAccountServer.hpp"
@@ -210,6 +211,7 @@ UserServer::update(UMS_Data::User *user) {
                         %convertToString(vishnu::SESSION_ACTIVE)).str();
             mdatabaseVishnu->process(sqlquery);
           }
+          SessionCache::getInstance().invalidateUser(user->getUserId());
         }
       } else {
         throw UMSVishnuException (ERRCODE_UNKNOWN_USERID);
@@ -238,7 +240,8 @@ UserServer::deleteUser(UMS_Data::User user) {
                              %vishnu::STATUS_DELETED
                              %mdatabaseVishnu->escapeData(user.getUserId())
                              ).str();
-    return mdatabaseVishnu->process(sqlUpdate.c_str());
+    ret = mdatabaseVishnu->process(sqlUpdate.c_str());
+    SessionCache::getInstance().invalidateUser(user.getUserId());
   }
   return ret;
 }//END: deleteUser(UMS_Data::User user)
@@ -280,6 +283,7 @@ UserServer::changePassword(std::string newPassword) {
                        %convertToString(vishnu::STATUS_DELETED)).str();
 
       mdatabaseVishnu->process(sqlChangePwd);
+      SessionCache::getInstance().invalidateUser(muser.getUserId());
 
       //Put the new user's password
       muser.setPassword(newPassword);
@@ -329,6 +333,7 @@ UserServer::resetPassword(UMS_Data::User& user, std::string sendmailScriptPath)
         sqlResetPwd.append(sqlUpdatePwdState);
         //Execution of the sql code on the database
         mdatabaseVishnu->process(sqlResetPwd.c_str());
+        SessionCache::getInstance().invalidateUser(user.getUserId());
         //to get the email adress of the user
         std::string email = getAttribut("where userid='"+mdatabaseVishnu->escapeData(user.getUserId())+"' AND status !='"+convertToString(vishnu::STATUS_DELETED)+"'", "email");
         user.setEmail(email);
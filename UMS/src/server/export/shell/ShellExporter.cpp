@@ -4,6 +4,7 @@
 #include <vector>
 
 #include "utilServer.hpp"
+#include "CommandJournal.hpp"
 #include "UserException.hpp"
 #include "Mapper.hpp"
 #include "UMSShellMapper.hpp"
@@ -45,6 +46,10 @@ ShellExporter::exporte(std::string oldSession, std::string &content){
     throw UMSVishnuException(ERRCODE_INVALID_PARAM, "The session id is invalid");
   }
 
+  // The commands recorded by this server may still be queued, those of the
+  // other servers are written within their commandJournalDelay
+  CommandJournal::getInstance().flush();
+
   // The request, ordered by starttime (=submission)
   std::string req = "SELECT command.ctype, command.description, command.starttime from "
     " command, vsession where vsession.numsessionid=command.vsession_numsessionid and "
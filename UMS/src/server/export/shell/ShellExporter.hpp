@@ -39,6 +39,10 @@ public:
    * \param oldSession: Session id of the old session to export
    * \param content: The content of the export (OUT)
    * \return Succes, an error code otherwise
+   *
+   * Only the commands queued by the journal of this server are written
+   * first: those recorded by other xmssed instances reach the database up
+   * to commandJournalDelay later, and may be missing from the export.
    */
   int
   exporte(std::string oldSession, std::string &content);
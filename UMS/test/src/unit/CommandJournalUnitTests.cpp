@@ -0,0 +1,228 @@
+#include <boost/test/unit_test.hpp>
+#include <string>
+#include <vector>
+#include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include "SystemException.hpp"
+#include "MockDatabase.hpp"
+#include "DbFactory.hpp"
+#include "CommandJournal.hpp"
+
+/**
+ * \brief A mock database keeping the requests it processed, which can be
+ * held back and can reject some of them
+ */
+class RecordingDatabase : public MockDatabase {
+public:
+  RecordingDatabase()
+    : MockDatabase(DbConfiguration()), mopen(true), mwaiting(0) {}
+
+  int
+  process(std::string request, int transacId = -1) {
+    boost::unique_lock<boost::mutex> lock(mmutex);
+    while (!mopen) {
+      ++mwaiting;
+      mheld.notify_all();
+      mopened.wait(lock);
+      --mwaiting;
+    }
+    // the multi-row INSERTs are rejected when a rejected row is in them
+    if (!mrejected.empty() && request.find(mrejected) != std::string::npos) {
+      throw SystemException(ERRCODE_DBERR, "rejected: " + request);
+    }
+    mrequests.push_back(request);
+    return SUCCESS;
+  }
+
+  void
+  hold() {
+    boost::lock_guard<boost::mutex> lock(mmutex);
+    mopen = false;
+  }
+
+  void
+  waitHeld() {
+    boost::unique_lock<boost::mutex> lock(mmutex);
+    while (mwaiting == 0) {
+      mheld.wait(lock);
+    }
+  }
+
+  void
+  release() {
+    boost::lock_guard<boost::mutex> lock(mmutex);
+    mopen = true;
+    mopened.notify_all();
+  }
+
+  void
+  reject(const std::string& description) {
+    boost::lock_guard<boost::mutex> lock(mmutex);
+    mrejected = description;
+  }
+
+  std::vector<std::string>
+  getRequests() {
+    boost::lock_guard<boost::mutex> lock(mmutex);
+    return mrequests;
+  }
+
+  /**
+   * \brief Count the commands written
+   * \param description if not empty, only the commands with this description
+   */
+  size_t
+  countCommands(const std::string& description = "") {
+    std::string row = "(SELECT numsessionid FROM vsession";
+    std::string pattern = description.empty() ? row : "'" + description + "',";
+    size_t count = 0;
+    std::vector<std::string> requests = getRequests();
+    for (size_t i = 0; i < requests.size(); ++i) {
+      if (requests[i].find("INSERT INTO command") != 0) {
+        continue;
+      }
+      for (size_t pos = requests[i].find(pattern); pos != std::string::npos;
+           pos = requests[i].find(pattern, pos + 1)) {
+        ++count;
+      }
+    }
+    return count;
+  }
+
+private:
+  boost::mutex mmutex;
+  boost::condition_variable mopened;
+  boost::condition_variable mheld;
+  bool mopen;
+  int mwaiting;
+  std::string mrejected;
+  std::vector<std::string> mrequests;
+};
+
+/**
+ * \brief Installs a recording database and stops the journal at the end
+ */
+struct JournalFixture {
+  JournalFixture() {
+    DbFactory::setDatabaseInstance(&database);
+  }
+
+  ~JournalFixture() {
+    database.release();
+    CommandJournal::getInstance().stop();
+    DbFactory::setDatabaseInstance(NULL);
+  }
+
+  void
+  record(const std::string& description) {
+    CommandJournal::getInstance().record("sessionKey", description,
+                                         vishnu::UMS, vishnu::CMDSUCCESS, "");
+  }
+
+  RecordingDatabase database;
+};
+
+// the writer thread only wakes up on its own after an hour
+static const int LONG_DELAY = 3600;
+
+BOOST_AUTO_TEST_SUITE( CommandJournal_unit_tests )
+
+BOOST_FIXTURE_TEST_CASE( test_stop_flushes_n, JournalFixture )
+{
+  CommandJournal& journal = CommandJournal::getInstance();
+  journal.start(LONG_DELAY);
+  BOOST_REQUIRE(journal.isStarted());
+
+  record("first");
+  record("second");
+  record("third");
+  BOOST_CHECK_EQUAL(database.countCommands(), 0);
+
+  journal.stop();
+  BOOST_CHECK(! journal.isStarted());
+  BOOST_CHECK_EQUAL(database.countCommands(), 3);
+
+  // a single INSERT for the commands, after the last connection
+  std::vector<std::string> requests = database.getRequests();
+  BOOST_REQUIRE_EQUAL(requests.size(), 2);
+  BOOST_CHECK_EQUAL(requests[0].find("UPDATE vsession SET lastconnect"), 0);
+  BOOST_CHECK(requests[1].find("'first'") < requests[1].find("'second'"));
+  BOOST_CHECK(requests[1].find("'second'") < requests[1].find("'third'"));
+}
+
+BOOST_FIXTURE_TEST_CASE( test_stopped_writes_at_once_n, JournalFixture )
+{
+  BOOST_REQUIRE(! CommandJournal::getInstance().isStarted());
+  record("synchronous");
+  BOOST_CHECK_EQUAL(database.countCommands("synchronous"), 1);
+}
+
+BOOST_FIXTURE_TEST_CASE( test_row_fallback_b, JournalFixture )
+{
+  CommandJournal& journal = CommandJournal::getInstance();
+  journal.start(LONG_DELAY);
+  database.reject("'bad'");
+
+  record("good1");
+  record("bad");
+  record("good2");
+  journal.flush();
+
+  // the batch failed, the rows were written one by one but the bad one
+  BOOST_CHECK_EQUAL(database.countCommands("good1"), 1);
+  BOOST_CHECK_EQUAL(database.countCommands("bad"), 0);
+  BOOST_CHECK_EQUAL(database.countCommands("good2"), 1);
+  BOOST_CHECK_EQUAL(database.countCommands(), 2);
+}
+
+BOOST_FIXTURE_TEST_CASE( test_start_time_n, JournalFixture )
+{
+  CommandJournal& journal = CommandJournal::getInstance();
+  journal.start(LONG_DELAY);
+
+  record("delayed");
+  boost::this_thread::sleep(boost::posix_time::seconds(2));
+  journal.flush();
+
+  // the start time is moved back by the time spent in the queue
+  std::vector<std::string> requests = database.getRequests();
+  BOOST_REQUIRE(! requests.empty());
+  BOOST_CHECK(requests.back().find("(CURRENT_TIMESTAMP - INTERVAL '") != std::string::npos);
+  BOOST_CHECK(requests.back().find("' SECOND)") != std::string::npos);
+}
+
+BOOST_FIXTURE_TEST_CASE( test_queue_full_blocks_n, JournalFixture )
+{
+  CommandJournal& journal = CommandJournal::getInstance();
+  journal.start(LONG_DELAY);
+
+  // a write holds the database, so the writer cannot take the queue
+  database.hold();
+  record("held");
+  boost::thread flusher(boost::bind(&CommandJournal::flush, &journal));
+  database.waitHeld();
+
+  for (size_t i = 0; i < COMMAND_JOURNAL_MAX_SIZE; ++i) {
+    record("queued");
+  }
+  boost::thread caller(boost::bind(&JournalFixture::record, this, "blocked"));
+  BOOST_CHECK(! caller.timed_join(boost::posix_time::milliseconds(500)));
+
+  // once the database is back, the writer takes the queue
+  database.release();
+  BOOST_CHECK(caller.timed_join(boost::posix_time::seconds(10)));
+  BOOST_CHECK(flusher.timed_join(boost::posix_time::seconds(10)));
+
+  journal.stop();
+  BOOST_CHECK_EQUAL(database.countCommands("held"), 1);
+  BOOST_CHECK_EQUAL(database.countCommands("queued"), COMMAND_JOURNAL_MAX_SIZE);
+  BOOST_CHECK_EQUAL(database.countCommands("blocked"), 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+// THE END
@@ -0,0 +1,201 @@
+/**
+ * \file JobEventWatcher.cpp
+ * \brief This file implements the watcher of the job state changes
+ * \author Haikel Guemar (haikel.guemar@sysfera.com)
+ */
+
+#include "JobEventWatcher.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <boost/filesystem.hpp>
+#include <boost/format.hpp>
+#include "Logger.hpp"
+
+JobEventWatcher::JobEventWatcher()
+  : minotify(-1), meventWatch(-1), maccountingWatch(-1), maccountingOffset(0) {}
+
+JobEventWatcher::~JobEventWatcher() {
+  if (minotify != -1) {
+    close(minotify);
+  }
+}
+
+bool
+JobEventWatcher::watchEventDirectory(const std::string& dir) {
+  if (minotify == -1) {
+    minotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  }
+  if (minotify != -1) {
+    // touching a file not yet removed only changes its attributes
+    meventWatch = inotify_add_watch(minotify, dir.c_str(),
+                                    IN_CREATE | IN_CLOSE_WRITE | IN_MOVED_TO | IN_ATTRIB);
+  }
+  if (minotify == -1 || meventWatch == -1) {
+    LOG(boost::str(boost::format("[TMSMONITOR][ERROR] cannot watch the job events in %1%: %2%")
+                   % dir % strerror(errno)), LogErr);
+    return false;
+  }
+  meventDir = dir;
+  // reported while the monitor was down, the first poll sees them
+  clearEventDirectory();
+  return true;
+}
+
+bool
+JobEventWatcher::watchAccountingDirectory(const std::string& dir) {
+  if (minotify == -1) {
+    minotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  }
+  if (minotify != -1) {
+    maccountingWatch = inotify_add_watch(minotify, dir.c_str(),
+                                         IN_MODIFY | IN_CREATE | IN_MOVED_TO);
+  }
+  if (minotify == -1 || maccountingWatch == -1) {
+    LOG(boost::str(boost::format("[TMSMONITOR][ERROR] cannot watch the accounting logs in %1%: %2%")
+                   % dir % strerror(errno)), LogErr);
+    return false;
+  }
+  maccountingDir = dir;
+
+  // the logs are named after their day, the last one is being written
+  std::string last;
+  boost::system::error_code ec;
+  for (boost::filesystem::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+    std::string name = it->path().filename().string();
+    if (boost::filesystem::is_regular_file(it->path(), ec) && name > last) {
+      last = name;
+    }
+  }
+  if (!last.empty()) {
+    openAccounting(last, true);
+  }
+  return true;
+}
+
+bool
+JobEventWatcher::isStateRecord(const std::string& record) {
+  size_t pos = record.find(';');
+  if (pos == std::string::npos || pos + 2 >= record.size() || record[pos + 2] != ';') {
+    return false;
+  }
+  return std::string("SEDAR").find(record[pos + 1]) != std::string::npos;
+}
+
+bool
+JobEventWatcher::isWatching() const {
+  return meventWatch != -1 || maccountingWatch != -1;
+}
+
+bool
+JobEventWatcher::wait(int timeout) {
+  if (!isWatching()) {
+    sleep(timeout);
+    return false;
+  }
+
+  struct pollfd fd;
+  fd.fd = minotify;
+  fd.events = POLLIN;
+  fd.revents = 0;
+  if (poll(&fd, 1, timeout * 1000) <= 0) {
+    return false;
+  }
+
+  bool reported = false;
+  bool accounting = false;
+  bool changed = false;
+  char buffer[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+  ssize_t len;
+  while ((len = read(minotify, buffer, sizeof(buffer))) > 0) {
+    const struct inotify_event* event;
+    for (char* ptr = buffer; ptr < buffer + len; ptr += sizeof(struct inotify_event) + event->len) {
+      event = reinterpret_cast<const struct inotify_event*>(ptr);
+      if (event->wd == meventWatch) {
+        reported = true;
+      } else if (event->wd == maccountingWatch) {
+        std::string name = (event->len > 0) ? event->name : "";
+        if ((event->mask & (IN_CREATE | IN_MOVED_TO)) && name > maccountingLog) {
+          // a new day, after the end of the former log
+          changed = readAccounting() || changed;
+          openAccounting(name, false);
+        }
+        accounting = true;
+      }
+    }
+  }
+
+  if (reported) {
+    clearEventDirectory();
+  }
+  if (accounting) {
+    changed = readAccounting() || changed;
+  }
+  return reported || changed;
+}
+
+int
+JobEventWatcher::clearEventDirectory() {
+  int count = 0;
+  boost::system::error_code ec;
+  for (boost::filesystem::directory_iterator it(meventDir, ec), end; !ec && it != end; it.increment(ec)) {
+    if (boost::filesystem::remove(it->path(), ec)) {
+      LOG(boost::str(boost::format("[TMSMONITOR][DEBUG] job event: %1%")
+                     % it->path().filename().string()), LogDebug);
+      ++count;
+    }
+  }
+  return count;
+}
+
+void
+JobEventWatcher::openAccounting(const std::string& name, bool fromEnd) {
+  maccountingLog = name;
+  maccountingOffset = 0;
+  mpartialRecord.clear();
+  struct stat info;
+  if (fromEnd && stat((maccountingDir + "/" + name).c_str(), &info) == 0) {
+    maccountingOffset = info.st_size;
+  }
+}
+
+bool
+JobEventWatcher::readAccounting() {
+  if (maccountingLog.empty()) {
+    return false;
+  }
+  int fd = open((maccountingDir + "/" + maccountingLog).c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    return false;
+  }
+  struct stat info;
+  if (fstat(fd, &info) == 0 && info.st_size < maccountingOffset) {
+    // truncated or replaced
+    maccountingOffset = 0;
+    mpartialRecord.clear();
+  }
+
+  std::string data = mpartialRecord;
+  char buffer[4096];
+  ssize_t len;
+  while ((len = pread(fd, buffer, sizeof(buffer), maccountingOffset)) > 0) {
+    data.append(buffer, len);
+    maccountingOffset += len;
+  }
+  close(fd);
+
+  bool changed = false;
+  size_t start = 0;
+  size_t end;
+  while ((end = data.find('\n', start)) != std::string::npos) {
+    changed = isStateRecord(data.substr(start, end - start)) || changed;
+    start = end + 1;
+  }
+  mpartialRecord = data.substr(start);
+  return changed;
+}
@@ -0,0 +1,149 @@
+/**
+ * \file JobEventWatcher.hpp
+ * \brief This file presents the watcher of the job state changes
+ * \author Haikel Guemar (haikel.guemar@sysfera.com)
+ */
+
+#ifndef _JOBEVENTWATCHER_HPP_
+#define _JOBEVENTWATCHER_HPP_
+
+#include <string>
+#include <sys/types.h>
+#include <boost/noncopyable.hpp>
+
+/**
+ * \brief Default time in seconds between two full job polls when the job
+ * events are watched
+ */
+const int DEFAULT_JOB_POLLING_INTERVAL = 600;
+
+/**
+ * \brief Minimum time in seconds between two polls triggered by events, so
+ * that a burst of job ends costs a single poll
+ */
+const int JOB_EVENT_MIN_DELAY = 1;
+
+/**
+ * \class JobEventWatcher
+ * \brief Tells the monitor when a job may have changed state, so that it
+ * polls the batch scheduler at once rather than at the next interval.
+ *
+ * Two sources are watched with inotify:
+ * - an event directory, where the scheduler hooks (Slurm job completion
+ *   script or strigger, Torque/PBS epilogue, LSF post-exec, tms-posix)
+ *   create a file named after the job, see vishnu-job-event.sh;
+ * - the accounting directory of Torque or PBS, whose current log is tailed
+ *   for the start, end, delete, abort and rerun records.
+ *
+ * The events carry no state: they only wake the monitor up, which then
+ * polls all its jobs with a single query.
+ */
+class JobEventWatcher : public boost::noncopyable {
+public:
+  /**
+   * \brief Constructor
+   */
+  JobEventWatcher();
+
+  /**
+   * \brief Destructor
+   */
+  ~JobEventWatcher();
+
+  /**
+   * \brief Watch a directory where the hooks report the jobs
+   * \param dir the directory
+   * \return false if it cannot be watched
+   */
+  bool
+  watchEventDirectory(const std::string& dir);
+
+  /**
+   * \brief Tail the accounting logs of Torque or PBS
+   * \param dir the accounting directory, e.g. server_priv/accounting
+   * \return false if it cannot be watched
+   */
+  bool
+  watchAccountingDirectory(const std::string& dir);
+
+  /**
+   * \brief Tell whether a source is watched
+   * \return true if a source is watched
+   */
+  bool
+  isWatching() const;
+
+  /**
+   * \brief Wait for a job event
+   * \param timeout the maximum time to wait in seconds
+   * \return true if a job may have changed state, false on timeout
+   */
+  bool
+  wait(int timeout);
+
+  /**
+   * \brief Tell whether an accounting record changes the state of a job
+   * \param record the record, as date;type;jobid;attributes
+   * \return true for the start, end, delete, abort and rerun records
+   */
+  static bool
+  isStateRecord(const std::string& record);
+
+private:
+  /**
+   * \brief Remove the files of the event directory
+   * \return the number of files removed
+   */
+  int
+  clearEventDirectory();
+
+  /**
+   * \brief Read the records added to the current accounting log
+   * \return true if one of them is a job state change
+   */
+  bool
+  readAccounting();
+
+  /**
+   * \brief Follow a new accounting log, the logs are named after their day
+   * \param name the name of the log
+   * \param fromEnd whether the records already there are skipped
+   */
+  void
+  openAccounting(const std::string& name, bool fromEnd);
+
+  /**
+   * \brief The inotify instance, -1 if none
+   */
+  int minotify;
+  /**
+   * \brief The watch of the event directory, -1 if none
+   */
+  int meventWatch;
+  /**
+   * \brief The watch of the accounting directory, -1 if none
+   */
+  int maccountingWatch;
+  /**
+   * \brief The event directory
+   */
+  std::string meventDir;
+  /**
+   * \brief The accounting directory
+   */
+  std::string maccountingDir;
+  /**
+   * \brief The name of the accounting log being tailed
+   */
+  std::string maccountingLog;
+  /**
+   * \brief The position read in the accounting log
+   */
+  off_t maccountingOffset;
+  /**
+   * \brief The end of the log not yet terminated by a newline
+   */
+  std::string mpartialRecord;
+};
+
+#endif // _JOBEVENTWATCHER_HPP_
@@ -1,5 +1,12 @@
 #include "MonitorXMS.hpp"
+#include <algorithm>
 #include <csignal>
+#include <ctime>
+#include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/thread_time.hpp>
 #include "AuthenticatorConfiguration.hpp"
 #include "AuthenticatorFactory.hpp"
 #include "Authenticator.hpp"
@@ -8,11 +15,33 @@
 #include "ServerXMS.hpp"
 #include "Logger.hpp"
 
+// anonymous namespace
+namespace {
+  /**
+   * \brief Hash a job identifier, the same way on all the servers
+   * \param jobId the job identifier
+   * \return the 32 bits FNV-1a hash of the identifier
+   */
+  unsigned int
+  hashJobId(const std::string& jobId) {
+    unsigned int hash = 2166136261U;
+    for (size_t i = 0; i < jobId.size(); ++i) {
+      hash ^= static_cast<unsigned char>(jobId[i]);
+      hash *= 16777619U;
+    }
+    return hash;
+  }
+}
+
 
 MonitorXMS::MonitorXMS(int interval) :
   minterval(interval),
+  mjobPollingInterval(DEFAULT_JOB_POLLING_INTERVAL),
+  mshardCount(1),
+  mshardIndex(0),
   mdatabaseVishnu(NULL),
-  mauthenticator(NULL) {}
+  mauthenticator(NULL),
+  mstopping(false) {}
 
 MonitorXMS::~MonitorXMS() {
   delete mdatabaseVishnu;
@@ -29,13 +58,64 @@ MonitorXMS::init(const SedConfig& cfg) {
   mhasUMS = cfg.hasUMS;
   mhasTMS = cfg.hasTMS;
   mhasFMS = cfg.hasFMS;
+  mmachineId = cfg.mid;
+  mbatchType = cfg.batchType;
+  mbatchVersion = cfg.batchVersion;
 
+  // with job events, polling is only a safety net
+  std::string dir;
+  if (mhasTMS && cfg.config.getConfigValue<std::string>(vishnu::JOBEVENTDIR, dir)) {
+    mjobEvents.watchEventDirectory(dir);
+  }
+  if (mhasTMS && cfg.config.getConfigValue<std::string>(vishnu::JOBACCOUNTINGDIR, dir)) {
+    mjobEvents.watchAccountingDirectory(dir);
+  }
+  if (!cfg.config.getConfigValue<int>(vishnu::JOBPOLLINGINTERVAL, mjobPollingInterval)
+      || mjobPollingInterval <= 0) {
+    mjobPollingInterval = DEFAULT_JOB_POLLING_INTERVAL;
+  }
 
+  if (cfg.config.getConfigValue<int>(vishnu::MONITORSHARDCOUNT, mshardCount)) {
+    cfg.config.getConfigValue<int>(vishnu::MONITORSHARDINDEX, mshardIndex);
+    if (mshardCount < 1 || mshardIndex < 0 || mshardIndex >= mshardCount) {
+      LOG(str(format("[TMSMONITOR][ERROR] invalid shard %1% of %2%, all the jobs are monitored")
+              % mshardIndex % mshardCount), LogErr);
+      mshardCount = 1;
+      mshardIndex = 0;
+    }
+  }
+
+  // each check has its own thread and schedule
+  int sessionInterval;
+  if (!cfg.config.getConfigValue<int>(vishnu::SESSIONMONITORINTERVAL, sessionInterval)
+      || sessionInterval <= 0) {
+    sessionInterval = minterval;
+  }
+  int fileInterval;
+  if (!cfg.config.getConfigValue<int>(vishnu::FILEMONITORINTERVAL, fileInterval)
+      || fileInterval <= 0) {
+    fileInterval = minterval;
+  }
+  int jobInterval = mjobEvents.isWatching() ? mjobPollingInterval : minterval;
+  if (mhasUMS) {
+    addTask("sessions", boost::bind(&MonitorXMS::checkSession, this), sessionInterval, false);
+  }
+  if (mhasTMS) {
+    addTask("jobs", boost::bind(&MonitorXMS::checkJobs, this, static_cast<int>(mbatchType)),
+            jobInterval, true);
+    if (mbatchType != POSIX) {
+      addTask("posixJobs", boost::bind(&MonitorXMS::checkJobs, this, static_cast<int>(POSIX)),
+              jobInterval, true);
+    }
+  }
+  if (mhasFMS) {
+    addTask("files", boost::bind(&MonitorXMS::checkFile, this), fileInterval, false);
+  }
+
+  // a connection for each task
+  dbConfig.setDbPoolSize(std::max(static_cast<unsigned>(mtasks.size()), 1U));
   DbFactory factory;
   mdatabaseVishnu = factory.createDatabaseInstance(dbConfig);
-  mmachineId = cfg.mid;
-  mbatchType = cfg.batchType;
-  mbatchVersion = cfg.batchVersion;
 
   AuthenticatorFactory authfactory;
   mauthenticator = authfactory.createAuthenticatorInstance(authenticatorConfig);
@@ -61,13 +141,13 @@ MonitorXMS::init(const SedConfig& cfg) {
 void
 MonitorXMS::checkJobs(int batchtype){
   std::string sqlRequest = boost::str(boost::format(
-                                        "SELECT jobId, batchJobId, vmIp, vmId, owner "
+                                        "SELECT jobId, batchJobId, vmIp, vmId, owner, job.status "
                                         " FROM job, vsession "
                                         " WHERE vsession.numsessionid=job.vsession_numsessionid "
                                         " AND submitMachineId='%1%' "
                                         " AND batchType=%2% "
-                                        " AND status >= %3% "
-                                        " AND status < %4% ")
+                                        " AND job.status >= %3% "
+                                        " AND job.status < %4% ")
                                       % mmachineId
                                       % vishnu::convertToString(batchtype)
                                       % vishnu::STATE_UNDEFINED
@@ -75,45 +155,56 @@ MonitorXMS::checkJobs(int batchtype){
 
   try {
     BatchFactory factory;
-    boost::scoped_ptr<BatchServer> batchServer(factory.getBatchServerInstance(batchtype, mbatchVersion));
-    boost::scoped_ptr<DatabaseResult> result(mdatabaseVishnu->getResult(sqlRequest.c_str()));
-
-    std::vector<std::string> buffer;
-    std::vector<std::string>::iterator item;
-    for (size_t i = 0; i < result->getNbTuples(); ++i) {
-      buffer.clear();
-      buffer = result->get(i);
-      item = buffer.begin();
-      TMS_Data::Job job;
-      job.setJobId( *item++ );
-      job.setBatchJobId( *item++ );
-      job.setVmIp( *item++ );
-      job.setVmId( *item++ );
-      job.setOwner( *item );
+    boost::shared_ptr<BatchServer> batchServer = factory.getBatchServerInstance(batchtype, mbatchVersion);
 
-      try {
-        int state;
-        switch (batchtype) {
-          case DELTACLOUD:
-          case OPENNEBULA:
-            state = batchServer->getJobState(JsonObject::serialize(job));
-            break;
-          default:
-            state = batchServer->getJobState(job.getBatchJobId());
-            break;
+    // read the jobs before polling: the cursor holds a connection, needed
+    // by the updates below
+    std::vector<boost::shared_ptr<TMS_Data::Job> > jobs;
+    {
+      boost::scoped_ptr<DatabaseCursor> cursor(mdatabaseVishnu->getCursor(sqlRequest));
+      while (cursor->next()) {
+        // the other servers of the machine poll the other shards
+        if (!isInShard(cursor->getString(0))) {
+          continue;
         }
-        std::string query = boost::str(boost::format("UPDATE job SET status=%1%"
-                                                     " WHERE jobId='%2%';")
-                                       % vishnu::convertToString(state) % job.getJobId());
-        if (state == vishnu::STATE_COMPLETED) {
-          query.append(boost::str(boost::format("UPDATE job SET endDate=CURRENT_TIMESTAMP"
-                                                " WHERE jobId='%1%';") % job.getJobId()));
-        }
-        mdatabaseVishnu->process(query);
-      } catch (VishnuException& ex) {
-        LOG(boost::str(boost::format("[TMSMONITOR][ERROR] %1%") % ex.what()), LogErr);
+        boost::shared_ptr<TMS_Data::Job> job(new TMS_Data::Job());
+        job->setJobId(cursor->getString(0));
+        job->setBatchJobId(cursor->getString(1));
+        job->setVmIp(cursor->getString(2));
+        job->setVmId(cursor->getString(3));
+        job->setOwner(cursor->getString(4));
+        job->setStatus(cursor->getInt(5));
+        jobs.push_back(job);
       }
     }
+
+    // a single query to the batch scheduler for all the jobs
+    std::vector<std::string> jobIds;
+    jobIds.reserve(jobs.size());
+    for (size_t i = 0; i < jobs.size(); ++i) {
+      switch (batchtype) {
+        case DELTACLOUD:
+        case OPENNEBULA:
+          jobIds.push_back(JsonObject::serialize(*jobs[i]));
+          break;
+        default:
+          jobIds.push_back(jobs[i]->getBatchJobId());
+          break;
+      }
+    }
+    std::vector<int> states = batchServer->getJobStates(jobIds);
+
+    // only the transitions are written
+    std::vector<std::pair<TMS_Data::Job*, int> > changes;
+    for (size_t i = 0; i < jobs.size(); ++i) {
+      if (states[i] < 0) {
+        LOG(boost::str(boost::format("[TMSMONITOR][WARN] cannot get the state of the job %1%")
+                       % jobs[i]->getJobId()), LogWarning);
+      } else if (states[i] != jobs[i]->getStatus()) {
+        changes.push_back(std::make_pair(jobs[i].get(), states[i]));
+      }
+    }
+    updateJobStates(changes);
   } catch (VishnuException& ex) {
     LOG(boost::str(boost::format("[TMSMONITOR][ERROR] %1%") % ex.what()), LogErr);
   } catch (...) {
@@ -122,6 +213,72 @@ MonitorXMS::checkJobs(int batchtype){
 }
 
 
+void
+MonitorXMS::updateJobStates(const std::vector<std::pair<TMS_Data::Job*, int> >& changes) {
+  if (changes.empty()) {
+    return;
+  }
+
+  // the requests are built first: escaping may need the connection the
+  // transaction holds
+  std::vector<std::string> requests;
+  for (size_t first = 0; first < changes.size(); first += MONITOR_UPDATE_BATCH_SIZE) {
+    size_t last = std::min(first + MONITOR_UPDATE_BATCH_SIZE, changes.size());
+    std::string values;
+    for (size_t i = first; i < last; ++i) {
+      if (i != first) {
+        values += (mdatabaseVishnu->getDbType() == DbConfiguration::MYSQL) ? " UNION ALL " : ",";
+      }
+      // the former status guards against a change made meanwhile, e.g. a cancel
+      std::string jobId = mdatabaseVishnu->escapeData(changes[i].first->getJobId());
+      switch (mdatabaseVishnu->getDbType()) {
+      case DbConfiguration::MYSQL:
+        values += boost::str(boost::format("SELECT '%1%' AS jobid, %2% AS status, %3% AS oldstatus")
+                             % jobId % changes[i].second % changes[i].first->getStatus());
+        break;
+      default:
+        values += boost::str(boost::format("('%1%', %2%, %3%)")
+                             % jobId % changes[i].second % changes[i].first->getStatus());
+        break;
+      }
+    }
+
+    switch (mdatabaseVishnu->getDbType()) {
+    case DbConfiguration::MYSQL:
+      requests.push_back(boost::str(boost::format(
+                                      "UPDATE job JOIN (%1%) AS v ON job.jobid=v.jobid"
+                                      " SET job.endDate=IF(v.status=%2%, CURRENT_TIMESTAMP, job.endDate),"
+                                      " job.status=v.status"
+                                      " WHERE job.status=v.oldstatus")
+                                    % values % vishnu::STATE_COMPLETED));
+      break;
+    default:
+      requests.push_back(boost::str(boost::format(
+                                      "UPDATE job SET status=v.status,"
+                                      " endDate=CASE WHEN v.status=%2% THEN CURRENT_TIMESTAMP ELSE job.endDate END"
+                                      " FROM (VALUES %1%) AS v(jobid, status, oldstatus)"
+                                      " WHERE job.jobid=v.jobid AND job.status=v.oldstatus")
+                                    % values % vishnu::STATE_COMPLETED));
+      break;
+    }
+  }
+
+  int tid = -1;
+  try {
+    tid = mdatabaseVishnu->startTransaction();
+    mdatabaseVishnu->processBatch(requests, tid);
+    mdatabaseVishnu->endTransaction(tid);
+  } catch (VishnuException& ex) {
+    if (tid != -1) {
+      try {
+        mdatabaseVishnu->cancelTransaction(tid);
+      } catch (VishnuException&) {}
+    }
+    LOG(boost::str(boost::format("[TMSMONITOR][ERROR] cannot save %1% job states: %2%")
+                   % changes.size() % ex.what()), LogErr);
+  }
+}
+
 void
 MonitorXMS::checkSession(){
   SessionServer closer;
@@ -204,20 +361,143 @@ MonitorXMS::checkFile(){
 
 int
 MonitorXMS::run() {
+  boost::thread_group threads;
+  for (size_t i = 0; i < mtasks.size(); ++i) {
+    threads.create_thread(boost::bind(&MonitorXMS::runTask, this, mtasks[i].get()));
+  }
+  if (mhasTMS && mjobEvents.isWatching()) {
+    threads.create_thread(boost::bind(&MonitorXMS::watchJobEvents, this));
+  }
+
+  time_t nextMetrics = std::time(NULL) + MONITOR_METRICS_INTERVAL;
   while (kill(getppid(), 0) == 0) {
-    if (mhasUMS) {
-      checkSession();
+    sleep(1);
+    if (std::time(NULL) >= nextMetrics) {
+      logMetrics();
+      nextMetrics = std::time(NULL) + MONITOR_METRICS_INTERVAL;
     }
-    if (mhasTMS) {
-      checkJobs(mbatchType);
-      if (mbatchType != POSIX){
-        checkJobs(POSIX);
+  }
+
+  // the checks running are completed
+  {
+    boost::lock_guard<boost::mutex> lock(mmutex);
+    mstopping = true;
+    mwakeup.notify_all();
+  }
+  threads.join_all();
+  return 0;
+}
+
+std::map<std::string, MonitorTaskMetrics>
+MonitorXMS::getMetrics() const {
+  boost::lock_guard<boost::mutex> lock(mmutex);
+  std::map<std::string, MonitorTaskMetrics> metrics;
+  for (size_t i = 0; i < mtasks.size(); ++i) {
+    metrics[mtasks[i]->name] = mtasks[i]->metrics;
+  }
+  return metrics;
+}
+
+void
+MonitorXMS::addTask(const std::string& name, const boost::function<void ()>& check,
+                    int interval, bool onJobEvent) {
+  boost::shared_ptr<Task> task(new Task());
+  task->name = name;
+  task->check = check;
+  task->onJobEvent = onJobEvent;
+  task->triggered = false;
+  task->metrics.interval = interval;
+  task->metrics.cycles = 0;
+  task->metrics.overruns = 0;
+  task->metrics.lastTime = 0;
+  task->metrics.maxTime = 0;
+  task->metrics.totalTime = 0;
+  mtasks.push_back(task);
+}
+
+void
+MonitorXMS::runTask(Task* task) {
+  boost::posix_time::seconds interval(task->metrics.interval);
+  boost::posix_time::seconds eventDelay(JOB_EVENT_MIN_DELAY);
+  boost::system_time next = boost::get_system_time();
+  boost::system_time last = next - eventDelay;
+
+  boost::unique_lock<boost::mutex> lock(mmutex);
+  while (!mstopping) {
+    // a burst of job events costs a single cycle
+    boost::system_time due = task->triggered ? std::min(next, last + eventDelay) : next;
+    if (boost::get_system_time() < due) {
+      mwakeup.timed_wait(lock, due);
+      continue;
+    }
+    task->triggered = false;
+    lock.unlock();
+
+    boost::system_time start = boost::get_system_time();
+    try {
+      task->check();
+    } catch (...) {
+      LOG(boost::str(boost::format("[MONITOR][ERROR] the %1% check failed") % task->name), LogErr);
+    }
+    boost::system_time end = boost::get_system_time();
+
+    lock.lock();
+    double time = (end - start).total_microseconds() / 1000.0;
+    MonitorTaskMetrics& metrics = task->metrics;
+    ++metrics.cycles;
+    metrics.lastTime = time;
+    metrics.maxTime = std::max(metrics.maxTime, time);
+    metrics.totalTime += time;
+    last = start;
+    next = start + interval;
+    if (end > next) {
+      // late: the next cycle starts at once rather than piling up
+      ++metrics.overruns;
+      next = end;
+      LOG(boost::str(boost::format("[MONITOR][WARN] the %1% check lasted %2% ms, more than its interval")
+                     % task->name % time), LogWarning);
+    }
+  }
+}
+
+void
+MonitorXMS::watchJobEvents() {
+  while (true) {
+    {
+      boost::lock_guard<boost::mutex> lock(mmutex);
+      if (mstopping) {
+        return;
       }
     }
-    if (mhasFMS) {
-      checkFile();
+    // a short wait, to notice the stop
+    if (mjobEvents.wait(1)) {
+      boost::lock_guard<boost::mutex> lock(mmutex);
+      for (size_t i = 0; i < mtasks.size(); ++i) {
+        if (mtasks[i]->onJobEvent) {
+          mtasks[i]->triggered = true;
+        }
+      }
+      mwakeup.notify_all();
     }
-    sleep(minterval);
   }
-  return 0;
+}
+
+void
+MonitorXMS::logMetrics() const {
+  std::map<std::string, MonitorTaskMetrics> metrics = getMetrics();
+  for (std::map<std::string, MonitorTaskMetrics>::const_iterator it = metrics.begin();
+       it != metrics.end(); ++it) {
+    const MonitorTaskMetrics& task = it->second;
+    LOG(boost::str(boost::format("[MONITOR][INFO] %1%: %2% cycles every %3% s, %4% late,"
+                                 " last %5% ms, average %6% ms, max %7% ms")
+                   % it->first % task.cycles % task.interval % task.overruns % task.lastTime
+                   % (task.cycles ? task.totalTime / task.cycles : 0.0) % task.maxTime), LogInfo);
+  }
+}
+
+bool
+MonitorXMS::isInShard(const std::string& jobId) const {
+  return mshardCount <= 1
+         || hashJobId(jobId) % static_cast<unsigned int>(mshardCount)
+            == static_cast<unsigned int>(mshardIndex);
 }
@@ -1,11 +1,60 @@
+#include <map>
+#include <string>
+#include <vector>
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
 #include "internalApiUMS.hpp"
 #include "internalApiTMS.hpp"
 #include "tmsUtils.hpp"
 #include "AuthenticatorConfiguration.hpp"
 #include "ServerXMS.hpp"
+#include "JobEventWatcher.hpp"
 
 class Authenticator;
 
+/**
+ * \brief Number of jobs whose state is saved by a single request
+ */
+const size_t MONITOR_UPDATE_BATCH_SIZE = 1000;
+
+/**
+ * \brief Time in seconds between two logs of the monitor metrics
+ */
+const int MONITOR_METRICS_INTERVAL = 3600;
+
+/**
+ * \struct MonitorTaskMetrics
+ * \brief Statistics on the cycles of a monitor task
+ */
+struct MonitorTaskMetrics {
+  /**
+   * \brief The time in seconds between two cycles
+   */
+  int interval;
+  /**
+   * \brief The number of cycles run
+   */
+  unsigned long cycles;
+  /**
+   * \brief The number of cycles which lasted longer than the interval
+   */
+  unsigned long overruns;
+  /**
+   * \brief The duration of the last cycle (ms)
+   */
+  double lastTime;
+  /**
+   * \brief The longest cycle (ms)
+   */
+  double maxTime;
+  /**
+   * \brief The time spent in the cycles (ms)
+   */
+  double totalTime;
+};
+
 class MonitorXMS {
 public:
   /**
@@ -38,17 +87,120 @@ public:
   int
   run();
 
+  /**
+   * @brief Get the statistics on the cycles of the monitor tasks
+   * @return a copy of the statistics, by task name
+   */
+  std::map<std::string, MonitorTaskMetrics>
+  getMetrics() const;
 
+private:
+  /**
+   * @brief A check run periodically by its own thread
+   */
+  struct Task {
+    /**
+     * @brief The name of the task, in the logs
+     */
+    std::string name;
+    /**
+     * @brief The check
+     */
+    boost::function<void ()> check;
+    /**
+     * @brief Whether the job events trigger the check
+     */
+    bool onJobEvent;
+    /**
+     * @brief Whether a job event is pending
+     */
+    bool triggered;
+    /**
+     * @brief The statistics on the cycles
+     */
+    MonitorTaskMetrics metrics;
+  };
 
+  /**
+   * @brief Add a task
+   * @param name the name of the task
+   * @param check the check
+   * @param interval the time in seconds between two cycles
+   * @param onJobEvent whether the job events trigger the check
+   */
+  void
+  addTask(const std::string& name, const boost::function<void ()>& check,
+          int interval, bool onJobEvent);
+  /**
+   * @brief Run the cycles of a task until the monitor stops
+   * @param task the task
+   */
+  void
+  runTask(Task* task);
+  /**
+   * @brief Trigger the tasks on the job events until the monitor stops
+   */
+  void
+  watchJobEvents();
+  /**
+   * @brief Log the metrics of the tasks
+   */
+  void
+  logMetrics() const;
+  /**
+   * @brief Tell whether a job is monitored by this server
+   * @param jobId the job identifier
+   * @return true if the job falls in the shard of this server
+   */
+  bool
+  isInShard(const std::string& jobId) const;
 
-private:
   void
   checkSession();
   void
   checkJobs(int batchtype);
+  /**
+   * @brief Save the new states of jobs in a single transaction
+   * @param changes the jobs, with their former status, and their new state
+   */
+  void
+  updateJobStates(const std::vector<std::pair<TMS_Data::Job*, int> >& changes);
   void
   checkFile();
   int minterval;
+  /**
+   * @brief The time in seconds between two full job polls when the job
+   * events are watched
+   */
+  int mjobPollingInterval;
+  /**
+   * @brief Wakes the monitor up when a job changes state
+   */
+  JobEventWatcher mjobEvents;
+  /**
+   * @brief The number of servers sharing the jobs of the machine
+   */
+  int mshardCount;
+  /**
+   * @brief The shard of this server, from 0 to mshardCount-1
+   */
+  int mshardIndex;
+  /**
+   * @brief The periodic checks
+   */
+  std::vector<boost::shared_ptr<Task> > mtasks;
+  /**
+   * @brief Protects the tasks and the stop flag
+   */
+  mutable boost::mutex mmutex;
+  /**
+   * @brief Wakes the tasks up on a job event or a stop
+   */
+  boost::condition_variable mwakeup;
+  /**
+   * @brief Whether the monitor is stopping
+   */
+  bool mstopping;
   std::string mmachineId;
   BatchType mbatchType;
   std::string mbatchVersion;
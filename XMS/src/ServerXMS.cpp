@@ -2,6 +2,8 @@
 #include <boost/algorithm/string.hpp>
 #include "AuthenticatorFactory.hpp"
 #include "DbFactory.hpp"
+#include "SessionCache.hpp"
+#include "CommandJournal.hpp"
 #include "internalApiUMS.hpp"
 #include "internalApiTMS.hpp"
 #include "utilVishnu.hpp"
@@ -92,6 +94,18 @@ ServerXMS::init(SedConfig& cfg) {
     mdebugLevel = 0;
   }
 
+  // how long the checked session keys are trusted
+  int sessionCacheTtl;
+  if (msedConfig->getConfigValue<int>(vishnu::SESSIONCACHETTL, sessionCacheTtl)) {
+    SessionCache::getInstance().setTtl(sessionCacheTtl);
+  }
+
+  // how long the commands are queued before being recorded
+  int commandJournalDelay;
+  if (!msedConfig->getConfigValue<int>(vishnu::COMMANDJOURNALDELAY, commandJournalDelay)) {
+    commandJournalDelay = DEFAULT_COMMAND_JOURNAL_DELAY;
+  }
+
   //initialization of the batchType
   mbatchType = cfg.batchType;
 
@@ -144,6 +158,8 @@ ServerXMS::init(SedConfig& cfg) {
 
     /*connection to the database*/
     mdatabaseVishnu->connect();
+    // the replicas serving the listings, if any
+    factory.createReplicaInstances(cfg.dbConfig);
     mmapperTMS = new TMSMapper(MapperRegistry::getInstance(), TMSMAPPERNAME);
     mmapperTMS->registerMapper();
     mmapperFMS = new FMSMapper(MapperRegistry::getInstance(), FMSMAPPERNAME);
@@ -163,6 +179,10 @@ ServerXMS::init(SedConfig& cfg) {
     errorCode = 1;
   }
 
+  if (!errorCode) {
+    CommandJournal::getInstance().start(commandJournalDelay);
+  }
+
 // initialization of the service table
   initMap(cfg.mid);
 
@@ -173,6 +193,8 @@ ServerXMS::ServerXMS() {
 }
 
 ServerXMS::~ServerXMS() {
+  // the queued commands need the database
+  CommandJournal::getInstance().stop();
   delete mmapperUMS;
   delete mdatabaseVishnu;
   delete mauthenticator;
@@ -15,6 +15,7 @@
 #include "ObjectIdServer.hpp"
 #include "ExportServer.hpp"
 #include "ExportFactory.hpp"
+#include "CommandJournal.hpp"
 
 using namespace vishnu;
 
@@ -195,6 +196,8 @@ solveSessionClose(diet_profile_t* pb) {
 
     // To save the connection
     sessionServer.finish(cmd, UMS, vishnu::CMDSUCCESS, "", false);
+    // The session can be exported from now on
+    CommandJournal::getInstance().flush();
   } catch (VishnuException& ex) {
     try {
       sessionServer.finish(cmd, UMS, vishnu::CMDFAILED);
@@ -0,0 +1,24 @@
+#!/bin/sh
+#
+# Tell the VISHNU monitor that a job changed state, so that it polls the
+# batch scheduler at once instead of waiting for jobPollingInterval.
+#
+# It creates a file named after the job in the jobEventDirectory of the
+# XMS configuration, which must be writable by the user running the hook
+# (e.g. mode 733). It can be used as:
+#  - SLURM: the job completion script (JobCompType=jobcomp/script and
+#    JobCompLoc=<this script> in slurm.conf), or a strigger --program;
+#  - TORQUE/PBS: the epilogue (the job id is the first argument), though
+#    watching the accounting logs with jobAccountingDirectory needs no hook;
+#  - LSF: a post-execution command (LSB_POSTEXEC or bsub -Ep).
+#
+# The hook never fails, so that it cannot make a job fail.
+#
+
+EVENT_DIR=${VISHNU_JOB_EVENT_DIR:-/var/spool/vishnu/jobevents}
+JOB_ID=${1:-${JOBID:-${SLURM_JOB_ID:-${PBS_JOBID:-${LSB_JOBID:-unknown}}}}}
+
+if [ -d "$EVENT_DIR" ]; then
+    touch "$EVENT_DIR/$(printf '%s' "$JOB_ID" | tr -c 'A-Za-z0-9._-' '_')" 2>/dev/null
+fi
+exit 0
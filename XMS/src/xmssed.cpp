@@ -1,4 +1,7 @@
 #include <sys/wait.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
 #include <csignal>
 #include <cstring>
 #include <iostream>
@@ -9,6 +12,7 @@
 #include "CommServer.hpp"
 #include "tmsUtils.hpp"
 #include "Logger.hpp"
+#include "CommandJournal.hpp"
 
 
 
@@ -125,6 +129,72 @@ controlSignal (int signum) {
   }
 }
 
+/**
+ * @brief The pipe on which the stop signals are written, read by the thread
+ * recording the queued commands
+ */
+int stopPipe[2] = {-1, -1};
+
+/**
+ * @brief Hand the stop signal over to the thread waiting for it, as nothing
+ * else is safe in a signal handler
+ * @param signum the signal received
+ */
+void
+forwardStopSignal(int signum) {
+  int savedErrno = errno;
+  unsigned char sig = static_cast<unsigned char>(signum);
+  if (write(stopPipe[1], &sig, 1) < 0) {
+    // the pipe is full, a stop signal is already pending
+  }
+  errno = savedErrno;
+}
+
+/**
+ * @brief Wait for a stop signal, record the queued commands, then let the
+ * signal terminate the server
+ */
+void
+waitStopSignal() {
+  unsigned char sig;
+  ssize_t count;
+  do {
+    count = read(stopPipe[0], &sig, 1);
+  } while (count < 0 && errno == EINTR);
+  if (count != 1) {
+    return;
+  }
+  CommandJournal::getInstance().stop();
+  signal(sig, SIG_DFL);
+  raise(sig);
+}
+
+/**
+ * @brief Handle the stop signals in a thread. The signal mask is left
+ * untouched and the handlers are reset by exec, so the processes started by
+ * the server are stopped as usual
+ * @return 0 on success, -1 otherwise
+ */
+int
+handleStopSignals() {
+  if (pipe(stopPipe) != 0) {
+    return -1;
+  }
+  for (int i = 0; i < 2; ++i) {
+    fcntl(stopPipe[i], F_SETFD, FD_CLOEXEC);
+  }
+  fcntl(stopPipe[1], F_SETFL, O_NONBLOCK);
+  boost::thread stopThread(waitStopSignal);
+
+  struct sigaction action;
+  action.sa_handler = forwardStopSignal;
+  sigemptyset(&(action.sa_mask));
+  action.sa_flags = SA_RESTART;
+  sigaction(SIGTERM, &action, NULL);
+  sigaction(SIGINT, &action, NULL);
+  return 0;
+}
+
 int
 main(int argc, char* argv[], char* envp[]) {
   // initialisation
@@ -154,6 +224,12 @@ main(int argc, char* argv[], char* envp[]) {
   pid = fork();
 
   if (pid > 0) {
+    // the queued commands are recorded before a stop signal terminates
+    // the server
+    if (handleStopSignals() != 0) {
+      std::cerr << "Warning: the stop signals are not handled\n";
+    }
+
     //Initialize the UMS Server (Opens a connection to the database)
     boost::shared_ptr<ServerXMS> serverXMS(ServerXMS::getInstance());
     int res = serverXMS->init(cfg);
@@ -172,6 +248,7 @@ main(int argc, char* argv[], char* envp[]) {
     // Initialize the Vishnu SeD
     if (!res) {
       initSeD(XMSTYPE, cfg.config, cfg.uri, serverXMS);
+      CommandJournal::getInstance().stop();
       exit(0);
     } else {
       std::cerr << "There was a problem during services initialization\n";
@@ -182,8 +259,8 @@ main(int argc, char* argv[], char* envp[]) {
     if (! cfg.config.getConfigValue(vishnu::INTERVALMONITOR, interval)) {
       interval = 60;
     }
+    // the monitor sizes its connection pool after its tasks
     MonitorXMS monitor(interval);
-    cfg.dbConfig.setDbPoolSize(1);
     monitor.init(cfg);
     monitor.run();
   } else {
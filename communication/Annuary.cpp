@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <string>
 #include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/foreach.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/make_shared.hpp>
@@ -16,8 +17,31 @@
 #include "TMSServices.hpp"
 #include "FMSServices.hpp"
 
+/**
+ * \brief Weight of the last sample in the moving average of the RPC time
+ */
+static const double LATENCY_EWMA_ALPHA = 0.2;
+
+/**
+ * \brief Given to the strategies which don't read the loads
+ */
+static const ServerLoadMap NO_LOADS;
+
+Annuary::Annuary()
+  : msnapshot(boost::make_shared<Snapshot>()),
+    msuspects(boost::make_shared<SuspectSet>()), msweepDuration(0.),
+    melection(boost::make_shared<FirstElection>()) {}
+
 Annuary::Annuary(const std::vector<boost::shared_ptr<Server> >& serv)
-  : mservers(serv) {}
+  : msuspects(boost::make_shared<SuspectSet>()), msweepDuration(0.),
+    melection(boost::make_shared<FirstElection>()) {
+  boost::shared_ptr<Snapshot> snap = boost::make_shared<Snapshot>();
+  std::vector<boost::shared_ptr<Server> >::const_iterator it;
+  for (it = serv.begin(); it != serv.end(); ++it) {
+    insertServer(*snap, *it);
+  }
+  msnapshot = snap;
+}
 
 
 // anonymous namespace
@@ -38,15 +62,75 @@ namespace {
   };
 }
 
+boost::shared_ptr<const Annuary::Snapshot>
+Annuary::snapshot() const {
+  return boost::atomic_load(&msnapshot);
+}
+
+void
+Annuary::insertServer(Snapshot& snap, boost::shared_ptr<Server> server) {
+  snap.servers.push_back(server);
+  std::vector<std::string>& services = server->getServices();
+  std::vector<std::string>::const_iterator it;
+  for (it = services.begin(); it != services.end(); ++it) {
+    // the lists are shared with the previous snapshots, copy on write
+    boost::shared_ptr<const ServerList>& entry = snap.index[*it];
+    boost::shared_ptr<ServerList> list = entry ?
+      boost::make_shared<ServerList>(*entry) :
+      boost::make_shared<ServerList>();
+    if (list->empty() || list->back() != server) {
+      list->push_back(server);
+    }
+    entry = list;
+  }
+}
+
+void
+Annuary::setSuspect(const std::string& uri, bool suspect) {
+  if ((msuspects->count(uri) > 0) == suspect) {
+    return;
+  }
+  boost::shared_ptr<SuspectSet> suspects = boost::make_shared<SuspectSet>(*msuspects);
+  if (suspect) {
+    suspects->insert(uri);
+  } else {
+    suspects->erase(uri);
+  }
+  boost::atomic_store(&msuspects, boost::shared_ptr<const SuspectSet>(suspects));
+}
+
+void
+Annuary::eraseServer(Snapshot& snap, boost::shared_ptr<Server> server) {
+  snap.servers.erase(std::remove(snap.servers.begin(), snap.servers.end(), server),
+                     snap.servers.end());
+  std::vector<std::string>& services = server->getServices();
+  std::vector<std::string>::const_iterator it;
+  for (it = services.begin(); it != services.end(); ++it) {
+    ServiceIndex::iterator entry = snap.index.find(*it);
+    if (entry == snap.index.end()) {
+      continue;
+    }
+    boost::shared_ptr<ServerList> list =
+      boost::make_shared<ServerList>(*entry->second);
+    list->erase(std::remove(list->begin(), list->end(), server), list->end());
+    if (list->empty()) {
+      snap.index.erase(entry);
+    } else {
+      entry->second = list;
+    }
+  }
+}
+
 int
 Annuary::add(const std::string& name, const std::string& uri,
              const std::vector<std::string>& services) {
   boost::lock_guard<boost::recursive_mutex> lock(mmutex);
   is_server helper(name, uri);
-  std::vector<boost::shared_ptr<Server> >::iterator it =
-    std::find_if(mservers.begin(), mservers.end(), helper);
-  if (it == mservers.end()) {
-    mservers.push_back(boost::make_shared<Server>(name, services, uri));
+  if (std::find_if(msnapshot->servers.begin(), msnapshot->servers.end(),
+                   helper) == msnapshot->servers.end()) {
+    boost::shared_ptr<Snapshot> snap = boost::make_shared<Snapshot>(*msnapshot);
+    insertServer(*snap, boost::make_shared<Server>(name, services, uri));
+    boost::atomic_store(&msnapshot, boost::shared_ptr<const Snapshot>(snap));
     std::cerr << "[INFO]: added " << name << "@" << uri << "\n";
   }
   return 0;
@@ -56,8 +140,20 @@ int
 Annuary::remove(const std::string& name, const std::string& uri) {
   boost::lock_guard<boost::recursive_mutex> lock(mmutex);
   is_server helper(name, uri);
-  mservers.erase(std::remove_if(mservers.begin(), mservers.end(), helper),
-                 mservers.end());
+  ServerList removed;
+  std::remove_copy_if(msnapshot->servers.begin(), msnapshot->servers.end(),
+                      std::back_inserter(removed), !boost::bind<bool>(helper, _1));
+  if (!removed.empty()) {
+    boost::shared_ptr<Snapshot> snap = boost::make_shared<Snapshot>(*msnapshot);
+    ServerList::const_iterator it;
+    for (it = removed.begin(); it != removed.end(); ++it) {
+      eraseServer(*snap, *it);
+    }
+    boost::atomic_store(&msnapshot, boost::shared_ptr<const Snapshot>(snap));
+  }
+  mloads.erase(uri);
+  mliveness.erase(uri);
+  setSuspect(uri, false);
   return 0;
 }
 
@@ -65,27 +161,132 @@ Annuary::remove(const std::string& name, const std::string& uri) {
 // Note: we're using copy elision optimization here, no useless copy
 std::vector<boost::shared_ptr<Server> >
 Annuary::get(const std::string& service) {
-  boost::lock_guard<boost::recursive_mutex> lock(mmutex);
-  std::vector<boost::shared_ptr<Server> > res;
+  boost::shared_ptr<const Snapshot> snap = snapshot();
 
   if (service.empty()) {
-    res.assign(mservers.begin(), mservers.end());
+    return snap->servers;
+  }
+  ServiceIndex::const_iterator it = snap->index.find(service);
+  if (it == snap->index.end()) {
+    return std::vector<boost::shared_ptr<Server> >();
+  }
+  return *it->second;
+}
+
+void
+Annuary::setElectionStrategy(boost::shared_ptr<ElectionStrategy> strategy) {
+  boost::atomic_store(&melection, strategy);
+}
+
+std::string
+Annuary::elect(const std::string& service) {
+  boost::shared_ptr<const Snapshot> snap = snapshot();
+  ServiceIndex::const_iterator entry = snap->index.find(service);
+  if (entry == snap->index.end()) {
+    return "";
+  }
+  const ServerList& serv = *entry->second;
+
+  // suspect servers are kept as a last resort
+  boost::shared_ptr<const SuspectSet> suspects = boost::atomic_load(&msuspects);
+  ServerList alive;
+  if (!suspects->empty()) {
+    ServerList::const_iterator it;
+    for (it = serv.begin(); it != serv.end(); ++it) {
+      if (suspects->count((*it)->getURI()) == 0) {
+        alive.push_back(*it);
+      }
+    }
+  }
+  const ServerList& eligible = alive.empty() ? serv : alive;
+
+  boost::shared_ptr<ElectionStrategy> election = boost::atomic_load(&melection);
+  if (!election->usesLoads()) {
+    return election->elect(eligible, NO_LOADS);
+  }
+  // the loads change with each request
+  boost::lock_guard<boost::recursive_mutex> lock(mmutex);
+  return election->elect(eligible, mloads);
+}
+
+void
+Annuary::beginRequest(const std::string& uri) {
+  boost::lock_guard<boost::recursive_mutex> lock(mmutex);
+  ++mloads[uri].inFlight;
+}
+
+void
+Annuary::endRequest(const std::string& uri, double elapsed) {
+  boost::lock_guard<boost::recursive_mutex> lock(mmutex);
+  ServerLoad& load = mloads[uri];
+  if (load.inFlight > 0) {
+    --load.inFlight;
+  }
+  if (load.requests == 0) {
+    load.latency = elapsed;
   } else {
-    std::remove_copy_if(mservers.begin(), mservers.end(),
-                        std::back_inserter(res),
-                        !boost::bind(&Server::hasService, _1, service));
+    load.latency = LATENCY_EWMA_ALPHA * elapsed +
+      (1. - LATENCY_EWMA_ALPHA) * load.latency;
   }
-  return res;
+  ++load.requests;
 }
 
+ServerLoad
+Annuary::getLoad(const std::string& uri) const {
+  boost::lock_guard<boost::recursive_mutex> lock(mmutex);
+  ServerLoadMap::const_iterator it = mloads.find(uri);
+  return (it != mloads.end()) ? it->second : ServerLoad();
+}
 
 void
-Annuary::print() {
+Annuary::markAlive(const std::string& uri, double rtt) {
   boost::lock_guard<boost::recursive_mutex> lock(mmutex);
-  if (!mservers.empty()) {
+  ServerLiveness& liveness = mliveness[uri];
+  liveness.missed = 0;
+  liveness.rtt = rtt;
+  liveness.lastSeen = boost::posix_time::microsec_clock::universal_time();
+  setSuspect(uri, false);
+}
+
+unsigned int
+Annuary::markMissed(const std::string& uri) {
+  boost::lock_guard<boost::recursive_mutex> lock(mmutex);
+  setSuspect(uri, true);
+  return ++mliveness[uri].missed;
+}
+
+ServerLiveness
+Annuary::getLiveness(const std::string& uri) const {
+  boost::lock_guard<boost::recursive_mutex> lock(mmutex);
+  std::map<std::string, ServerLiveness>::const_iterator it = mliveness.find(uri);
+  return (it != mliveness.end()) ? it->second : ServerLiveness();
+}
+
+bool
+Annuary::isSuspect(const std::string& uri) const {
+  return boost::atomic_load(&msuspects)->count(uri) > 0;
+}
+
+void
+Annuary::setSweepDuration(double duration) {
+  boost::lock_guard<boost::recursive_mutex> lock(mmutex);
+  msweepDuration = duration;
+}
+
+double
+Annuary::getSweepDuration() const {
+  boost::lock_guard<boost::recursive_mutex> lock(mmutex);
+  return msweepDuration;
+}
+
+
+void
+Annuary::print() {
+  boost::shared_ptr<const Snapshot> snap = snapshot();
+  if (!snap->servers.empty()) {
     std::cerr << "\n==== Initial startup services ====\n";
     std::vector<boost::shared_ptr<Server> >::const_iterator it;
-    for (it = mservers.begin(); it != mservers.end(); ++it) {
+    for (it = snap->servers.begin(); it != snap->servers.end(); ++it) {
       std::cerr << "" << it->get()->getName() << ": " << it->get()->getURI() << "\n";
     }
     std::cerr << "==================================\n";
@@ -103,6 +304,7 @@ Annuary::print() {
 void
 Annuary::setInitConfig(const std::string& module, std::vector<std::string>& cfgInfo, std::string mid) {
   boost::lock_guard<boost::recursive_mutex> lock(mmutex);
+  boost::shared_ptr<Snapshot> snap = boost::make_shared<Snapshot>(*msnapshot);
   BOOST_FOREACH(const std::string& entry, cfgInfo) {
     std::istringstream iss(entry);
     std::string uri;
@@ -114,8 +316,9 @@ Annuary::setInitConfig(const std::string& module, std::vector<std::string>& cfgI
     }
     std::vector<std::string> services;
     fillServices(services, module, mid_tmp);
-    mservers.push_back(boost::make_shared<Server>(module, services, uri));
+    insertServer(*snap, boost::make_shared<Server>(module, services, uri));
   }
+  boost::atomic_store(&msnapshot, boost::shared_ptr<const Snapshot>(snap));
 }
 
 void
@@ -7,22 +7,59 @@
 #define __ANNUARY__H__
 
 #include "Server.hpp"
+#include "ElectionStrategy.hpp"
+#include <map>
+#include <set>
 #include <string>
 #include <vector>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
 #include <boost/thread/recursive_mutex.hpp>
 
 
+/**
+ * \struct ServerLiveness
+ * \brief Result of the heartbeats sent to a server
+ */
+struct ServerLiveness {
+  /**
+   * \brief Constructor
+   */
+  ServerLiveness() : missed(0), rtt(0.) {}
+  /**
+   * \brief Number of consecutive heartbeats left unanswered, a server
+   * which missed one is suspect
+   */
+  unsigned int missed;
+  /**
+   * \brief Round trip time (ms) of the last answered heartbeat
+   */
+  double rtt;
+  /**
+   * \brief Time of the last answered heartbeat
+   */
+  boost::posix_time::ptime lastSeen;
+};
+
 /**
  * \brief This class represents the annuary to store the services
  * \class Annuary
+ *
+ * The servers are kept in an immutable snapshot indexed by service name.
+ * Writers build a new snapshot from the current one, sharing the lists of
+ * the services they don't touch, and publish it atomically. Readers only
+ * grab the current snapshot, so looking up a service takes no lock and
+ * doesn't depend on the number of servers. The suspect servers and the
+ * election strategy are published the same way, so that an election only
+ * locks the annuary when its strategy reads the loads.
  */
 class Annuary {
 public:
   /**
    * \brief Default constructor
    */
-  Annuary() {}
+  Annuary();
   /**
    * \brief Constructor
    * \param serv
@@ -61,6 +98,91 @@ public:
   std::vector<boost::shared_ptr<Server> >
   get(const std::string& service = "");
 
+  /**
+   * \brief Set the strategy used to elect a server
+   * \param strategy The election strategy
+   */
+  void
+  setElectionStrategy(boost::shared_ptr<ElectionStrategy> strategy);
+
+  /**
+   * \brief Elect a server among those offering a service
+   * \param service The name of the desired service
+   * \return The uri of the elected server, empty if none offers the service
+   */
+  std::string
+  elect(const std::string& service);
+
+  /**
+   * \brief Record a request forwarded to a server
+   * \param uri The uri of the server
+   */
+  void
+  beginRequest(const std::string& uri);
+
+  /**
+   * \brief Record the end of a request forwarded to a server
+   * \param uri The uri of the server
+   * \param elapsed The RPC time in milliseconds
+   */
+  void
+  endRequest(const std::string& uri, double elapsed);
+
+  /**
+   * \brief Get the load observed on a server
+   * \param uri The uri of the server
+   * \return The load of the server
+   */
+  ServerLoad
+  getLoad(const std::string& uri) const;
+
+  /**
+   * \brief Record a heartbeat answered by a server
+   * \param uri The uri of the server
+   * \param rtt The round trip time in milliseconds
+   */
+  void
+  markAlive(const std::string& uri, double rtt);
+
+  /**
+   * \brief Record a heartbeat left unanswered by a server, it becomes
+   * suspect and is only elected when no other server offers the service
+   * \param uri The uri of the server
+   * \return The number of consecutive heartbeats missed
+   */
+  unsigned int
+  markMissed(const std::string& uri);
+
+  /**
+   * \brief Get the heartbeat record of a server
+   * \param uri The uri of the server
+   * \return The liveness of the server
+   */
+  ServerLiveness
+  getLiveness(const std::string& uri) const;
+
+  /**
+   * \brief Tells whether a server missed its last heartbeat
+   * \param uri The uri of the server
+   * \return true if the server is suspect
+   */
+  bool
+  isSuspect(const std::string& uri) const;
+
+  /**
+   * \brief Record the duration of the last heartbeat sweep
+   * \param duration The duration in milliseconds
+   */
+  void
+  setSweepDuration(double duration);
+
+  /**
+   * \brief Get the duration of the last heartbeat sweep
+   * \return The duration in milliseconds
+   */
+  double
+  getSweepDuration() const;
+
   //TODO: clean later
   /**
    * \brief Init the annuary from a file
@@ -87,6 +209,67 @@ public:
   print();
 
 private :
+  /**
+   * \brief A list of servers
+   */
+  typedef std::vector<boost::shared_ptr<Server> > ServerList;
+  /**
+   * \brief The servers offering each service
+   */
+  typedef boost::unordered_map<std::string,
+                               boost::shared_ptr<const ServerList> > ServiceIndex;
+  /**
+   * \brief The uris of the servers which missed their last heartbeat
+   */
+  typedef std::set<std::string> SuspectSet;
+
+  /**
+   * \struct Snapshot
+   * \brief An immutable state of the annuary
+   */
+  struct Snapshot {
+    /**
+     * \brief The servers in registration order
+     */
+    ServerList servers;
+    /**
+     * \brief The servers indexed by service
+     */
+    ServiceIndex index;
+  };
+
+  /**
+   * \brief Get the current snapshot, without locking
+   * \return the snapshot
+   */
+  boost::shared_ptr<const Snapshot>
+  snapshot() const;
+
+  /**
+   * \brief Add a server to a snapshot being built
+   * \param snap the snapshot
+   * \param server the server
+   */
+  static void
+  insertServer(Snapshot& snap, boost::shared_ptr<Server> server);
+
+  /**
+   * \brief Remove a server from a snapshot being built
+   * \param snap the snapshot
+   * \param server the server
+   */
+  static void
+  eraseServer(Snapshot& snap, boost::shared_ptr<Server> server);
+
+  /**
+   * \brief Publish a new set of suspect servers if a server changes state,
+   * called with the lock held
+   * \param uri The uri of the server
+   * \param suspect Whether the server is suspect
+   */
+  void
+  setSuspect(const std::string& uri, bool suspect);
+
   /**
    * \brief Fill the services for a given server name. Function used to easily create services from given names
    * \param services OUT, the list of services for name
@@ -98,12 +281,38 @@ private :
                const std::string& mid);
 
   /**
-   * \brief The servers
+   * \brief The current snapshot of the servers, only replaced as a whole
+   */
+  boost::shared_ptr<const Snapshot> msnapshot;
+
+  /**
+   * \brief The load of the servers indexed by uri
+   */
+  ServerLoadMap mloads;
+
+  /**
+   * \brief The heartbeat records of the servers indexed by uri
+   */
+  std::map<std::string, ServerLiveness> mliveness;
+
+  /**
+   * \brief The suspect servers, only replaced as a whole
+   */
+  boost::shared_ptr<const SuspectSet> msuspects;
+
+  /**
+   * \brief The duration (ms) of the last heartbeat sweep
+   */
+  double msweepDuration;
+
+  /**
+   * \brief The strategy used to elect servers, only replaced as a whole
    */
-  std::vector<boost::shared_ptr<Server> > mservers;
+  boost::shared_ptr<ElectionStrategy> melection;
 
   /**
-   * \brief mutex to lock the annuary
+   * \brief mutex to lock the annuary, readers of the snapshot, of the
+   * suspects and of the strategy don't need it
    */
   mutable boost::recursive_mutex mmutex;
 };
@@ -0,0 +1,269 @@
+#include "AsyncClient.hpp"
+
+#include <vector>
+#include <boost/bind.hpp>
+#include <boost/format.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/thread/future.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include "ConnectionPool.hpp"
+#include "VishnuException.hpp"
+
+// anonymous namespace
+namespace {
+  /**
+   * \brief Maximum time (ms) the I/O thread sleeps when nothing is pending
+   */
+  const long IDLE_POLL_INTERVAL = 1000;
+
+  /**
+   * \brief Completion callback used to implement the future interface
+   */
+  void
+  fulfill(boost::shared_ptr<boost::promise<int> > promise,
+          diet_profile_t* prof,
+          int status,
+          boost::shared_ptr<diet_profile_t> result) {
+    if (status == 0 && result) {
+      prof->param_count = result->param_count;
+      prof->params = result->params;
+    }
+    promise->set_value(status);
+  }
+}
+
+AsyncCallback
+AsyncClient::makeFutureCallback(diet_profile_t* prof,
+                                boost::shared_ptr<boost::promise<int> > promise) {
+  return boost::bind(&fulfill, promise, prof, _1, _2);
+}
+
+AsyncClient::AsyncClient(const std::string& uri, int timeout, bool routed)
+  : muri(uri), mrouted(routed), mtimeout(boost::posix_time::seconds(timeout)),
+    msubmitUri(boost::str(boost::format("inproc://vishnu-async-%1%") % this)),
+    mlastId(0), mready(false) {
+  mthread = boost::thread(boost::bind(&AsyncClient::run, this));
+
+  // inproc endpoints must be bound before we connect to them
+  boost::unique_lock<boost::mutex> lock(mpendingMutex);
+  while (!mready) {
+    mreadyCond.wait(lock);
+  }
+  msubmit.reset(new Socket(ConnectionPool::getInstance().getContext(),
+                           ZMQ_PUSH));
+  msubmit->connect(msubmitUri);
+}
+
+AsyncClient::~AsyncClient() {
+  {
+    // a lone empty frame stops the I/O thread
+    boost::lock_guard<boost::mutex> lock(msubmitMutex);
+    msubmit->send("");
+  }
+  mthread.join();
+}
+
+void
+AsyncClient::call(diet_profile_t* prof, const AsyncCallback& callback,
+                  int timeout) {
+  std::string payload = my_serialize_request(prof);
+  std::string id;
+  {
+    // register the request before sending it so that its answer can't
+    // get in first
+    boost::lock_guard<boost::mutex> lock(mpendingMutex);
+    id = boost::lexical_cast<std::string>(++mlastId);
+    PendingRequest& req = mpending[id];
+    req.callback = callback;
+    req.deadline = boost::posix_time::microsec_clock::universal_time() +
+      ((timeout < 0) ? mtimeout : boost::posix_time::seconds(timeout));
+  }
+
+  boost::lock_guard<boost::mutex> lock(msubmitMutex);
+  msubmit->send(id, ZMQ_SNDMORE);
+  if (mrouted) {
+    msubmit->send(prof->name, ZMQ_SNDMORE);
+  }
+  msubmit->sendZeroCopy(payload);
+}
+
+boost::unique_future<int>
+AsyncClient::call(diet_profile_t* prof) {
+  boost::shared_ptr<boost::promise<int> > promise =
+    boost::make_shared<boost::promise<int> >();
+  call(prof, makeFutureCallback(prof, promise));
+  return promise->get_future();
+}
+
+size_t
+AsyncClient::getPendingCount() const {
+  boost::lock_guard<boost::mutex> lock(mpendingMutex);
+  return mpending.size();
+}
+
+const std::string&
+AsyncClient::getURI() const {
+  return muri;
+}
+
+void
+AsyncClient::run() {
+  zmq::context_t& ctx = ConnectionPool::getInstance().getContext();
+  Socket submitSocket(ctx, ZMQ_PULL);
+  submitSocket.setLinger(0);
+  submitSocket.bind(msubmitUri.c_str());
+
+  Socket sock(ctx, ZMQ_DEALER);
+  sock.setLinger(0);
+  sock.connect(muri);
+
+  {
+    boost::lock_guard<boost::mutex> lock(mpendingMutex);
+    mready = true;
+  }
+  mreadyCond.notify_all();
+
+  bool running(true);
+  while (running) {
+    long wait = expireRequests();
+    zmq::pollitem_t items[] = {
+      {submitSocket, 0, ZMQ_POLLIN, 0},
+      {sock, 0, ZMQ_POLLIN, 0}
+    };
+
+    try {
+      zmq::poll(&items[0], 2, wait * 1000);
+    } catch (const zmq::error_t& e) {
+      if (EINTR == e.num()) {
+        continue;
+      }
+      std::cerr << boost::format("E: async client poll failed (%1%)\n") % e.what();
+      break;
+    }
+
+    if (items[1].revents & ZMQ_POLLIN) {
+      dispatchReply(sock);
+    }
+    if (items[0].revents & ZMQ_POLLIN) {
+      running = forwardRequest(submitSocket, sock);
+    }
+  }
+
+  // fail everything still in flight
+  std::vector<std::string> ids;
+  {
+    boost::lock_guard<boost::mutex> lock(mpendingMutex);
+    PendingMap::const_iterator it;
+    for (it = mpending.begin(); it != mpending.end(); ++it) {
+      ids.push_back(it->first);
+    }
+  }
+  std::vector<std::string>::const_iterator it;
+  for (it = ids.begin(); it != ids.end(); ++it) {
+    complete(*it, -1, boost::shared_ptr<diet_profile_t>());
+  }
+}
+
+bool
+AsyncClient::forwardRequest(Socket& submitSocket, Socket& sock) {
+  std::string id = submitSocket.get();
+  if (!submitSocket.hasMore()) {
+    return false;
+  }
+  std::string payload = submitSocket.get();
+  std::string routing;
+  if (submitSocket.hasMore()) {
+    routing.swap(payload);
+    payload = submitSocket.get();
+  }
+
+  // the id frame is part of the envelope echoed back by the server
+  try {
+    sock.send(id, ZMQ_SNDMORE);
+    sock.sendDelimiter();
+    if (!routing.empty()) {
+      sock.send(routing, ZMQ_SNDMORE);
+    }
+    sock.sendZeroCopy(payload);
+  } catch (const zmq::error_t& e) {
+    std::cerr << boost::format("E: request to %1% failed (%2%)\n") % muri % e.what();
+    complete(id, -1, boost::shared_ptr<diet_profile_t>());
+  }
+  return true;
+}
+
+void
+AsyncClient::dispatchReply(Socket& sock) {
+  std::string id = sock.get();
+  std::string response;
+  // skip the empty delimiter, the last frame holds the answer
+  while (sock.hasMore()) {
+    response = sock.get();
+  }
+
+  boost::shared_ptr<diet_profile_t> result;
+  int status(1);
+  try {
+    result = my_deserialize(response);
+    // To signal a communication problem (bad server receive request)
+    if (result && result->param_count != -1) {
+      status = 0;
+    }
+  } catch (const VishnuException& ex) {
+    std::cerr << boost::format("[ERROR] %1%\n") % response;
+  }
+  complete(id, status, result);
+}
+
+long
+AsyncClient::expireRequests() {
+  using boost::posix_time::ptime;
+  using boost::posix_time::microsec_clock;
+
+  std::vector<std::string> expired;
+  long wait(IDLE_POLL_INTERVAL);
+  {
+    ptime now = microsec_clock::universal_time();
+    boost::lock_guard<boost::mutex> lock(mpendingMutex);
+    PendingMap::const_iterator it;
+    for (it = mpending.begin(); it != mpending.end(); ++it) {
+      if (it->second.deadline <= now) {
+        expired.push_back(it->first);
+      } else {
+        wait = std::min(wait, static_cast<long>(
+                          (it->second.deadline - now).total_milliseconds() + 1));
+      }
+    }
+  }
+
+  std::vector<std::string>::const_iterator it;
+  for (it = expired.begin(); it != expired.end(); ++it) {
+    std::cerr << boost::format("W: no response from %1%, request dropped\n") % muri;
+    complete(*it, -1, boost::shared_ptr<diet_profile_t>());
+  }
+  return wait;
+}
+
+void
+AsyncClient::complete(const std::string& id, int status,
+                      boost::shared_ptr<diet_profile_t> result) {
+  AsyncCallback callback;
+  {
+    boost::lock_guard<boost::mutex> lock(mpendingMutex);
+    PendingMap::iterator it = mpending.find(id);
+    if (it == mpending.end()) {
+      // late answer of an expired request
+      return;
+    }
+    callback = it->second.callback;
+    mpending.erase(it);
+  }
+
+  try {
+    callback(status, result);
+  } catch (const std::exception& e) {
+    std::cerr << boost::format("E: async callback failed (%1%)\n") % e.what();
+  }
+}
@@ -0,0 +1,205 @@
+/**
+ * \file AsyncClient.hpp
+ * \brief This file defines the asynchronous multiplexed client
+ * \author Haikel Guemar (haikel.guemar@sysfera.com)
+ */
+#ifndef _ASYNCCLIENT_HPP_
+#define _ASYNCCLIENT_HPP_
+
+#include <map>
+#include <string>
+#include <stdint.h>
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+#include <boost/thread/future.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include "DIET_client.h"
+#include "zhelpers.hpp"
+
+/**
+ * \class AsyncClient
+ * \brief Sends many requests to a server over a single DEALER socket.
+ *
+ * Each request is framed as [request id][empty][payload], with the name of
+ * the service in a routing frame ahead of the payload when talking to the
+ * dispatcher. The server side
+ * ROUTER/REP pair echoes the envelope back untouched, so the replies are
+ * correlated with their requests using the id frame, whatever the order
+ * in which they are answered. A single I/O thread owns the DEALER socket;
+ * callers submit their requests through an inproc socket and get
+ * either a callback or a future.
+ */
+class AsyncClient : public boost::noncopyable {
+public:
+  /**
+   * \brief Constructor
+   * \param uri the uri of the server (or dispatcher)
+   * \param timeout the deadline of each request in seconds
+   * \param routed whether the name of the service is sent in a routing
+   * frame ahead of the profile (for the dispatcher)
+   */
+  AsyncClient(const std::string& uri, int timeout = DEFAULT_TIMEOUT,
+              bool routed = false);
+
+  /**
+   * \brief Destructor, fails all the pending requests
+   */
+  ~AsyncClient();
+
+  /**
+   * \brief Send a request, the callback is fired from the I/O thread
+   * once the answer is received or the deadline expired
+   * \param prof the profile to send
+   * \param callback the completion callback
+   * \param timeout the deadline of this request in seconds (default: the
+   * one of the client)
+   */
+  void
+  call(diet_profile_t* prof, const AsyncCallback& callback, int timeout = -1);
+
+  /**
+   * \brief Send a request and return a future. On success, the out
+   * parameters of prof are updated, so prof must remain valid until the
+   * future is ready.
+   * \param prof the profile to send
+   * \return a future holding 0 on success, an error code otherwise
+   */
+  boost::unique_future<int>
+  call(diet_profile_t* prof);
+
+  /**
+   * \brief Build a callback updating the out parameters of prof and
+   * fulfilling a promise with the status of the call
+   * \param prof the profile to update
+   * \param promise the promise to fulfill
+   * \return the callback
+   */
+  static AsyncCallback
+  makeFutureCallback(diet_profile_t* prof,
+                     boost::shared_ptr<boost::promise<int> > promise);
+
+  /**
+   * \brief Get the number of requests waiting for an answer
+   */
+  size_t
+  getPendingCount() const;
+
+  /**
+   * \brief Get the uri of the server
+   */
+  const std::string&
+  getURI() const;
+
+private:
+  /**
+   * \struct PendingRequest
+   * \brief A request sent and waiting for its answer
+   */
+  struct PendingRequest {
+    /**
+     * \brief The completion callback
+     */
+    AsyncCallback callback;
+    /**
+     * \brief The deadline of the request
+     */
+    boost::posix_time::ptime deadline;
+  };
+
+  /**
+   * \brief The pending requests indexed by request id
+   */
+  typedef std::map<std::string, PendingRequest> PendingMap;
+
+  /**
+   * \brief I/O thread body
+   */
+  void
+  run();
+
+  /**
+   * \brief Forward a submitted request to the server
+   * \param submitSocket the inproc socket receiving the submissions
+   * \param sock the DEALER socket
+   * \return false when the I/O thread is asked to stop
+   */
+  bool
+  forwardRequest(Socket& submitSocket, Socket& sock);
+
+  /**
+   * \brief Read an answer and fire the matching callback
+   * \param sock the DEALER socket
+   */
+  void
+  dispatchReply(Socket& sock);
+
+  /**
+   * \brief Fail the requests whose deadline expired
+   * \return the time (ms) until the next deadline
+   */
+  long
+  expireRequests();
+
+  /**
+   * \brief Fire a callback and remove its request
+   * \param id the request id
+   * \param status the status of the call
+   * \param result the result profile
+   */
+  void
+  complete(const std::string& id, int status,
+           boost::shared_ptr<diet_profile_t> result);
+
+  /**
+   * \brief The uri of the server
+   */
+  std::string muri;
+  /**
+   * \brief Whether the requests carry a routing frame
+   */
+  bool mrouted;
+  /**
+   * \brief The deadline of each request
+   */
+  boost::posix_time::time_duration mtimeout;
+  /**
+   * \brief The inproc uri used to submit requests to the I/O thread
+   */
+  std::string msubmitUri;
+  /**
+   * \brief The socket used by callers to submit requests
+   */
+  boost::scoped_ptr<Socket> msubmit;
+  /**
+   * \brief Mutex serializing the callers on the submission socket
+   */
+  boost::mutex msubmitMutex;
+  /**
+   * \brief The last request id
+   */
+  uint64_t mlastId;
+  /**
+   * \brief The pending requests
+   */
+  PendingMap mpending;
+  /**
+   * \brief Mutex protecting the pending requests
+   */
+  mutable boost::mutex mpendingMutex;
+  /**
+   * \brief Tells whether the I/O thread is ready
+   */
+  bool mready;
+  /**
+   * \brief Condition signaled once the I/O thread is ready
+   */
+  boost::condition_variable mreadyCond;
+  /**
+   * \brief The I/O thread
+   */
+  boost::thread mthread;
+};
+
+#endif /* _ASYNCCLIENT_HPP_ */
@@ -0,0 +1,118 @@
+#include "BinaryProfile.hpp"
+
+#include <arpa/inet.h>
+#include <stdint.h>
+#include <cstring>
+
+#include "SystemException.hpp"
+
+const std::string BinaryProfile::MAGIC("\x01VBP", 4);
+const char BinaryProfile::TRAILER = '\x04';
+
+// anonymous namespace
+namespace {
+  /**
+   * \brief Append a 32 bits integer in network byte order
+   */
+  void
+  putInt(std::string& out, uint32_t value) {
+    uint32_t net = htonl(value);
+    out.append(reinterpret_cast<const char*>(&net), sizeof(net));
+  }
+
+  /**
+   * \brief Append a length-prefixed field
+   */
+  void
+  putField(std::string& out, const std::string& value) {
+    putInt(out, static_cast<uint32_t>(value.size()));
+    out.append(value);
+  }
+
+  /**
+   * \brief Read a 32 bits integer in network byte order
+   */
+  uint32_t
+  getInt(const std::string& data, size_t& pos) {
+    if (data.size() - pos < sizeof(uint32_t)) {
+      throw SystemException(ERRCODE_INVDATA, "Truncated binary profile");
+    }
+    uint32_t net;
+    memcpy(&net, data.data() + pos, sizeof(net));
+    pos += sizeof(net);
+    return ntohl(net);
+  }
+
+  /**
+   * \brief Read a length-prefixed field
+   */
+  void
+  getField(const std::string& data, size_t& pos, std::string& value) {
+    uint32_t len = getInt(data, pos);
+    if (data.size() - pos < len) {
+      throw SystemException(ERRCODE_INVDATA, "Truncated binary profile");
+    }
+    value.assign(data, pos, len);
+    pos += len;
+  }
+}
+
+std::string
+BinaryProfile::serialize(diet_profile_t* prof) {
+  if (!prof) {
+    throw SystemException(ERRCODE_SYSTEM, "Cannot serialize a null pointer profile");
+  }
+
+  size_t size = MAGIC.size() + 2 * sizeof(uint32_t) + prof->name.size() + 1;
+  for (int i = 0; i < prof->param_count; ++i) {
+    size += sizeof(uint32_t) + prof->params[i].size();
+  }
+
+  std::string out;
+  out.reserve(size);
+  out.append(MAGIC);
+  putInt(out, static_cast<uint32_t>(prof->param_count));
+  putField(out, prof->name);
+  for (int i = 0; i < prof->param_count; ++i) {
+    putField(out, prof->params[i]);
+  }
+  out.push_back(TRAILER);
+  return out;
+}
+
+boost::shared_ptr<diet_profile_t>
+BinaryProfile::deserialize(const std::string& data) {
+  if (!isBinary(data)) {
+    throw SystemException(ERRCODE_INVDATA, "Not a binary profile");
+  }
+  if (data[data.size() - 1] != TRAILER) {
+    throw SystemException(ERRCODE_INVDATA, "Truncated binary profile");
+  }
+
+  boost::shared_ptr<diet_profile_t> profile(new diet_profile_t);
+  size_t pos = MAGIC.size();
+  profile->param_count = static_cast<int32_t>(getInt(data, pos));
+  getField(data, pos, profile->name);
+  if (profile->param_count > 0) {
+    // each parameter takes at least its length
+    if ((data.size() - pos) / sizeof(uint32_t) <
+        static_cast<size_t>(profile->param_count)) {
+      throw SystemException(ERRCODE_INVDATA,
+                            "Incoherent profile, wrong number of parameters");
+    }
+    profile->params.resize(profile->param_count);
+    for (int i = 0; i < profile->param_count; ++i) {
+      getField(data, pos, profile->params[i]);
+    }
+  }
+  if (pos != data.size() - 1) {
+    throw SystemException(ERRCODE_INVDATA,
+                          "Incoherent profile, wrong number of parameters");
+  }
+  return profile;
+}
+
+bool
+BinaryProfile::isBinary(const std::string& data) {
+  return data.compare(0, MAGIC.size(), MAGIC) == 0;
+}
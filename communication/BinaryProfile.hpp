@@ -0,0 +1,64 @@
+/**
+ * \file BinaryProfile.hpp
+ * \brief This file defines the compact binary encoding of the profiles
+ * \author Haikel Guemar (haikel.guemar@sysfera.com)
+ */
+#ifndef _BINARYPROFILE_HPP_
+#define _BINARYPROFILE_HPP_
+
+#include <string>
+#include <boost/shared_ptr.hpp>
+#include "DIET_client.h"
+
+/**
+ * \class BinaryProfile
+ * \brief Encodes a profile as a sequence of length-prefixed fields
+ * instead of a JSON document, so that the parameters (often XML) are
+ * neither escaped nor parsed.
+ *
+ * Layout, integers are 32 bits in network byte order:
+ * magic, param_count, name length, name, then for each parameter its
+ * length and its bytes, and a trailer. The magic starts with a control
+ * character which can't start a JSON document, so both encodings can be
+ * told apart. The trailer is not a NUL, so that Socket::get, which drops
+ * the NUL ending the messages of older peers, leaves the profile whole
+ * when its last parameter is empty or ends with a NUL.
+ */
+class BinaryProfile {
+public:
+  /**
+   * \brief The first bytes of a binary profile
+   */
+  static const std::string MAGIC;
+
+  /**
+   * \brief The last byte of a binary profile
+   */
+  static const char TRAILER;
+
+  /**
+   * \brief Encode a profile
+   * \param prof The profile
+   * \return The encoded profile
+   */
+  static std::string
+  serialize(diet_profile_t* prof);
+
+  /**
+   * \brief Decode a profile
+   * \param data The encoded profile
+   * \return The profile
+   */
+  static boost::shared_ptr<diet_profile_t>
+  deserialize(const std::string& data);
+
+  /**
+   * \brief Tells whether some data is a binary profile
+   * \param data The data
+   * \return true if it starts with the magic
+   */
+  static bool
+  isBinary(const std::string& data);
+};
+
+#endif /* _BINARYPROFILE_HPP_ */
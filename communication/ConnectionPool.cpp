@@ -0,0 +1,121 @@
+#include "ConnectionPool.hpp"
+
+#include <unistd.h>
+#include <boost/make_shared.hpp>
+#include <boost/ref.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/once.hpp>
+
+ConnectionPool* ConnectionPool::minstance = NULL;
+
+namespace {
+  boost::once_flag poolOnceFlag = BOOST_ONCE_INIT;
+}
+
+ConnectionPool::ConnectionPool()
+  : mcontext(new zmq::context_t(1)), midle(new ConnectionMap),
+    mpid(getpid()) {}
+
+void
+ConnectionPool::createInstance() {
+  minstance = new ConnectionPool();
+}
+
+ConnectionPool&
+ConnectionPool::getInstance() {
+  boost::call_once(&ConnectionPool::createInstance, poolOnceFlag);
+  return *minstance;
+}
+
+zmq::context_t&
+ConnectionPool::getContext() {
+  boost::lock_guard<boost::mutex> lock(mmutex);
+  checkFork();
+  return *mcontext;
+}
+
+void
+ConnectionPool::checkFork() {
+  pid_t pid = getpid();
+  if (pid != mpid) {
+    // the parent's sockets and context must not be touched (not even
+    // closed) from the child, so we deliberately leak them
+    mcontext = new zmq::context_t(1);
+    midle = new ConnectionMap;
+    mpid = pid;
+  }
+}
+
+ConnectionPool::Connection
+ConnectionPool::acquire(const std::string& uri, int timeout, int verbosity) {
+  Connection conn;
+  zmq::context_t* ctx;
+  {
+    boost::lock_guard<boost::mutex> lock(mmutex);
+    checkFork();
+    ctx = mcontext;
+    ConnectionMap::iterator it = midle->find(uri);
+    if (it != midle->end() && !it->second.empty()) {
+      conn = it->second.back();
+      it->second.pop_back();
+    }
+  }
+
+  if (conn) {
+    conn->setTimeout(timeout);
+    conn->setVerbosity(verbosity);
+  } else {
+    conn = boost::make_shared<LazyPirateClient>(boost::ref(*ctx), uri,
+                                                timeout, verbosity);
+  }
+  return conn;
+}
+
+void
+ConnectionPool::release(Connection conn) {
+  boost::lock_guard<boost::mutex> lock(mmutex);
+  if (getpid() != mpid) {
+    // created before a fork, forget it
+    return;
+  }
+  std::vector<Connection>& conns = (*midle)[conn->getAddress()];
+  if (conns.size() < MAX_IDLE_CONNECTIONS) {
+    conns.push_back(conn);
+  }
+}
+
+bool
+ConnectionPool::call(const std::string& uri,
+                     const std::string& request,
+                     std::string& response,
+                     int timeout,
+                     int verbosity,
+                     const std::string& routing,
+                     int retries) {
+  Connection conn = acquire(uri, timeout, verbosity);
+  if (!conn->send(request, retries, routing)) {
+    // the REQ socket is stuck waiting for a reply, drop it so that the
+    // next call reconnects from scratch
+    return false;
+  }
+  conn->recv(response);
+  release(conn);
+  return true;
+}
+
+void
+ConnectionPool::clear() {
+  boost::lock_guard<boost::mutex> lock(mmutex);
+  checkFork();
+  midle->clear();
+}
+
+size_t
+ConnectionPool::getIdleCount(const std::string& uri) const {
+  boost::lock_guard<boost::mutex> lock(mmutex);
+  ConnectionMap::const_iterator it = midle->find(uri);
+  if (it == midle->end()) {
+    return 0;
+  }
+  return it->second.size();
+}
@@ -0,0 +1,152 @@
+/**
+ * \file ConnectionPool.hpp
+ * \brief This file defines the process-wide pool of client connections
+ * \author Haikel Guemar (haikel.guemar@sysfera.com)
+ */
+#ifndef _CONNECTIONPOOL_HPP_
+#define _CONNECTIONPOOL_HPP_
+
+#include <map>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include "zhelpers.hpp"
+
+/**
+ * \brief Maximum number of idle connections kept for a given uri
+ */
+const unsigned int MAX_IDLE_CONNECTIONS = 8;
+
+/**
+ * \class ConnectionPool
+ * \brief Keeps a single zmq context and long-lived REQ connections
+ * per server uri so that a client call doesn't pay the context setup
+ * and the TCP handshake each time.
+ *
+ * A REQ socket can only carry one request at a time, so connections are
+ * checked out for the duration of a call and given back afterwards.
+ * A connection that failed is dropped and a new one is created on the
+ * next call (reconnect on failure).
+ */
+class ConnectionPool : public boost::noncopyable {
+public:
+  /**
+   * \brief Get the pool of the process
+   * \return the pool
+   */
+  static ConnectionPool&
+  getInstance();
+
+  /**
+   * \brief Get the zmq context shared by the process
+   * \return the context
+   */
+  zmq::context_t&
+  getContext();
+
+  /**
+   * \brief Send a request and wait for the answer on a pooled connection
+   * \param uri The uri of the server
+   * \param request The serialized request
+   * \param response OUT, the answer of the server
+   * \param timeout The timeout in seconds
+   * \param verbosity The verbosity of the communication
+   * \param routing If not empty, sent in a frame ahead of the request
+   * \param retries The number of attempts before giving up
+   * \return true on success
+   */
+  bool
+  call(const std::string& uri,
+       const std::string& request,
+       std::string& response,
+       int timeout,
+       int verbosity = 1,
+       const std::string& routing = "",
+       int retries = DEFAULT_RETRIES);
+
+  /**
+   * \brief Drop all the idle connections
+   */
+  void
+  clear();
+
+  /**
+   * \brief Get the number of idle connections kept for an uri
+   * \param uri The uri of the server
+   * \return the number of idle connections
+   */
+  size_t
+  getIdleCount(const std::string& uri) const;
+
+private:
+  /**
+   * \brief Connection type
+   */
+  typedef boost::shared_ptr<LazyPirateClient> Connection;
+  /**
+   * \brief Idle connections indexed by uri
+   */
+  typedef std::map<std::string, std::vector<Connection> > ConnectionMap;
+
+  /**
+   * \brief Constructor, private since the pool is a singleton
+   */
+  ConnectionPool();
+
+  /**
+   * \brief Create the pool instance
+   */
+  static void
+  createInstance();
+
+  /**
+   * \brief Check out a connection to uri, creating it if needed
+   * \param uri The uri of the server
+   * \param timeout The timeout in seconds
+   * \param verbosity The verbosity of the communication
+   * \return the connection
+   */
+  Connection
+  acquire(const std::string& uri, int timeout, int verbosity);
+
+  /**
+   * \brief Give back a healthy connection to the pool
+   * \param conn The connection
+   */
+  void
+  release(Connection conn);
+
+  /**
+   * \brief Renew the context and forget the connections when we are
+   * running in a forked child (zmq contexts can't cross a fork).
+   * Must be called with the mutex held.
+   */
+  void
+  checkFork();
+
+  /**
+   * \brief The instance of the pool
+   */
+  static ConnectionPool* minstance;
+  /**
+   * \brief The context, never destroyed to avoid blocking at exit
+   */
+  zmq::context_t* mcontext;
+  /**
+   * \brief The idle connections
+   */
+  ConnectionMap* midle;
+  /**
+   * \brief The process which created the context
+   */
+  pid_t mpid;
+  /**
+   * \brief Mutex protecting the pool
+   */
+  mutable boost::mutex mmutex;
+};
+
+#endif /* _CONNECTIONPOOL_HPP_ */
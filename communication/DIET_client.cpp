@@ -14,20 +14,29 @@
 #include <sstream>
 #include <vector>
 #include <algorithm>                    // for copy, transform
+#include <deque>
 #include <stdexcept>                    // for out_of_range
 #include <utility>                      // for pair
+#include <unistd.h>
 #include <boost/algorithm/string/classification.hpp>
 #include <boost/algorithm/string/predicate.hpp>  // for starts_with
 #include <boost/algorithm/string/regex.hpp>  // for split_regex
 #include <boost/algorithm/string/split.hpp>
+#include <boost/bind.hpp>
 #include <boost/foreach.hpp>
 #include <boost/format.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/make_shared.hpp>
+#include <boost/enable_shared_from_this.hpp>
+#include <boost/thread/once.hpp>
 #include <zmq.hpp>                      // for context_t
 
 #include "constants.hpp"                // for ::DISP_URIADDR, etc
 #include "zhelpers.hpp"
+#include "ConnectionPool.hpp"
+#include "AsyncClient.hpp"
+#include "BinaryProfile.hpp"
+#include "ServerHealth.hpp"
 #include "SystemException.hpp"
 #include "ExecConfiguration.hpp"
 #include "TMSServices.hpp"
@@ -41,6 +50,8 @@ static ExecConfiguration config;
 typedef std::map<std::string, std::string> ServiceMap;
 boost::shared_ptr<ServiceMap> sMap;
 
+static boost::once_flag sMapOnceFlag = BOOST_ONCE_INIT;
+
 static void
 fill_sMap() {
   unsigned int nb;
@@ -67,7 +78,8 @@ std::string
 get_module(const std::string& service) {
   std::size_t pos = service.find("@");
   ServiceMap::const_iterator it;
-  fill_sMap();
+  // the service map is static data, build it only once
+  boost::call_once(&fill_sMap, sMapOnceFlag);
 
   if (std::string::npos != pos) {
     it = sMap->find(service.substr(0, pos));
@@ -134,9 +146,201 @@ diet_profile_reset(diet_profile_t* prof, int nbparams) {
   prof->params.resize(nbparams, "");
 }
 
+// anonymous namespace
+namespace {
+  typedef std::map<std::string, boost::shared_ptr<AsyncClient> > AsyncClientMap;
+  /**
+   * \brief The asynchronous clients, one per server uri. They are never
+   * destroyed (their I/O threads don't survive a fork, nor the exit)
+   */
+  AsyncClientMap* asyncClients = NULL;
+  /**
+   * \brief The process owning the asynchronous clients
+   */
+  pid_t asyncClientsPid = 0;
+  /**
+   * \brief Mutex protecting the asynchronous clients
+   */
+  boost::mutex asyncClientsMutex;
+
+  /**
+   * \brief Get the asynchronous client bound to uri, creating it if needed
+   * \param uri The uri of the server
+   * \param routed whether uri is a dispatcher expecting a routing frame
+   * \return the client
+   */
+  boost::shared_ptr<AsyncClient>
+  getAsyncClient(const std::string& uri, bool routed = false) {
+    boost::lock_guard<boost::mutex> lock(asyncClientsMutex);
+    if (!asyncClients || asyncClientsPid != getpid()) {
+      asyncClients = new AsyncClientMap;
+      asyncClientsPid = getpid();
+    }
+    boost::shared_ptr<AsyncClient>& client = (*asyncClients)[uri];
+    if (!client) {
+      client = boost::make_shared<AsyncClient>(uri, getTimeout(), routed);
+    }
+    return client;
+  }
+
+  /**
+   * \class ServerRace
+   * \brief Orders the candidate servers of a call by health. Servers that
+   * answered lately come first, in configuration order. The ones with an
+   * unknown health are probed in parallel with a short heartbeat and come
+   * next, in the order they answer. Servers in backoff are only tried when
+   * no other server could be reached.
+   *
+   * Only heartbeats are raced: the request itself is sent to one server at
+   * a time, since services such as jobSubmit or sessionConnect must not be
+   * executed twice.
+   */
+  class ServerRace : public boost::enable_shared_from_this<ServerRace> {
+  public:
+    /**
+     * \brief Create a race and launch the probes
+     * \param uris the candidate servers, in configuration order
+     * \param probe whether unknown servers may be probed asynchronously
+     * \return the race
+     */
+    static boost::shared_ptr<ServerRace>
+    start(const std::vector<std::string>& uris, bool probe) {
+      boost::shared_ptr<ServerRace> race(new ServerRace);
+      ServerHealth& health = ServerHealth::getInstance();
+      std::vector<std::string> toProbe;
+      std::vector<std::string>::const_iterator it;
+      for (it = uris.begin(); it != uris.end(); ++it) {
+        if (!health.isAvailable(*it)) {
+          race->mbackoff.push_back(*it);
+        } else if (!probe || health.isKnownHealthy(*it)) {
+          race->mready.push_back(*it);
+        } else {
+          toProbe.push_back(*it);
+        }
+      }
+
+      race->mprobing = toProbe.size();
+      for (it = toProbe.begin(); it != toProbe.end(); ++it) {
+        race->probe(*it);
+      }
+      return race;
+    }
+
+    /**
+     * \brief Get the next server to try, waiting for the probes if needed
+     * \param uri OUT, the server
+     * \return false when there is no more server to try
+     */
+    bool
+    next(std::string& uri) {
+      boost::unique_lock<boost::mutex> lock(mmutex);
+      while (mready.empty() && mprobing > 0) {
+        mcond.wait(lock);
+      }
+      if (!mready.empty()) {
+        uri = mready.front();
+        mready.pop_front();
+        mreached = true;
+        return true;
+      }
+      if (!mreached && !mbackoff.empty()) {
+        // nothing else answered, give a chance to the dead ones
+        uri = mbackoff.front();
+        mbackoff.pop_front();
+        return true;
+      }
+      return false;
+    }
+
+    /**
+     * \brief Tells whether the server returned by next is the last one
+     */
+    bool
+    isLast() const {
+      boost::lock_guard<boost::mutex> lock(mmutex);
+      return mready.empty() && mprobing == 0 && (mreached || mbackoff.empty());
+    }
+
+    /**
+     * \brief Tells whether some server was considered reachable
+     */
+    bool
+    hasReachedAny() const {
+      boost::lock_guard<boost::mutex> lock(mmutex);
+      return mreached;
+    }
+
+  private:
+    ServerRace() : mprobing(0), mreached(false) {}
+
+    /**
+     * \brief Probe a server with a short heartbeat
+     * \param uri the server
+     */
+    void
+    probe(const std::string& uri) {
+      diet_profile_t* profile = diet_profile_alloc("heartbeat", 0);
+      try {
+        getAsyncClient(uri)->call(profile,
+                                  boost::bind(&ServerRace::onProbe,
+                                              shared_from_this(), uri, _1, _2),
+                                  SHORT_TIMEOUT);
+      } catch (const std::exception& ex) {
+        onProbe(uri, -1, boost::shared_ptr<diet_profile_t>());
+      }
+      diet_profile_free(profile);
+    }
+
+    /**
+     * \brief Handle the answer of a probe
+     */
+    void
+    onProbe(const std::string& uri, int status,
+            boost::shared_ptr<diet_profile_t> result) {
+      if (status == 0) {
+        ServerHealth::getInstance().markSuccess(uri);
+      } else if (status == -1) {
+        ServerHealth::getInstance().markFailure(uri);
+      }
+      {
+        boost::lock_guard<boost::mutex> lock(mmutex);
+        if (status == 0) {
+          mready.push_back(uri);
+        }
+        --mprobing;
+      }
+      mcond.notify_all();
+    }
+
+    /**
+     * \brief Servers ready to be tried, in order
+     */
+    std::deque<std::string> mready;
+    /**
+     * \brief Servers in backoff
+     */
+    std::deque<std::string> mbackoff;
+    /**
+     * \brief Number of probes still running
+     */
+    size_t mprobing;
+    /**
+     * \brief Whether some server was considered reachable
+     */
+    bool mreached;
+    /**
+     * \brief Mutex protecting the race
+     */
+    mutable boost::mutex mmutex;
+    /**
+     * \brief Condition signaled when a probe completes
+     */
+    boost::condition_variable mcond;
+  };
+}
+
 int
 diet_call(diet_profile_t* prof) {
-  std::string uri;
   std::vector<std::string> uriv;
   std::string disp;
   std::vector<std::string> dispv;
@@ -161,8 +365,6 @@ diet_call(diet_profile_t* prof) {
   }
 
   config.getConfigValues(param, uriv);
-  std::vector<std::string> tokens;
-  boost::algorithm::split(tokens, service, boost::algorithm::is_any_of("@"));
 
   std::vector<boost::shared_ptr<Server> > allServers;
   extractMachineServersFromLine(uriv, allServers, "xmssed");
@@ -177,11 +379,30 @@ diet_call(diet_profile_t* prof) {
     return 1;
   }
 
+  std::vector<std::string> uris;
   std::vector<boost::shared_ptr<Server> >::iterator it;
   for (it = allServers.begin() ; it != allServers.end() ; ++it){
+    uris.push_back(it->get()->getURI());
+  }
+
+  bool useSsl = false;
+  config.getConfigValue<bool>(vishnu::USE_SSL, useSsl);
+  ServerHealth& health = ServerHealth::getInstance();
+  boost::shared_ptr<ServerRace> race = ServerRace::start(uris, !useSsl);
+  std::string uri;
+  while (race->next(uri)) {
+    // a single attempt per server while another one can take over, the
+    // dispatcher being the last resort
+    bool last = race->isLast() &&
+      (disp.empty() || (!health.isAvailable(disp) && race->hasReachedAny()));
     try{
       *prof = save;
-      int tmp = abstract_call_gen(prof, it->get()->getURI());
+      int tmp = abstract_call_gen(prof, uri, false, 1, last ? DEFAULT_RETRIES : 1);
+      if (tmp == -1) {
+        health.markFailure(uri);
+        continue;
+      }
+      health.markSuccess(uri);
       if (tmp == 0)
         // If is successful or return an error different of not finding the right service
         if (prof->params[0]=="success" || (prof->params[0]=="error" && prof->params[1].find("Service call failed for the profile") == std::string::npos)){
@@ -190,12 +411,22 @@ diet_call(diet_profile_t* prof) {
     } catch (...){
     }
   }
+
   int tmp = 1;
-  try{
-    if ( !disp.empty() )
+  // the dispatcher is the last resort, we skip it only while it is known
+  // to be dead and some server was reachable
+  if (!disp.empty() &&
+      (health.isAvailable(disp) || !race->hasReachedAny())) {
+    try{
       *prof = save;
-      tmp = abstract_call_gen(prof, disp);
-  } catch (...){
+      tmp = dispatcher_call_gen(prof, disp);
+      if (tmp == -1) {
+        health.markFailure(disp);
+      } else {
+        health.markSuccess(disp);
+      }
+    } catch (...){
+    }
   }
 
   if (tmp != 0)
@@ -205,17 +436,134 @@ diet_call(diet_profile_t* prof) {
   return tmp;//abstract_call_gen(prof, uri);
 }
 
-int
-diet_call_gen(diet_profile_t* prof, const std::string& uri, bool shortTimeout, int verbosity) {
+// anonymous namespace
+namespace {
+  /**
+   * \struct AsyncCall
+   * \brief State of an asynchronous diet_call trying each server in turn
+   */
+  struct AsyncCall {
+    /**
+     * \brief Copy of the profile to send
+     */
+    diet_profile_t profile;
+    /**
+     * \brief The candidate servers
+     */
+    std::vector<std::string> uris;
+    /**
+     * \brief The dispatcher, if it is among the candidates
+     */
+    std::string dispatcher;
+    /**
+     * \brief Index of the server currently tried
+     */
+    size_t current;
+    /**
+     * \brief The callback of the caller
+     */
+    AsyncCallback callback;
+  };
+
+  void
+  sendAsyncCall(boost::shared_ptr<AsyncCall> call);
+
+  /**
+   * \brief Handle the answer of a server, same acceptance rules as diet_call
+   */
+  void
+  onAsyncReply(boost::shared_ptr<AsyncCall> call, int status,
+               boost::shared_ptr<diet_profile_t> result) {
+    bool accepted = (status == 0 && result && result->params.size() > 1 &&
+                     (result->params[0] == "success" ||
+                      (result->params[0] == "error" &&
+                       result->params[1].find("Service call failed for the profile") == std::string::npos)));
+    if (accepted || ++call->current >= call->uris.size()) {
+      if (!accepted && status == 0) {
+        std::cerr << boost::format("No corresponding %1% server found\n") % call->profile.name;
+      }
+      call->callback(status, result);
+    } else {
+      sendAsyncCall(call);
+    }
+  }
+
+  void
+  sendAsyncCall(boost::shared_ptr<AsyncCall> call) {
+    const std::string& uri = call->uris[call->current];
+    getAsyncClient(uri, uri == call->dispatcher)
+      ->call(&call->profile, boost::bind(&onAsyncReply, call, _1, _2));
+  }
+}
+
+void
+diet_call_async(diet_profile_t* prof, const AsyncCallback& callback) {
+  boost::shared_ptr<AsyncCall> call = boost::make_shared<AsyncCall>();
+  call->profile = *prof;
+  call->current = 0;
+  call->callback = callback;
+
+  if (get_module(prof->name).empty()) {
+    std::cerr << boost::format("No corresponding %1% server found\n") % prof->name;
+    callback(1, boost::shared_ptr<diet_profile_t>());
+    return;
+  }
+
+  bool useSsl = false;
+  if (config.getConfigValue<bool>(vishnu::USE_SSL, useSsl) && useSsl) {
+    // the TLS client is synchronous, run the request right away
+    int rv = diet_call(&call->profile);
+    callback(rv, boost::make_shared<diet_profile_t>(call->profile));
+    return;
+  }
+
+  std::vector<std::string> uriv;
+  std::vector<boost::shared_ptr<Server> > allServers;
+  config.getConfigValues(vishnu::SED_URIADDR, uriv);
+  extractMachineServersFromLine(uriv, allServers, "xmssed");
+  std::vector<boost::shared_ptr<Server> >::const_iterator it;
+  for (it = allServers.begin(); it != allServers.end(); ++it) {
+    call->uris.push_back((*it)->getURI());
+  }
+
+  std::vector<std::string> dispv;
+  config.getConfigValues(vishnu::DISP_URIADDR, dispv);
+  if (!dispv.empty() && !dispv[0].empty()) {
+    call->dispatcher = dispv[0];
+    call->uris.push_back(dispv[0]);
+  }
+
+  if (call->uris.empty()) {
+    std::cerr << boost::format("No corresponding %1% server found\n") % prof->name;
+    callback(1, boost::shared_ptr<diet_profile_t>());
+    return;
+  }
+  sendAsyncCall(call);
+}
+
+boost::unique_future<int>
+diet_call_async(diet_profile_t* prof) {
+  boost::shared_ptr<boost::promise<int> > promise =
+    boost::make_shared<boost::promise<int> >();
+  diet_call_async(prof, AsyncClient::makeFutureCallback(prof, promise));
+  return promise->get_future();
+}
+
+/**
+ * \brief Call a service over zmq
+ * \param routing if not empty, the routing frame sent ahead of the profile
+ * \param retries the number of attempts before giving up
+ */
+static int
+zmq_call_gen(diet_profile_t* prof, const std::string& uri, bool shortTimeout,
+             int verbosity, const std::string& routing, int retries = DEFAULT_RETRIES) {
   int timeout = shortTimeout?SHORT_TIMEOUT:getTimeout();
-  zmq::context_t ctx(5);
-  LazyPirateClient lpc(ctx, uri, timeout, verbosity);
-  std::string s1 = my_serialize(prof);
-  if (!lpc.send(s1)) {
+  std::string response;
+  if (!ConnectionPool::getInstance().call(uri, my_serialize_request(prof), response,
+                                          timeout, verbosity, routing, retries)) {
     std::cerr << "E: request failed, exiting ...\n";
     return -1;
   }
-  std::string response = lpc.recv();
   boost::shared_ptr<diet_profile_t> result(my_deserialize(response));
   if (! result) {
     std::cerr << boost::format("[ERROR] %1%\n")%response;
@@ -232,6 +580,48 @@ diet_call_gen(diet_profile_t* prof, const std::string& uri, bool shortTimeout, i
   return 0;
 }
 
+int
+diet_call_gen(diet_profile_t* prof, const std::string& uri, bool shortTimeout, int verbosity,
+              int retries) {
+  return zmq_call_gen(prof, uri, shortTimeout, verbosity, "", retries);
+}
+
+int
+dispatcher_call_gen(diet_profile_t* prof, const std::string& uri, bool shortTimeout, int verbosity) {
+  bool useSsl = false;
+  if (config.getConfigValue<bool>(vishnu::USE_SSL, useSsl) && useSsl) {
+    // the TLS tunnel carries a single frame
+    return abstract_call_gen(prof, uri, shortTimeout, verbosity);
+  }
+  return zmq_call_gen(prof, uri, shortTimeout, verbosity, prof->name);
+}
+
+int
+raw_call_gen(const std::string& request, const std::string& uri,
+             std::string& response, bool shortTimeout, int verbosity) {
+  bool useSsl = false;
+  if (config.getConfigValue<bool>(vishnu::USE_SSL, useSsl) && useSsl) {
+    std::string cafile;
+    config.getConfigValue<std::string>(vishnu::SSL_CA, cafile);
+    TlsClient tlsClient(vishnu::getHostFromUri(uri),
+                        vishnu::getPortFromUri(uri), cafile);
+    if (tlsClient.send(request)) {
+      std::cerr << boost::format("[ERROR] %1%\n")%tlsClient.getErrorMsg();
+      return -1;
+    }
+    response = tlsClient.recv();
+    return 0;
+  }
+
+  int timeout = shortTimeout?SHORT_TIMEOUT:getTimeout();
+  if (!ConnectionPool::getInstance().call(uri, request, response,
+                                          timeout, verbosity)) {
+    std::cerr << "E: request failed, exiting ...\n";
+    return -1;
+  }
+  return 0;
+}
+
 int
 ssl_call_gen(diet_profile_t* prof,
              const std::string& host,
@@ -278,8 +668,28 @@ my_serialize(diet_profile_t* prof) {
   return JsonObject::serialize(prof);
 }
 
+std::string
+my_serialize_request(diet_profile_t* prof) {
+  bool binary = false;
+  if (config.getConfigValue<bool>(vishnu::BINARY_PROFILES, binary) && binary) {
+    return BinaryProfile::serialize(prof);
+  }
+  return my_serialize(prof);
+}
+
+std::string
+my_serialize_reply(diet_profile_t* prof, const std::string& request) {
+  if (BinaryProfile::isBinary(request)) {
+    return BinaryProfile::serialize(prof);
+  }
+  return my_serialize(prof);
+}
+
 boost::shared_ptr<diet_profile_t>
 my_deserialize(const std::string& prof) {
+  if (BinaryProfile::isBinary(prof)) {
+    return BinaryProfile::deserialize(prof);
+  }
   return JsonObject::deserialize(prof);
 }
 
@@ -312,12 +722,10 @@ communicate_dispatcher(const std::string& requestData, std::string& response, bo
       response = tlsClient.recv();
     }
   } else {
-    zmq::context_t ctx(1);
-    LazyPirateClient lpc(ctx, uriDispatcher, timeout, verbosity);
-    if (!lpc.send(requestData)) {
+    if (!ConnectionPool::getInstance().call(uriDispatcher, requestData,
+                                            response, timeout, verbosity)) {
       return -1; // Dont throw exception
     }
-    response = lpc.recv();
   }
 
   return 0;
@@ -339,7 +747,8 @@ extractServersFromMessage(std::string msg, std::vector<boost::shared_ptr<Server>
 }
 
 int
-abstract_call_gen(diet_profile_t* prof, const std::string& uri, bool shortTimeout, int verbosity){
+abstract_call_gen(diet_profile_t* prof, const std::string& uri, bool shortTimeout, int verbosity,
+                  int retries){
   bool useSsl = false;
   std::string cafile;
   if (config.getConfigValue<bool>(vishnu::USE_SSL, useSsl) && useSsl)
@@ -347,7 +756,7 @@ abstract_call_gen(diet_profile_t* prof, const std::string& uri, bool shortTimeou
     config.getConfigValue<std::string>(vishnu::SSL_CA, cafile);
     return ssl_call_gen(prof, vishnu::getHostFromUri(uri), vishnu::getPortFromUri(uri), cafile);
   }
-  return diet_call_gen(prof, uri, shortTimeout, verbosity);
+  return diet_call_gen(prof, uri, shortTimeout, verbosity, retries);
 }
 
 
@@ -10,7 +10,9 @@
 
 #include <string>
 #include <vector>
+#include <boost/function.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/thread/future.hpp>
 #include "sslhelpers.hpp"
 #include "Server.hpp"
 
@@ -49,6 +51,14 @@ typedef struct diet_profile_t {
 } diet_profile_t;
 
 
+/**
+ * \brief Callback fired when an asynchronous call completes
+ * The first argument is 0 on success, an error code otherwise.
+ * The second one is the result profile (empty on error).
+ */
+typedef boost::function2<void, int,
+                         boost::shared_ptr<diet_profile_t> > AsyncCallback;
+
 /**
  * \brief Overload of DIET function, allocate the profile of a service
  * \param name The name of the service
@@ -86,16 +96,58 @@ diet_string_set(diet_profile_t* prof, int pos, const std::string& value = "");
 int
 diet_call(diet_profile_t* prof);
 
+/**
+ * \brief Asynchronous version of diet_call. The request is multiplexed
+ * with the other pending ones on a single connection per server.
+ * \param prof The profile of the service to call, it is copied so it can
+ * be freed as soon as the function returns
+ * \param callback The callback fired with the result profile
+ */
+void
+diet_call_async(diet_profile_t* prof, const AsyncCallback& callback);
+
+/**
+ * \brief Asynchronous version of diet_call returning a future.
+ * \param prof The profile of the service to call, its out parameters are
+ * updated on success so it must remain valid until the future is ready
+ * \return A future holding 0 on success, an error code otherwise
+ */
+boost::unique_future<int>
+diet_call_async(diet_profile_t* prof);
+
 /**
  * \brief Generic function created to encapsulate the code
+ * \param retries The number of attempts before giving up
  */
 int
-diet_call_gen(diet_profile_t* prof, const std::string& uri, bool shortTimeout = false, int verbosity = 1);
+diet_call_gen(diet_profile_t* prof, const std::string& uri, bool shortTimeout = false, int verbosity = 1,
+              int retries = 3);
+/**
+ * \brief Call a service through the dispatcher. The name of the service is
+ * sent in a routing frame ahead of the profile, so that the dispatcher can
+ * forward the request without parsing it
+ */
+int
+dispatcher_call_gen(diet_profile_t* prof, const std::string& uri, bool shortTimeout = false, int verbosity = 1);
+/**
+ * \brief Send an already serialized request and get the raw answer,
+ * the payloads are neither parsed nor rebuilt
+ * \param request The serialized profile
+ * \param uri The uri of the server
+ * \param response OUT, the serialized answer
+ * \return 0 on success, an error code otherwise
+ */
+int
+raw_call_gen(const std::string& request, const std::string& uri,
+             std::string& response, bool shortTimeout = false, int verbosity = 1);
 /**
  * \brief Generic function created to encapsulate the code
+ * \param retries The number of attempts before giving up, a single one
+ * over TLS
  */
 int
-abstract_call_gen(diet_profile_t* prof, const std::string& uri, bool shortTimeout = false, int verbosity = 1);
+abstract_call_gen(diet_profile_t* prof, const std::string& uri, bool shortTimeout = false, int verbosity = 1,
+                  int retries = 3);
 /**
  * @brief ssl_call_gen
  * @param prof
@@ -145,7 +197,25 @@ std::string
 my_serialize(diet_profile_t* prof);
 
 /**
- * \brief To deserialize a profile
+ * \brief To serialize a request, in the binary encoding if the client
+ * is configured for it, in JSON otherwise
+ * \param prof The profile
+ * \return The serialized profile
+ */
+std::string
+my_serialize_request(diet_profile_t* prof);
+
+/**
+ * \brief To serialize the answer to a request, in the encoding of the request
+ * \param prof The profile
+ * \param request The serialized request
+ * \return The serialized profile
+ */
+std::string
+my_serialize_reply(diet_profile_t* prof, const std::string& request);
+
+/**
+ * \brief To deserialize a profile, either in JSON or in the binary encoding
  * \param prof The serialized profile
  * \return The deserialized profile
  */
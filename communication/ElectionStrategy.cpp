@@ -0,0 +1,81 @@
+#include "ElectionStrategy.hpp"
+
+#include <limits>
+#include <boost/make_shared.hpp>
+#include <boost/thread/locks.hpp>
+
+// anonymous namespace
+namespace {
+  /**
+   * \brief Get the load of a server, an empty one if unknown
+   */
+  ServerLoad
+  getLoad(const ServerLoadMap& loads, const std::string& uri) {
+    ServerLoadMap::const_iterator it = loads.find(uri);
+    return (it != loads.end()) ? it->second : ServerLoad();
+  }
+}
+
+boost::shared_ptr<ElectionStrategy>
+ElectionStrategy::create(const std::string& name) {
+  if (name == "roundrobin") {
+    return boost::make_shared<RoundRobinElection>();
+  } else if (name == "leastoutstanding") {
+    return boost::make_shared<LeastOutstandingElection>();
+  } else if (name == "latency") {
+    return boost::make_shared<LatencyElection>();
+  }
+  return boost::make_shared<FirstElection>();
+}
+
+std::string
+FirstElection::elect(const std::vector<boost::shared_ptr<Server> >& serv,
+                     const ServerLoadMap& loads) {
+  return serv.at(0)->getURI();
+}
+
+std::string
+RoundRobinElection::elect(const std::vector<boost::shared_ptr<Server> >& serv,
+                          const ServerLoadMap& loads) {
+  boost::lock_guard<boost::mutex> lock(mmutex);
+  return serv.at(mnext++ % serv.size())->getURI();
+}
+
+std::string
+LeastOutstandingElection::elect(const std::vector<boost::shared_ptr<Server> >& serv,
+                                const ServerLoadMap& loads) {
+  std::string elected = serv.at(0)->getURI();
+  unsigned int best = getLoad(loads, elected).inFlight;
+  std::vector<boost::shared_ptr<Server> >::const_iterator it;
+  for (it = serv.begin() + 1; it != serv.end(); ++it) {
+    unsigned int inFlight = getLoad(loads, (*it)->getURI()).inFlight;
+    if (inFlight < best) {
+      best = inFlight;
+      elected = (*it)->getURI();
+    }
+  }
+  return elected;
+}
+
+std::string
+LatencyElection::elect(const std::vector<boost::shared_ptr<Server> >& serv,
+                       const ServerLoadMap& loads) {
+  std::string elected;
+  double best(0.);
+  std::vector<boost::shared_ptr<Server> >::const_iterator it;
+  for (it = serv.begin(); it != serv.end(); ++it) {
+    ServerLoad load = getLoad(loads, (*it)->getURI());
+    if (load.requests == 0 && load.inFlight == 0) {
+      return (*it)->getURI();
+    }
+    // a server still waiting for its first answer is only elected last
+    double cost = (load.requests == 0) ?
+      std::numeric_limits<double>::max() :
+      load.latency * (load.inFlight + 1);
+    if (elected.empty() || cost < best) {
+      best = cost;
+      elected = (*it)->getURI();
+    }
+  }
+  return elected;
+}
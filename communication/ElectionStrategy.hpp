@@ -0,0 +1,150 @@
+/**
+ * \file ElectionStrategy.hpp
+ * \brief This file defines the strategies used to elect a server among
+ * those offering a service
+ * \author Haikel Guemar (haikel.guemar@sysfera.com)
+ */
+#ifndef _ELECTIONSTRATEGY_HPP_
+#define _ELECTIONSTRATEGY_HPP_
+
+#include <map>
+#include <string>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include "Server.hpp"
+
+/**
+ * \struct ServerLoad
+ * \brief Load observed by the dispatcher on a server
+ */
+struct ServerLoad {
+  /**
+   * \brief Constructor
+   */
+  ServerLoad() : inFlight(0), latency(0.), requests(0) {}
+  /**
+   * \brief Number of requests forwarded and not answered yet
+   */
+  unsigned int inFlight;
+  /**
+   * \brief Exponentially weighted moving average of the RPC time (ms)
+   */
+  double latency;
+  /**
+   * \brief Number of requests answered so far
+   */
+  unsigned long requests;
+};
+
+/**
+ * \brief Loads indexed by server uri
+ */
+typedef std::map<std::string, ServerLoad> ServerLoadMap;
+
+/**
+ * \class ElectionStrategy
+ * \brief Base class of the server election strategies
+ */
+class ElectionStrategy {
+public:
+  /**
+   * \brief Destructor
+   */
+  virtual ~ElectionStrategy() {}
+
+  /**
+   * \brief Elect a server
+   * \param serv list of eligible servers (not empty)
+   * \param loads the loads of the servers
+   * \return the uri of the choosen one
+   */
+  virtual std::string
+  elect(const std::vector<boost::shared_ptr<Server> >& serv,
+        const ServerLoadMap& loads) = 0;
+
+  /**
+   * \brief Tell whether the election reads the loads of the servers
+   * \return true if elect needs the loads
+   */
+  virtual bool
+  usesLoads() const { return false; }
+
+  /**
+   * \brief Build a strategy from its name
+   * \param name one of "first", "roundrobin", "leastoutstanding" or
+   * "latency", unknown names give the "first" strategy
+   * \return the strategy
+   */
+  static boost::shared_ptr<ElectionStrategy>
+  create(const std::string& name);
+};
+
+/**
+ * \class FirstElection
+ * \brief Always elects the first server registered
+ */
+class FirstElection : public ElectionStrategy {
+public:
+  std::string
+  elect(const std::vector<boost::shared_ptr<Server> >& serv,
+        const ServerLoadMap& loads);
+};
+
+/**
+ * \class RoundRobinElection
+ * \brief Elects the servers in turn
+ */
+class RoundRobinElection : public ElectionStrategy {
+public:
+  /**
+   * \brief Constructor
+   */
+  RoundRobinElection() : mnext(0) {}
+
+  std::string
+  elect(const std::vector<boost::shared_ptr<Server> >& serv,
+        const ServerLoadMap& loads);
+
+private:
+  /**
+   * \brief Index of the next server
+   */
+  unsigned long mnext;
+  /**
+   * \brief Mutex protecting the index
+   */
+  boost::mutex mmutex;
+};
+
+/**
+ * \class LeastOutstandingElection
+ * \brief Elects the server with the fewest requests in flight
+ */
+class LeastOutstandingElection : public ElectionStrategy {
+public:
+  std::string
+  elect(const std::vector<boost::shared_ptr<Server> >& serv,
+        const ServerLoadMap& loads);
+
+  bool
+  usesLoads() const { return true; }
+};
+
+/**
+ * \class LatencyElection
+ * \brief Elects the server with the lowest expected completion time,
+ * i.e. its average RPC time weighted by the requests in flight.
+ * Servers without history are elected first so they get measured.
+ */
+class LatencyElection : public ElectionStrategy {
+public:
+  std::string
+  elect(const std::vector<boost::shared_ptr<Server> >& serv,
+        const ServerLoadMap& loads);
+
+  bool
+  usesLoads() const { return true; }
+};
+
+#endif /* _ELECTIONSTRATEGY_HPP_ */
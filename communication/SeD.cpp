@@ -100,7 +100,7 @@ public:
     while (true) {
       data.clear();
       try {
-        data = socket.get();
+        socket.get(data);
       } catch (zmq::error_t &error) {
         LOG(boost::str(boost::format("[ERROR] %1%\n")
                        % error.what()), LogErr);
@@ -112,7 +112,8 @@ public:
         try {
           boost::shared_ptr<diet_profile_t> profile(my_deserialize(data));
           server_->call(profile.get()); //FIXME: deal with possibly error
-          socket.send(my_serialize(profile.get()));
+          std::string result = my_serialize_reply(profile.get(), data);
+          socket.sendZeroCopy(result);
         } catch (const VishnuException& ex) {
           socket.send(ex.what());
           LOG(boost::str(boost::format("[ERROR] %1%\n")
@@ -56,7 +56,7 @@ private:
       throw SystemException(ERRCODE_SYSTEM,
                             boost::str(boost::format("Service call failed for the profile %1%\n") % profile.get()->name));
     }
-    return my_serialize(profile.get());
+    return my_serialize_reply(profile.get(), data);
   }
 
 private:
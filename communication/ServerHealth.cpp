@@ -0,0 +1,82 @@
+#include "ServerHealth.hpp"
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/once.hpp>
+
+ServerHealth* ServerHealth::minstance = NULL;
+
+// anonymous namespace
+namespace {
+  boost::once_flag healthOnceFlag = BOOST_ONCE_INIT;
+
+  boost::posix_time::ptime
+  now() {
+    return boost::posix_time::microsec_clock::universal_time();
+  }
+}
+
+ServerHealth::ServerHealth(long baseBackoff, long maxBackoff, long healthyTtl)
+  : mbaseBackoff(boost::posix_time::seconds(baseBackoff)),
+    mmaxBackoff(boost::posix_time::seconds(maxBackoff)),
+    mhealthyTtl(boost::posix_time::seconds(healthyTtl)) {}
+
+void
+ServerHealth::createInstance() {
+  minstance = new ServerHealth();
+}
+
+ServerHealth&
+ServerHealth::getInstance() {
+  boost::call_once(&ServerHealth::createInstance, healthOnceFlag);
+  return *minstance;
+}
+
+bool
+ServerHealth::isAvailable(const std::string& uri) const {
+  boost::lock_guard<boost::mutex> lock(mmutex);
+  HealthMap::const_iterator it = mhealth.find(uri);
+  return (it == mhealth.end() ||
+          it->second.failures == 0 ||
+          it->second.retryAfter <= now());
+}
+
+bool
+ServerHealth::isKnownHealthy(const std::string& uri) const {
+  boost::lock_guard<boost::mutex> lock(mmutex);
+  HealthMap::const_iterator it = mhealth.find(uri);
+  return (it != mhealth.end() &&
+          it->second.failures == 0 &&
+          !it->second.lastSuccess.is_not_a_date_time() &&
+          now() - it->second.lastSuccess < mhealthyTtl);
+}
+
+void
+ServerHealth::markSuccess(const std::string& uri) {
+  boost::lock_guard<boost::mutex> lock(mmutex);
+  Health& health = mhealth[uri];
+  health.failures = 0;
+  health.lastSuccess = now();
+}
+
+void
+ServerHealth::markFailure(const std::string& uri) {
+  boost::lock_guard<boost::mutex> lock(mmutex);
+  Health& health = mhealth[uri];
+  boost::posix_time::time_duration delay = mbaseBackoff;
+  for (unsigned int i = 0; i < health.failures && delay < mmaxBackoff; ++i) {
+    delay = delay * 2;
+  }
+  if (delay > mmaxBackoff) {
+    delay = mmaxBackoff;
+  }
+  ++health.failures;
+  health.retryAfter = now() + delay;
+}
+
+unsigned int
+ServerHealth::getFailureCount(const std::string& uri) const {
+  boost::lock_guard<boost::mutex> lock(mmutex);
+  HealthMap::const_iterator it = mhealth.find(uri);
+  return (it == mhealth.end()) ? 0 : it->second.failures;
+}
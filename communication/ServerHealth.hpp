@@ -0,0 +1,140 @@
+/**
+ * \file ServerHealth.hpp
+ * \brief This file defines the client-side cache of the servers health
+ * \author Haikel Guemar (haikel.guemar@sysfera.com)
+ */
+#ifndef _SERVERHEALTH_HPP_
+#define _SERVERHEALTH_HPP_
+
+#include <map>
+#include <string>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/mutex.hpp>
+
+/**
+ * \class ServerHealth
+ * \brief Remembers which endpoints answered lately and which ones are
+ * dead. A dead endpoint is left aside for a delay which doubles after each
+ * new failure (exponential backoff), so that clients stop paying a full
+ * timeout on it at every call.
+ */
+class ServerHealth : public boost::noncopyable {
+public:
+  /**
+   * \brief Constructor
+   * \param baseBackoff delay (s) after a first failure
+   * \param maxBackoff maximum delay (s) between two attempts
+   * \param healthyTtl time (s) during which a successful server is
+   * trusted without probing it
+   */
+  ServerHealth(long baseBackoff = 1, long maxBackoff = 60,
+               long healthyTtl = 30);
+
+  /**
+   * \brief Get the cache of the process
+   * \return the cache
+   */
+  static ServerHealth&
+  getInstance();
+
+  /**
+   * \brief Tells whether an endpoint can be tried (not in backoff)
+   * \param uri The uri of the endpoint
+   * \return true if the endpoint can be tried
+   */
+  bool
+  isAvailable(const std::string& uri) const;
+
+  /**
+   * \brief Tells whether an endpoint answered lately
+   * \param uri The uri of the endpoint
+   * \return true if it answered less than healthyTtl seconds ago
+   */
+  bool
+  isKnownHealthy(const std::string& uri) const;
+
+  /**
+   * \brief Record a successful exchange with an endpoint
+   * \param uri The uri of the endpoint
+   */
+  void
+  markSuccess(const std::string& uri);
+
+  /**
+   * \brief Record a failed exchange with an endpoint
+   * \param uri The uri of the endpoint
+   */
+  void
+  markFailure(const std::string& uri);
+
+  /**
+   * \brief Get the number of consecutive failures of an endpoint
+   * \param uri The uri of the endpoint
+   * \return the number of failures
+   */
+  unsigned int
+  getFailureCount(const std::string& uri) const;
+
+private:
+  /**
+   * \struct Health
+   * \brief Health record of an endpoint
+   */
+  struct Health {
+    /**
+     * \brief Constructor
+     */
+    Health() : failures(0) {}
+    /**
+     * \brief Number of consecutive failures
+     */
+    unsigned int failures;
+    /**
+     * \brief Time before which the endpoint is not tried again
+     */
+    boost::posix_time::ptime retryAfter;
+    /**
+     * \brief Time of the last successful exchange
+     */
+    boost::posix_time::ptime lastSuccess;
+  };
+
+  /**
+   * \brief Health records indexed by uri
+   */
+  typedef std::map<std::string, Health> HealthMap;
+
+  /**
+   * \brief Create the cache instance
+   */
+  static void
+  createInstance();
+
+  /**
+   * \brief The instance of the process
+   */
+  static ServerHealth* minstance;
+  /**
+   * \brief Delay after a first failure
+   */
+  boost::posix_time::time_duration mbaseBackoff;
+  /**
+   * \brief Maximum delay between two attempts
+   */
+  boost::posix_time::time_duration mmaxBackoff;
+  /**
+   * \brief Time during which a successful server is trusted
+   */
+  boost::posix_time::time_duration mhealthyTtl;
+  /**
+   * \brief The health records
+   */
+  HealthMap mhealth;
+  /**
+   * \brief Mutex protecting the records
+   */
+  mutable boost::mutex mmutex;
+};
+
+#endif /* _SERVERHEALTH_HPP_ */
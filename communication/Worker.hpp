@@ -44,12 +44,23 @@ public:
     Socket socket(*ctx_, ZMQ_REP);
     socket.connect(uriInproc_.c_str());
     std::string data;
+    std::string service;
 
     while (true) {
       //vishnu::exitProcessIfAnyZombieChild(-1);
       data.clear();
+      service.clear();
       try {
-        data = socket.get();
+        socket.get(data);
+        // new clients put the name of the service in a routing frame
+        // ahead of the profile, older ones only send the profile
+        if (socket.hasMore()) {
+          service.swap(data);
+          socket.get(data);
+          while (socket.hasMore()) {
+            socket.get();
+          }
+        }
       } catch (zmq::error_t &error) {
         LOG(boost::str(boost::format("[ERROR] %1%\n") % error.what()), LogErr);
         continue;
@@ -58,8 +69,8 @@ public:
       // Deserialize and call Method
       if (! data.empty()) {
         try {
-          std::string resultSerialized = doCall(data);
-          socket.send(resultSerialized);
+          std::string resultSerialized = doCall(data, service);
+          socket.sendZeroCopy(resultSerialized);
         } catch (const VishnuException& ex) {
           diet_profile_t* profile = diet_profile_alloc("docall", 2);
           diet_string_set(profile, 0, "error");
@@ -83,6 +94,20 @@ protected:
   virtual std::string
   doCall(std::string& data) = 0;
 
+  /**
+   * \brief method to provide implementation specific behavior
+   * to handle received data along with its routing information.
+   * By default the routing information is ignored.
+   * \param data a string containing the data
+   * \param service the name of the service from the routing frame,
+   * empty if the client didn't send any
+   * \return the updated data
+   */
+  virtual std::string
+  doCall(std::string& data, const std::string& service) {
+    return doCall(data);
+  }
+
   /**
    * \brief zmq context
    */
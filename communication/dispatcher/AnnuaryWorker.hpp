@@ -8,10 +8,13 @@
 #define _ANNUARYWORKERS_HPP_
 
 
+#include <sstream>
 #include <boost/algorithm/string/join.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
 #include "Worker.hpp"
 #include "DIET_client.h"
 #include "UserException.hpp"
+#include "SystemException.hpp"
 #include "Annuary.hpp"
 #include "utilVishnu.hpp"
 #include "vishnu_version.hpp"
@@ -86,39 +89,78 @@ private:
    */
   std::string
   doCall(std::string& data) {
-    using boost::format;
-    using boost::str;
-
-    boost::shared_ptr<diet_profile_t> profile = my_deserialize(data);
-    std::string servname = profile->name;
-    std::vector<boost::shared_ptr<Server> > serv = mann_->get(servname);
-    std::string uriServer = elect(serv);
-
-    if (!uriServer.empty()) {
-      abstract_call_gen(profile.get(), uriServer);
-      return my_serialize(profile.get());
-    } else {
-      // reset profile to handle result
-      diet_profile_t* pb = diet_profile_alloc("response", 2);
-      diet_string_set(pb, 0, "error");
-      diet_string_set(pb, 1, str(format("error %1%: the service %2% is not available")
-                                 % ERRCODE_INVALID_PARAM
-                                 % servname));
-      return my_serialize(pb);
-    }
+    return doCall(data, "");
   }
 
   /**
-   * \brief Elect a server
-   * \param serv list of eligible servers
-   * \return the choosen one
+   * \brief Forward a request to a server offering the service. The payload
+   * is forwarded untouched, it is only parsed for old clients which didn't
+   * send the name of the service in a routing frame.
+   * \param data the serialized data containing the funcion and its parameters
+   * \param service the name of the service from the routing frame
+   * \return the serialized data (out data are updated)
    */
   std::string
-  elect(const std::vector<boost::shared_ptr<Server> >& serv){
-    if (serv.empty()) {
-      return "";
+  doCall(std::string& data, const std::string& service) {
+    std::string servname = service;
+    if (servname.empty()) {
+      servname = my_deserialize(data)->name;
+    }
+    std::string uriServer = mann_->elect(servname);
+
+    if (uriServer.empty()) {
+      return errorResponse(boost::str(
+                             boost::format("error %1%: the service %2% is not available")
+                             % ERRCODE_INVALID_PARAM
+                             % servname));
+    }
+
+    boost::posix_time::ptime start =
+      boost::posix_time::microsec_clock::universal_time();
+    std::string response;
+    int rv;
+    mann_->beginRequest(uriServer);
+    try {
+      rv = raw_call_gen(data, uriServer, response);
+    } catch (...) {
+      mann_->endRequest(uriServer, elapsedSince(start));
+      throw;
     }
-    return serv.at(0)->getURI();
+    mann_->endRequest(uriServer, elapsedSince(start));
+
+    if (rv != 0 || response.empty()) {
+      return errorResponse(boost::str(
+                             boost::format("error %1%: the server of the service %2% is not reachable")
+                             % ERRCODE_SYSTEM
+                             % servname));
+    }
+    return response;
+  }
+
+  /**
+   * \brief Build a serialized error answer
+   * \param msg the error message
+   * \return the serialized profile
+   */
+  static std::string
+  errorResponse(const std::string& msg) {
+    diet_profile_t* pb = diet_profile_alloc("response", 2);
+    diet_string_set(pb, 0, "error");
+    diet_string_set(pb, 1, msg);
+    std::string res = my_serialize(pb);
+    diet_profile_free(pb);
+    return res;
+  }
+
+  /**
+   * \brief Get the time elapsed since a given date
+   * \param start the date
+   * \return the elapsed time in milliseconds
+   */
+  static double
+  elapsedSince(const boost::posix_time::ptime& start) {
+    return static_cast<double>(
+      (boost::posix_time::microsec_clock::universal_time() - start).total_microseconds()) / 1000.;
   }
 
 };
@@ -181,6 +223,9 @@ private:
     case 3:
       result = boost::str(boost::format("%1%") % VISHNU_VERSION);
       break;
+    case 4:
+      result = listMetrics();
+      break;
     default:  // NOOP
       std::cerr << "[ERROR]: unrecognized command\n";
     }
@@ -210,6 +255,26 @@ private:
     return boost::algorithm::join(listServers, VISHNU_COMM_SEPARATOR);
   }
 
+  /**
+   * \brief Get the heartbeat metrics: the duration of the last sweep
+   * then the missed heartbeats and the round trip time of each server
+   * \return the metrics, one per line
+   */
+  std::string
+  listMetrics() {
+    std::ostringstream os;
+    os << "sweepDuration " << mann_->getSweepDuration() << "\n";
+    std::vector<boost::shared_ptr<Server> > list = mann_->get();
+    std::vector<boost::shared_ptr<Server> >::const_iterator it;
+    for (it = list.begin(); it != list.end(); ++it) {
+      ServerLiveness liveness = mann_->getLiveness((*it)->getURI());
+      os << (*it)->getName() << "@" << (*it)->getURI()
+         << " missed " << liveness.missed
+         << " rtt " << liveness.rtt << "\n";
+    }
+    return os.str();
+  }
+
 
 };
 
@@ -0,0 +1,379 @@
+#include "Broker.hpp"
+
+#include <algorithm>
+#include <set>
+#include <vector>
+#include <boost/format.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include "DIET_client.h"
+#include "Logger.hpp"
+#include "SystemException.hpp"
+#include "UserException.hpp"
+
+#ifndef ZMQ_DONTWAIT
+#define ZMQ_DONTWAIT ZMQ_NOBLOCK
+#endif
+
+// anonymous namespace
+namespace {
+  /**
+   * \brief Maximum time (ms) the broker sleeps when nothing is pending
+   */
+  const long IDLE_POLL_INTERVAL = 1000;
+
+  /**
+   * \brief Time (ms) between two closings of the removed servers sockets
+   */
+  const long BACKEND_DROP_INTERVAL = 1000;
+
+  /**
+   * \brief Maximum number of requests queued for a server
+   */
+  const int BACKEND_HWM = 1000;
+
+  /**
+   * \brief Maximum time (ms) a request waits for the connection to its
+   * server, a socket just created has none yet
+   */
+  const int BACKEND_SEND_TIMEOUT = 200;
+
+#ifdef ZMQ_SNDTIMEO
+  /**
+   * \brief Flags of the first frame sent to a server, which waits for the
+   * connection up to BACKEND_SEND_TIMEOUT
+   */
+  const int BACKEND_SEND_FLAGS = ZMQ_SNDMORE;
+#else
+  const int BACKEND_SEND_FLAGS = ZMQ_SNDMORE | ZMQ_DONTWAIT;
+#endif
+
+  /**
+   * \brief Get the time elapsed since a given date
+   * \param start the date
+   * \return the elapsed time in milliseconds
+   */
+  double
+  elapsedSince(const boost::posix_time::ptime& start) {
+    return static_cast<double>(
+      (boost::posix_time::microsec_clock::universal_time() - start).total_microseconds()) / 1000.;
+  }
+}
+
+Broker::Broker(const std::string& uri, boost::shared_ptr<Annuary> ann,
+               int timeout)
+  : muri(uri), mann(ann), mtimeout(boost::posix_time::seconds(timeout)),
+    mcontext(1), mlastId(0), mnextDrop(boost::posix_time::neg_infin) {}
+
+size_t
+Broker::getPendingCount() const {
+  return mpending.size();
+}
+
+void
+Broker::run() {
+  mfrontend.reset(new Socket(mcontext, ZMQ_ROUTER));
+  mfrontend->setLinger(0);
+  try {
+    mfrontend->bind(muri.c_str());
+    std::string logMsg = boost::str(boost::format("[INFO] Server started on %1%") % muri);
+    std::cerr << logMsg <<"\n";
+    LOG(logMsg, LogInfo);
+    std::cerr << "[INFO] See the log file for runtime info\n";
+  } catch (const zmq::error_t& e) {
+    std::string logMsg = boost::str(boost::format("[ERROR] zmq socket_server (%1%) binding failed (%2%)")
+                                    % muri % e.what());
+    LOG(logMsg, LogErr);
+    exit(1);
+  }
+
+  while (true) {
+    long wait = expireRequests();
+    if (boost::posix_time::microsec_clock::universal_time() >= mnextDrop) {
+      dropRemovedBackends();
+      mnextDrop = boost::posix_time::microsec_clock::universal_time()
+                  + boost::posix_time::milliseconds(BACKEND_DROP_INTERVAL);
+    }
+
+    // the frontend comes first, then a slot per server
+    std::vector<zmq::pollitem_t> items;
+    std::vector<Socket*> sockets;
+    zmq::pollitem_t front = {*mfrontend, 0, ZMQ_POLLIN, 0};
+    items.push_back(front);
+    sockets.push_back(mfrontend.get());
+    BackendMap::const_iterator it;
+    for (it = mbackends.begin(); it != mbackends.end(); ++it) {
+      zmq::pollitem_t item = {*it->second, 0, ZMQ_POLLIN, 0};
+      items.push_back(item);
+      sockets.push_back(it->second.get());
+    }
+
+    try {
+      zmq::poll(&items[0], items.size(), wait * 1000);
+    } catch (const zmq::error_t& e) {
+      if (EINTR == e.num()) {
+        continue;
+      }
+      LOG(boost::str(boost::format("[ERROR] broker poll failed (%1%)") % e.what()), LogErr);
+      break;
+    }
+
+    try {
+      for (size_t i = 1; i < items.size(); ++i) {
+        if (items[i].revents & ZMQ_POLLIN) {
+          handleServer(*sockets[i]);
+        }
+      }
+      if (items[0].revents & ZMQ_POLLIN) {
+        handleClient();
+      }
+    } catch (const zmq::error_t& e) {
+      LOG(boost::str(boost::format("[ERROR] %1%") % e.what()), LogErr);
+    }
+  }
+}
+
+void
+Broker::handleClient() {
+  Frames frames;
+  readFrames(*mfrontend, frames);
+
+  // the envelope goes up to the empty delimiter, a REQ client has a
+  // single identity, the asynchronous client adds its request id
+  Frames::iterator delim = std::find(frames.begin(), frames.end(), std::string());
+  if (delim == frames.end() || delim + 1 == frames.end()) {
+    LOG("[WARNING] malformed request dropped", LogWarning);
+    return;
+  }
+  Frames envelope(frames.begin(), delim + 1);
+  Frames body(delim + 1, frames.end());
+
+  // [payload] for old clients, [service][payload] otherwise
+  std::string& payload = body.back();
+  std::string service;
+  try {
+    if (body.size() > 1) {
+      service = body.front();
+      service.erase(std::remove(service.begin(), service.end(), '\0'), service.end());
+    } else {
+      service = my_deserialize(payload)->name;
+    }
+  } catch (const VishnuException& ex) {
+    replyError(envelope, boost::str(boost::format("error %1%: %2%")
+                                    % ERRCODE_INVALID_PARAM % ex.what()));
+    return;
+  }
+
+  std::string uriServer = mann->elect(service);
+  if (uriServer.empty()) {
+    replyError(envelope, boost::str(
+                 boost::format("error %1%: the service %2% is not available")
+                 % ERRCODE_INVALID_PARAM
+                 % service));
+    return;
+  }
+
+  std::string id = boost::lexical_cast<std::string>(++mlastId);
+  boost::posix_time::ptime now =
+    boost::posix_time::microsec_clock::universal_time();
+  PendingRequest& req = mpending[id];
+  req.envelope.swap(envelope);
+  req.service = service;
+  req.uri = uriServer;
+  req.start = now;
+  req.deadline = now + mtimeout;
+
+  mann->beginRequest(uriServer);
+  bool sent = false;
+  bool broken = false;
+  try {
+    // the id is echoed back by the ROUTER of the server. Nothing is queued
+    // for a server not connected: the request fails after a short wait
+    // rather than being delivered after the client was told it failed
+    Socket& sock = getBackend(uriServer);
+    sent = sock.send(id, BACKEND_SEND_FLAGS);
+    if (sent) {
+      sock.sendDelimiter();
+      sock.sendZeroCopy(payload);
+    }
+  } catch (const zmq::error_t& e) {
+    broken = true;
+  }
+  if (!sent) {
+    mann->endRequest(uriServer, elapsedSince(now));
+    Frames env;
+    env.swap(mpending[id].envelope);
+    mpending.erase(id);
+    replyError(env, boost::str(
+                 boost::format("error %1%: the server of the service %2% is not reachable")
+                 % ERRCODE_SYSTEM
+                 % service));
+  }
+  if (broken) {
+    closeBackend(uriServer);
+  }
+}
+
+void
+Broker::handleServer(Socket& sock) {
+  Frames frames;
+  readFrames(sock, frames);
+  if (frames.size() < 2) {
+    return;
+  }
+
+  PendingMap::iterator it = mpending.find(frames.front());
+  if (it == mpending.end()) {
+    ExpiredMap::iterator expired = mexpired.find(frames.front());
+    if (expired != mexpired.end()) {
+      LOG(boost::str(boost::format("[DEBUG] late answer of the request %1% dropped")
+                     % frames.front()), LogDebug);
+      mexpired.erase(expired);
+    }
+    return;
+  }
+  mann->endRequest(it->second.uri, elapsedSince(it->second.start));
+  reply(it->second.envelope, frames.back());
+  mpending.erase(it);
+}
+
+long
+Broker::expireRequests() {
+  boost::posix_time::ptime now =
+    boost::posix_time::microsec_clock::universal_time();
+  long wait(IDLE_POLL_INTERVAL);
+
+  // a late answer is only expected for a while
+  ExpiredMap::iterator expired = mexpired.begin();
+  while (expired != mexpired.end()) {
+    if (expired->second + mtimeout <= now) {
+      mexpired.erase(expired++);
+    } else {
+      ++expired;
+    }
+  }
+
+  PendingMap::iterator it = mpending.begin();
+  while (it != mpending.end()) {
+    if (it->second.deadline > now) {
+      wait = std::min(wait, static_cast<long>(
+                        (it->second.deadline - now).total_milliseconds() + 1));
+      ++it;
+      continue;
+    }
+    LOG(boost::str(boost::format("[WARNING] no response from %1%, request dropped")
+                   % it->second.uri), LogWarning);
+    mann->endRequest(it->second.uri, elapsedSince(it->second.start));
+    replyError(it->second.envelope, boost::str(
+                 boost::format("error %1%: the server of the service %2% is not reachable")
+                 % ERRCODE_SYSTEM
+                 % it->second.service));
+    // only this request fails, the others in flight to the server may
+    // still be answered
+    mexpired[it->first] = now;
+    mpending.erase(it++);
+  }
+  return wait;
+}
+
+void
+Broker::reply(const Frames& envelope, std::string& data) {
+  Frames::const_iterator it;
+  for (it = envelope.begin(); it != envelope.end(); ++it) {
+    mfrontend->send(*it, ZMQ_SNDMORE);
+  }
+  mfrontend->sendZeroCopy(data);
+}
+
+void
+Broker::replyError(const Frames& envelope, const std::string& msg) {
+  diet_profile_t* pb = diet_profile_alloc("response", 2);
+  diet_string_set(pb, 0, "error");
+  diet_string_set(pb, 1, msg);
+  std::string res = my_serialize(pb);
+  diet_profile_free(pb);
+  reply(envelope, res);
+}
+
+Socket&
+Broker::getBackend(const std::string& uri) {
+  BackendMap::iterator it = mbackends.find(uri);
+  if (it != mbackends.end()) {
+    return *it->second;
+  }
+  boost::shared_ptr<Socket> sock = boost::make_shared<Socket>(boost::ref(mcontext),
+                                                              ZMQ_DEALER);
+  sock->setLinger(0);
+#ifdef ZMQ_SNDHWM
+  int hwm = BACKEND_HWM;
+  sock->setsockopt(ZMQ_SNDHWM, &hwm, sizeof(hwm));
+#endif
+#ifdef ZMQ_SNDTIMEO
+  int sendTimeout = BACKEND_SEND_TIMEOUT;
+  sock->setsockopt(ZMQ_SNDTIMEO, &sendTimeout, sizeof(sendTimeout));
+#endif
+#if defined(ZMQ_IMMEDIATE)
+  int immediate = 1;
+  sock->setsockopt(ZMQ_IMMEDIATE, &immediate, sizeof(immediate));
+#elif defined(ZMQ_DELAY_ATTACH_ON_CONNECT)
+  int immediate = 1;
+  sock->setsockopt(ZMQ_DELAY_ATTACH_ON_CONNECT, &immediate, sizeof(immediate));
+#endif
+  sock->connect(uri);
+  mbackends[uri] = sock;
+  return *sock;
+}
+
+void
+Broker::closeBackend(const std::string& uri) {
+  // with no linger, the messages not yet sent are discarded on close
+  if (mbackends.erase(uri)) {
+    LOG(boost::str(boost::format("[WARNING] connection to %1% reset") % uri), LogWarning);
+  }
+
+  // the answers can't come back on a closed socket
+  PendingMap::iterator it = mpending.begin();
+  while (it != mpending.end()) {
+    if (it->second.uri != uri) {
+      ++it;
+      continue;
+    }
+    mann->endRequest(uri, elapsedSince(it->second.start));
+    replyError(it->second.envelope, boost::str(
+                 boost::format("error %1%: the server of the service %2% is not reachable")
+                 % ERRCODE_SYSTEM
+                 % it->second.service));
+    mpending.erase(it++);
+  }
+}
+
+void
+Broker::dropRemovedBackends() {
+  std::set<std::string> uris;
+  std::vector<boost::shared_ptr<Server> > servers = mann->get();
+  std::vector<boost::shared_ptr<Server> >::const_iterator server;
+  for (server = servers.begin(); server != servers.end(); ++server) {
+    uris.insert((*server)->getURI());
+  }
+
+  std::vector<std::string> removed;
+  BackendMap::const_iterator it;
+  for (it = mbackends.begin(); it != mbackends.end(); ++it) {
+    if (uris.find(it->first) == uris.end()) {
+      removed.push_back(it->first);
+    }
+  }
+  std::vector<std::string>::const_iterator uri;
+  for (uri = removed.begin(); uri != removed.end(); ++uri) {
+    closeBackend(*uri);
+  }
+}
+
+void
+Broker::readFrames(Socket& sock, Frames& frames) {
+  do {
+    frames.push_back(sock.getRaw());
+  } while (sock.hasMore());
+}
@@ -0,0 +1,209 @@
+/**
+ * \file Broker.hpp
+ * \brief This file contains the event-driven broker forwarding the client
+ * requests to the servers
+ * \author Haikel Guemar (haikel.guemar@sysfera.com)
+ */
+#ifndef _BROKER_HPP_
+#define _BROKER_HPP_
+
+#include <map>
+#include <string>
+#include <vector>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include "zhelpers.hpp"
+#include "Annuary.hpp"
+
+/**
+ * \class Broker
+ * \brief Forwards the client requests to the servers without blocking.
+ *
+ * Clients talk to a ROUTER socket. Each request is forwarded on a DEALER
+ * socket per server, framed as [request id][empty][payload] like the
+ * asynchronous client does, so that the server ROUTER/REP pair echoes the
+ * id back. The broker keeps track of the pending requests by id and
+ * answers the client as soon as its server replies, or with an error once
+ * the deadline of the request expired. A single thread can therefore keep
+ * any number of requests in flight, slow servers don't hold anyone else.
+ */
+class Broker {
+public:
+  /**
+   * \brief Constructor
+   * \param uri the uri the clients connect to
+   * \param ann the annuary
+   * \param timeout the deadline of each request in seconds
+   */
+  Broker(const std::string& uri, boost::shared_ptr<Annuary> ann, int timeout);
+
+  /**
+   * \brief Main loop of the broker
+   */
+  void
+  run();
+
+  /**
+   * \brief Get the number of requests waiting for a server
+   */
+  size_t
+  getPendingCount() const;
+
+private:
+  /**
+   * \brief Frames of a multipart message
+   */
+  typedef std::vector<std::string> Frames;
+
+  /**
+   * \struct PendingRequest
+   * \brief A request forwarded and waiting for its answer
+   */
+  struct PendingRequest {
+    /**
+     * \brief The envelope of the client (identities and delimiter)
+     */
+    Frames envelope;
+    /**
+     * \brief The name of the service
+     */
+    std::string service;
+    /**
+     * \brief The server the request was forwarded to
+     */
+    std::string uri;
+    /**
+     * \brief When the request was forwarded
+     */
+    boost::posix_time::ptime start;
+    /**
+     * \brief The deadline of the request
+     */
+    boost::posix_time::ptime deadline;
+  };
+
+  /**
+   * \brief The pending requests indexed by request id
+   */
+  typedef std::map<std::string, PendingRequest> PendingMap;
+
+  /**
+   * \brief When the expired requests were dropped, indexed by request id
+   */
+  typedef std::map<std::string, boost::posix_time::ptime> ExpiredMap;
+  /**
+   * \brief The sockets connected to the servers indexed by uri
+   */
+  typedef std::map<std::string, boost::shared_ptr<Socket> > BackendMap;
+
+  /**
+   * \brief Read a client request and forward it
+   */
+  void
+  handleClient();
+
+  /**
+   * \brief Read a server answer and give it back to its client
+   * \param sock the socket of the server
+   */
+  void
+  handleServer(Socket& sock);
+
+  /**
+   * \brief Answer with an error the requests whose deadline expired
+   * \return the time (ms) until the next deadline
+   */
+  long
+  expireRequests();
+
+  /**
+   * \brief Send an answer to a client
+   * \param envelope the envelope of the client
+   * \param data the raw answer, handed over to zmq
+   */
+  void
+  reply(const Frames& envelope, std::string& data);
+
+  /**
+   * \brief Send an error answer to a client
+   * \param envelope the envelope of the client
+   * \param msg the error message
+   */
+  void
+  replyError(const Frames& envelope, const std::string& msg);
+
+  /**
+   * \brief Get the socket connected to a server, creating it if needed
+   * \param uri the uri of the server
+   * \return the socket
+   */
+  Socket&
+  getBackend(const std::string& uri);
+
+  /**
+   * \brief Close the socket connected to a server, dropping the requests
+   * not yet delivered to it and answering with an error those in flight
+   * \param uri the uri of the server
+   */
+  void
+  closeBackend(const std::string& uri);
+
+  /**
+   * \brief Close the sockets of the servers no longer in the annuary
+   */
+  void
+  dropRemovedBackends();
+
+  /**
+   * \brief Read all the frames of a message
+   * \param sock the socket
+   * \param frames OUT, the frames
+   */
+  static void
+  readFrames(Socket& sock, Frames& frames);
+
+  /**
+   * \brief The uri the clients connect to
+   */
+  std::string muri;
+  /**
+   * \brief The annuary
+   */
+  boost::shared_ptr<Annuary> mann;
+  /**
+   * \brief The deadline of each request
+   */
+  boost::posix_time::time_duration mtimeout;
+  /**
+   * \brief The zmq context
+   */
+  zmq::context_t mcontext;
+  /**
+   * \brief The socket of the clients
+   */
+  boost::scoped_ptr<Socket> mfrontend;
+  /**
+   * \brief The sockets of the servers
+   */
+  BackendMap mbackends;
+  /**
+   * \brief The pending requests
+   */
+  PendingMap mpending;
+
+  /**
+   * \brief The requests expired recently, whose late answers are dropped
+   */
+  ExpiredMap mexpired;
+  /**
+   * \brief The last request id
+   */
+  unsigned long mlastId;
+  /**
+   * \brief When the sockets of the removed servers are next closed
+   */
+  boost::posix_time::ptime mnextDrop;
+};
+
+#endif /* _BROKER_HPP_ */
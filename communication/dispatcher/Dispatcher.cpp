@@ -1,17 +1,65 @@
 #include "Dispatcher.hpp"
 #include "Server.hpp"
+#include <algorithm>
 #include <boost/make_shared.hpp>
 #include <boost/thread.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
 #include "utilVishnu.hpp"
 #include "DIET_client.h"
 #include "VishnuException.hpp"
 #include "Logger.hpp"
 #include <signal.h>
 
+/**
+ * \brief Number of consecutive heartbeats a server may miss before being
+ * removed from the annuary
+ */
+static const unsigned int MAX_MISSED_HEARTBEATS = 2;
+
+/**
+ * \brief Maximum number of servers pinged at the same time
+ */
+static const size_t MAX_PARALLEL_PROBES = 16;
+
+/**
+ * \brief Ping the servers of a sweep until none is left
+ * \param ann The annuary
+ * \param servers The servers of the sweep
+ * \param next IN/OUT, the index of the next server to ping
+ * \param mutex The mutex protecting next
+ */
+static void
+probeServers(boost::shared_ptr<Annuary> ann,
+             const std::vector<boost::shared_ptr<Server> >& servers,
+             size_t& next, boost::mutex& mutex) {
+  while (true) {
+    size_t index;
+    {
+      boost::lock_guard<boost::mutex> lock(mutex);
+      if (next >= servers.size()) {
+        return;
+      }
+      index = next++;
+    }
+    Dispatcher::probe(ann, servers[index]);
+  }
+}
+
+/**
+ * \brief Get the time elapsed since a given date
+ * \param start the date
+ * \return the elapsed time in milliseconds
+ */
+static double
+elapsedSince(const boost::posix_time::ptime& start) {
+  return static_cast<double>(
+    (boost::posix_time::microsec_clock::universal_time() - start).total_microseconds()) / 1000.;
+}
 
 Dispatcher::Dispatcher(const std::string &confFile)
   : uriAddr("tcp://127.0.0.1:5560"),
-    uriSubs("tcp://127.0.0.1:5561"), confFil(confFile), nthread(5), timeout(10) {
+    uriSubs("tcp://127.0.0.1:5561"), confFil(confFile), nthread(5), timeout(10),
+    electionPolicy("first") {
   if (!confFile.empty()) {
     config.initFromFile(confFile);
   }
@@ -25,7 +73,9 @@ Dispatcher::printConfiguration() const{
                                "disp_uriSubs=%2%"
                                "disp_timeout=%3%"
                                "disp_nbthread=%4%"
-                               ) % uriAddr % uriSubs % timeout % nthread), LogInfo);
+                               "disp_electionPolicy=%5%"
+                               ) % uriAddr % uriSubs % timeout % nthread
+                 % electionPolicy), LogInfo);
 }
 
 
@@ -35,6 +85,7 @@ Dispatcher::readConfiguration() {
   config.getConfigValue<std::string>(vishnu::DISP_URISUBS, uriSubs);
   config.getConfigValue<unsigned int>(vishnu::NBTHREADS, nthread);
   config.getConfigValue<unsigned int>(vishnu::TIMEOUT, timeout);
+  config.getConfigValue<std::string>(vishnu::DISP_ELECTION, electionPolicy);
   printConfiguration();
 }
 
@@ -42,6 +93,7 @@ void
 Dispatcher::configureAnnuary() {
   // Prepare our context and socket
   ann = boost::make_shared<Annuary>();
+  ann->setElectionStrategy(ElectionStrategy::create(electionPolicy));
   std::string mid;
   config.getConfigValue<std::string>(vishnu::MACHINEID, mid);
 
@@ -75,29 +127,66 @@ Dispatcher::bayWatch(boost::shared_ptr<Annuary> ann, int timeout, std::string& c
   } catch (VishnuException& e){
   }
   while (true){
+    boost::posix_time::ptime start =
+      boost::posix_time::microsec_clock::universal_time();
     // get all servers
     std::vector<boost::shared_ptr<Server> > list = ann->get();
-    std::vector<boost::shared_ptr<Server> >::iterator iter;
-    std::string service = "heartbeat";
-    // For each server
-    for (iter = list.begin() ; iter != list.end() ; ++iter){
-      diet_profile_t* profile = diet_profile_alloc(service, 0);
-      // try to ping them
-      if (abstract_call_gen(profile, iter->get()->getURI())){
-        // If failed : remove the server
-        ann->remove(iter->get()->getName(), iter->get()->getURI());
-        LOG(boost::str(boost::format("[INFO]: removed %1%@%2% from the annuary")
-                       % iter->get()->getName()
-                       % iter->get()->getURI()), LogInfo);
-      }
-      diet_profile_free(profile);
+    // a few workers share the pings, a dead server only delays the probes
+    // of its worker
+    size_t next = 0;
+    boost::mutex mutex;
+    boost::thread_group probes;
+    size_t workers = std::min(list.size(), MAX_PARALLEL_PROBES);
+    for (size_t i = 0; i < workers; ++i) {
+      probes.create_thread(boost::bind(&probeServers, ann, boost::cref(list),
+                                       boost::ref(next), boost::ref(mutex)));
     }
+    probes.join_all();
+
+    double duration = elapsedSince(start);
+    ann->setSweepDuration(duration);
+    LOG(boost::str(boost::format("[DEBUG]: heartbeat sweep of %1% servers took %2% ms")
+                   % list.size()
+                   % duration), LogDebug);
     // Sleep a bit
     sleep(timeout);
   }
 }
 
 
+void
+Dispatcher::probe(boost::shared_ptr<Annuary> ann, boost::shared_ptr<Server> server) {
+  boost::posix_time::ptime start =
+    boost::posix_time::microsec_clock::universal_time();
+  diet_profile_t* profile = diet_profile_alloc("heartbeat", 0);
+  int rv = -1;
+  try {
+    // a single attempt, the next sweep is the retry
+    rv = abstract_call_gen(profile, server->getURI(), true, 1, 1);
+  } catch (...) {
+  }
+  diet_profile_free(profile);
+
+  if (rv == 0) {
+    ann->markAlive(server->getURI(), elapsedSince(start));
+    return;
+  }
+
+  unsigned int missed = ann->markMissed(server->getURI());
+  if (missed < MAX_MISSED_HEARTBEATS) {
+    LOG(boost::str(boost::format("[WARNING]: %1%@%2% missed a heartbeat, marked as suspect")
+                   % server->getName()
+                   % server->getURI()), LogWarning);
+    return;
+  }
+  // If failed again : remove the server
+  ann->remove(server->getName(), server->getURI());
+  LOG(boost::str(boost::format("[INFO]: removed %1%@%2% from the annuary")
+                 % server->getName()
+                 % server->getURI()), LogInfo);
+}
+
+
 void
 Dispatcher::configureHandlers() {
   std::string ipcUriBase;
@@ -116,9 +205,16 @@ Dispatcher::configureHandlers() {
   bool useSsl = false;
   if (! config.getConfigValue<bool>(vishnu::USE_SSL, useSsl) ||
       ! useSsl) { /* TLS dont required */
-    clientHandler.reset(new Handler4Clients(uriAddr, ann, nthread, false, ""));
+    // a single event loop keeps every client request in flight, the
+    // workers are only needed for the blocking TLS backend below
+    int requestTimeout(DEFAULT_TIMEOUT);
+    config.getConfigValue<int>(vishnu::TIMEOUT, requestTimeout);
+    if (requestTimeout <= 0) {
+      requestTimeout = DEFAULT_TIMEOUT;
+    }
+    broker.reset(new Broker(uriAddr, ann, requestTimeout));
     serverHandler.reset(new Handler4Servers(uriSubs, ann, nthread, false, ""));
-    boost::thread th1(boost::bind(&Handler4Clients::run, clientHandler.get()));
+    boost::thread th1(boost::bind(&Broker::run, broker.get()));
     boost::thread th2(boost::bind(&Handler4Servers::run, serverHandler.get()));
     boost::thread th3(boost::bind(&Dispatcher::bayWatch, ann, timeout, confFil));
     th1.join();
@@ -11,6 +11,7 @@
 #include <string>
 #include "Annuary.hpp"
 #include "handlers.hpp"
+#include "Broker.hpp"
 #include "ExecConfiguration.hpp"
 
 /**
@@ -37,7 +38,10 @@ public:
   getAnnuary();
 
   /**
-   * \brief Function that continuously check the content of the annuary with pings and remove it if ping fails
+   * \brief Function that continuously check the content of the annuary with pings.
+   * The servers are pinged by a bounded set of workers, once each with a
+   * short deadline, a server missing a ping becomes suspect and is removed
+   * if it misses the next one.
    * \param ann The annuary to check
    * \param timeout The frequency to sleep between each turn of check
    * \param confFile The configuration file
@@ -45,6 +49,14 @@ public:
   static void
   bayWatch(boost::shared_ptr<Annuary> ann, int timeout, std::string& confFile);
 
+  /**
+   * \brief Ping a server and record the result in the annuary
+   * \param ann The annuary
+   * \param server The server to ping
+   */
+  static void
+  probe(boost::shared_ptr<Annuary> ann, boost::shared_ptr<Server> server);
+
 
 private:
   /**
@@ -83,6 +95,10 @@ private:
    * \brief The handlers of the clients
    */
   boost::scoped_ptr<Handler4Clients> clientHandler;
+  /**
+   * \brief The broker forwarding the requests of the clients
+   */
+  boost::scoped_ptr<Broker> broker;
   /**
    * \brief The handlers of the servers
    */
@@ -107,6 +123,10 @@ private:
    * \brief The timeout of the dispatcher
    */
   unsigned int timeout;
+  /**
+   * \brief The name of the server election strategy
+   */
+  std::string electionPolicy;
 };
 
 
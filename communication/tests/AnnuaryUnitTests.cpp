@@ -161,4 +161,107 @@ BOOST_AUTO_TEST_CASE( test_setInitConfig_UMS_n )
   }
 }
 
+BOOST_AUTO_TEST_CASE( test_elect_first_n )
+{
+// Test the default election
+  Annuary ann(mservers);
+  ann.add("titi", "tutu", services);
+  BOOST_REQUIRE_EQUAL(ann.elect("loup"), uri);
+  BOOST_REQUIRE_EQUAL(ann.elect("loup"), uri);
+}
+
+BOOST_AUTO_TEST_CASE( test_elect_bad )
+{
+// Test the election of an unknown service
+  Annuary ann(mservers);
+  BOOST_REQUIRE(ann.elect("bad").empty());
+}
+
+BOOST_AUTO_TEST_CASE( test_elect_roundrobin_n )
+{
+// Test the round-robin election
+  Annuary ann(mservers);
+  ann.add("titi", "tutu", services);
+  ann.setElectionStrategy(ElectionStrategy::create("roundrobin"));
+  BOOST_REQUIRE_EQUAL(ann.elect("loup"), uri);
+  BOOST_REQUIRE_EQUAL(ann.elect("loup"), "tutu");
+  BOOST_REQUIRE_EQUAL(ann.elect("loup"), uri);
+}
+
+BOOST_AUTO_TEST_CASE( test_elect_leastoutstanding_n )
+{
+// Test the least outstanding requests election
+  Annuary ann(mservers);
+  ann.add("titi", "tutu", services);
+  ann.setElectionStrategy(ElectionStrategy::create("leastoutstanding"));
+  ann.beginRequest(uri);
+  BOOST_REQUIRE_EQUAL(ann.getLoad(uri).inFlight, 1);
+  BOOST_REQUIRE_EQUAL(ann.elect("loup"), "tutu");
+  ann.endRequest(uri, 10.);
+  BOOST_REQUIRE_EQUAL(ann.getLoad(uri).inFlight, 0);
+  BOOST_REQUIRE_EQUAL(ann.elect("loup"), uri);
+}
+
+BOOST_AUTO_TEST_CASE( test_elect_latency_n )
+{
+// Test the latency weighted election
+  Annuary ann(mservers);
+  ann.add("titi", "tutu", services);
+  ann.setElectionStrategy(ElectionStrategy::create("latency"));
+  ann.beginRequest(uri);
+  ann.endRequest(uri, 100.);
+  // never measured servers are elected first
+  BOOST_REQUIRE_EQUAL(ann.elect("loup"), "tutu");
+  ann.beginRequest("tutu");
+  ann.endRequest("tutu", 10.);
+  BOOST_REQUIRE_EQUAL(ann.elect("loup"), "tutu");
+  BOOST_REQUIRE_EQUAL(ann.getLoad("tutu").requests, 1);
+}
+
+BOOST_AUTO_TEST_CASE( test_index_n )
+{
+// Test that the service index follows the adds and removes
+  Annuary ann(mservers);
+  std::vector<std::string> others;
+  others.push_back("loup");
+  others.push_back("renard");
+  ann.add("titi", "tutu", others);
+  BOOST_REQUIRE_EQUAL(ann.get("loup").size(), 2);
+  BOOST_REQUIRE_EQUAL(ann.get("belette").size(), 1);
+  BOOST_REQUIRE_EQUAL(ann.get("renard").size(), 1);
+  ann.remove(name, uri);
+  BOOST_REQUIRE_EQUAL(ann.get("loup").size(), 1);
+  BOOST_REQUIRE_EQUAL(ann.get("loup").at(0)->getURI(), "tutu");
+  BOOST_REQUIRE_EQUAL(ann.get("belette").size(), 0);
+  BOOST_REQUIRE(ann.elect("belette").empty());
+  BOOST_REQUIRE_EQUAL(ann.get().size(), 1);
+}
+
+BOOST_AUTO_TEST_CASE( test_liveness_n )
+{
+// Test the heartbeat records
+  Annuary ann(mservers);
+  BOOST_REQUIRE(!ann.isSuspect(uri));
+  BOOST_REQUIRE_EQUAL(ann.markMissed(uri), 1);
+  BOOST_REQUIRE(ann.isSuspect(uri));
+  BOOST_REQUIRE_EQUAL(ann.markMissed(uri), 2);
+  ann.markAlive(uri, 5.);
+  BOOST_REQUIRE(!ann.isSuspect(uri));
+  BOOST_REQUIRE_EQUAL(ann.getLiveness(uri).rtt, 5.);
+  ann.markMissed(uri);
+  ann.remove(name, uri);
+  BOOST_REQUIRE_EQUAL(ann.getLiveness(uri).missed, 0);
+}
+
+BOOST_AUTO_TEST_CASE( test_elect_suspect_n )
+{
+// Test that suspect servers are only elected as a last resort
+  Annuary ann(mservers);
+  ann.add("titi", "tutu", services);
+  ann.markMissed(uri);
+  BOOST_REQUIRE_EQUAL(ann.elect("loup"), "tutu");
+  ann.markMissed("tutu");
+  BOOST_REQUIRE_EQUAL(ann.elect("loup"), uri);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -150,6 +150,73 @@ BOOST_AUTO_TEST_CASE( my_test_deser_b_emp )
   BOOST_REQUIRE_THROW(my_deserialize(profSer), SystemException);
 }
 
+BOOST_AUTO_TEST_CASE( my_test_binary_serial_n )
+{
+  diet_profile_t* prof = diet_profile_alloc("alloc", 2);
+  diet_string_set(prof, 0, "<job id=\"1\">\n</job>");
+  diet_string_set(prof, 1, std::string("a\0b", 3));
+  std::string res = BinaryProfile::serialize(prof);
+  BOOST_REQUIRE(BinaryProfile::isBinary(res));
+  boost::shared_ptr<diet_profile_t> prof2 = my_deserialize(res);
+
+  BOOST_REQUIRE_EQUAL(prof2->name, "alloc");
+  BOOST_REQUIRE_EQUAL(prof2->param_count, 2);
+  BOOST_REQUIRE_EQUAL(prof2->params[0], prof->params[0]);
+  BOOST_REQUIRE_EQUAL(prof2->params[1], prof->params[1]);
+  diet_profile_free(prof);
+}
+
+BOOST_AUTO_TEST_CASE( my_test_binary_reply_n )
+{
+  diet_profile_t* prof = diet_profile_alloc("alloc", 1);
+  diet_string_set(prof, 0, "param1");
+  std::string json = my_serialize(prof);
+  std::string binary = BinaryProfile::serialize(prof);
+  BOOST_REQUIRE(!BinaryProfile::isBinary(my_serialize_reply(prof, json)));
+  BOOST_REQUIRE(BinaryProfile::isBinary(my_serialize_reply(prof, binary)));
+  diet_profile_free(prof);
+}
+
+BOOST_AUTO_TEST_CASE( my_test_binary_deser_b_truncated )
+{
+  diet_profile_t* prof = diet_profile_alloc("alloc", 1);
+  diet_string_set(prof, 0, "param1");
+  std::string res = BinaryProfile::serialize(prof);
+  diet_profile_free(prof);
+  BOOST_REQUIRE_THROW(my_deserialize(res.substr(0, res.size() - 1)),
+                      SystemException);
+  BOOST_REQUIRE_THROW(my_deserialize(res + "x"), SystemException);
+}
+
+BOOST_AUTO_TEST_CASE( my_test_binary_socket_n )
+{
+  // the OUT parameters are empty, the encoding then ends with NUL bytes
+  diet_profile_t* prof = diet_profile_alloc("alloc", 3);
+  diet_string_set(prof, 0, "param1");
+  diet_string_set(prof, 1, std::string("a\0", 2));
+  zmq::context_t ctx(1);
+  Socket sock(ctx, ZMQ_REQ);
+  sock.connect("echo");
+
+  BOOST_REQUIRE(sock.send(BinaryProfile::serialize(prof)));
+  std::string received;
+  sock.get(received);
+  boost::shared_ptr<diet_profile_t> prof2 = my_deserialize(received);
+  BOOST_REQUIRE_EQUAL(prof2->param_count, 3);
+  BOOST_REQUIRE_EQUAL(prof2->params[1], prof->params[1]);
+  BOOST_REQUIRE_EQUAL(prof2->params[2], "");
+
+  // the last parameter ends with a NUL
+  diet_profile_t* prof3 = diet_profile_alloc("alloc", 1);
+  diet_string_set(prof3, 0, std::string("b\0", 2));
+  std::string data = BinaryProfile::serialize(prof3);
+  BOOST_REQUIRE(sock.sendZeroCopy(data));
+  sock.get(received);
+  BOOST_REQUIRE_EQUAL(my_deserialize(received)->params[0], prof3->params[0]);
+  diet_profile_free(prof);
+  diet_profile_free(prof3);
+}
+
 BOOST_AUTO_TEST_CASE( my_test_init_b_nul )
 {
   BOOST_REQUIRE_THROW(diet_initialize(NULL, 0, NULL), SystemException);
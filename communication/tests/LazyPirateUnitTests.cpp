@@ -3,6 +3,7 @@
 #include <vector>
 #include "zmq.hpp"
 #include "zhelpers.hpp"
+#include "ConnectionPool.hpp"
 
 static const std::string addr("tcp://localhost:5555");
 static zmq::context_t ctxt;
@@ -42,4 +43,48 @@ BOOST_AUTO_TEST_CASE( test_recv_b_addr )
   BOOST_REQUIRE_NE(lp.recv(), "ok");
 }
 
+BOOST_AUTO_TEST_CASE( test_pool_reuse_n )
+{
+// Test that a successful connection is kept for the next call
+  ConnectionPool& pool = ConnectionPool::getInstance();
+  std::string response;
+  pool.clear();
+  BOOST_REQUIRE(pool.call(addr, "bonjour", response, DEFAULT_TIMEOUT));
+  BOOST_REQUIRE_EQUAL(response, "ok");
+  BOOST_REQUIRE_EQUAL(pool.getIdleCount(addr), 1);
+  BOOST_REQUIRE(pool.call(addr, "bonjour", response, DEFAULT_TIMEOUT));
+  BOOST_REQUIRE_EQUAL(pool.getIdleCount(addr), 1);
+}
+
+BOOST_AUTO_TEST_CASE( test_pool_drop_b_addr )
+{
+// Test that a failed connection is not given back to the pool
+  ConnectionPool& pool = ConnectionPool::getInstance();
+  std::string response;
+  pool.clear();
+  BOOST_REQUIRE_THROW(pool.call("bad", "bonjour", response, DEFAULT_TIMEOUT),
+                      std::exception);
+  BOOST_REQUIRE_EQUAL(pool.getIdleCount("bad"), 0);
+}
+
+BOOST_AUTO_TEST_CASE( test_send_zero_copy_n )
+{
+// Test that the buffer is handed over to zmq
+  Socket sock(ctxt, ZMQ_REQ);
+  sock.connect(addr);
+  std::string data("bonjour");
+  BOOST_REQUIRE(sock.sendZeroCopy(data));
+  BOOST_REQUIRE(data.empty());
+}
+
+BOOST_AUTO_TEST_CASE( test_get_buffer_n )
+{
+// Test the reception into a buffer
+  Socket sock(ctxt, ZMQ_REQ);
+  sock.connect(addr);
+  std::string buffer("a previous and longer message");
+  sock.get(buffer);
+  BOOST_REQUIRE_EQUAL(buffer, "ok");
+}
+
 BOOST_AUTO_TEST_SUITE_END()
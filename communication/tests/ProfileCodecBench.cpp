@@ -0,0 +1,90 @@
+/**
+ * \file ProfileCodecBench.cpp
+ * \brief Compares the JSON and the binary encodings of the profiles on
+ * listJobs-like responses
+ * usage: profile_codec_bench [nbJobs] [nbRounds]
+ */
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <boost/format.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include "DIET_client.h"
+#include "BinaryProfile.hpp"
+
+namespace {
+  /**
+   * \brief Build a ListJobs document as serialized by ecorecpp
+   */
+  std::string
+  makeListJobs(int nbJobs) {
+    std::ostringstream os;
+    os << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+       << "<TMS_Data:ListJobs xmlns:TMS_Data=\"http://www.sysfera.com/emf/tms/data\""
+       << " nbJobs=\"" << nbJobs << "\" nbRunningJobs=\"" << nbJobs / 2 << "\""
+       << " nbWaitingJobs=\"" << nbJobs / 2 << "\">\n";
+    for (int i = 0; i < nbJobs; ++i) {
+      os << "  <jobs sessionId=\"sess_" << i % 7 << "\" submitMachineId=\"machine_1\""
+         << " submitMachineName=\"cluster1\" jobId=\"J_" << i << "\""
+         << " jobName=\"bench &quot;job&quot; " << i << "\" batchJobId=\"" << 100000 + i << "\""
+         << " jobPath=\"/home/user/scripts/job_" << i << ".sh\""
+         << " outputPath=\"/home/user/out/job_" << i << ".out\""
+         << " errorPath=\"/home/user/out/job_" << i << ".err\""
+         << " jobPrio=\"1\" nbCpus=\"4\" jobWorkingDir=\"/home/user/work\""
+         << " status=\"" << i % 9 << "\" submitDate=\"1370000000\" endDate=\"-1\""
+         << " owner=\"user_1\" jobQueue=\"batch\" wallClockLimit=\"3600\""
+         << " groupName=\"users\" jobDescription=\"a &lt;bench&gt; job\""
+         << " memLimit=\"1024\" nbNodes=\"1\" nbNodesAndCpuPerNode=\"1:4\"/>\n";
+    }
+    os << "</TMS_Data:ListJobs>\n";
+    return os.str();
+  }
+
+  /**
+   * \brief Time the encoding and decoding of a profile
+   */
+  void
+  bench(const std::string& label,
+        std::string (*serialize)(diet_profile_t*),
+        diet_profile_t* prof, int nbRounds) {
+    using boost::posix_time::microsec_clock;
+    using boost::posix_time::ptime;
+
+    std::string data;
+    ptime start = microsec_clock::universal_time();
+    for (int i = 0; i < nbRounds; ++i) {
+      data = serialize(prof);
+    }
+    ptime middle = microsec_clock::universal_time();
+    for (int i = 0; i < nbRounds; ++i) {
+      my_deserialize(data);
+    }
+    ptime end = microsec_clock::universal_time();
+
+    std::cout << boost::format("%1%: %2% bytes, serialize %3% ms, deserialize %4% ms\n")
+      % label
+      % data.size()
+      % ((middle - start).total_microseconds() / 1000. / nbRounds)
+      % ((end - middle).total_microseconds() / 1000. / nbRounds);
+  }
+}
+
+int
+main(int argc, char** argv) {
+  int nbJobs = (argc > 1) ? boost::lexical_cast<int>(argv[1]) : 10000;
+  int nbRounds = (argc > 2) ? boost::lexical_cast<int>(argv[2]) : 10;
+
+  // shape of a listJobs answer: status, serialized ListJobs
+  diet_profile_t* prof = diet_profile_alloc("getListOfJobs@cluster1", 2);
+  diet_string_set(prof, 0, "success");
+  diet_string_set(prof, 1, makeListJobs(nbJobs));
+
+  std::cout << boost::format("listJobs response with %1% jobs, %2% rounds\n")
+    % nbJobs % nbRounds;
+  bench("json  ", &my_serialize, prof, nbRounds);
+  bench("binary", &BinaryProfile::serialize, prof, nbRounds);
+
+  diet_profile_free(prof);
+  return 0;
+}
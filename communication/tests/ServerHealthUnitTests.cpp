@@ -0,0 +1,51 @@
+#include <boost/test/unit_test.hpp>
+#include <string>
+#include "ServerHealth.hpp"
+
+static const std::string healthUri("tcp://localhost:5555");
+
+
+BOOST_AUTO_TEST_SUITE( server_health_unit_tests )
+
+
+BOOST_AUTO_TEST_CASE( test_unknown_n )
+{
+// Test that an unknown server can be tried but has to be probed
+  ServerHealth health;
+  BOOST_REQUIRE(health.isAvailable(healthUri));
+  BOOST_REQUIRE(!health.isKnownHealthy(healthUri));
+  BOOST_REQUIRE_EQUAL(health.getFailureCount(healthUri), 0);
+}
+
+BOOST_AUTO_TEST_CASE( test_success_n )
+{
+// Test that a server which answered is trusted
+  ServerHealth health;
+  health.markSuccess(healthUri);
+  BOOST_REQUIRE(health.isAvailable(healthUri));
+  BOOST_REQUIRE(health.isKnownHealthy(healthUri));
+}
+
+BOOST_AUTO_TEST_CASE( test_failure_backoff_n )
+{
+// Test that a dead server is left aside until its backoff expires
+  ServerHealth health(60, 600, 30);
+  health.markFailure(healthUri);
+  BOOST_REQUIRE(!health.isAvailable(healthUri));
+  BOOST_REQUIRE(!health.isKnownHealthy(healthUri));
+  health.markFailure(healthUri);
+  BOOST_REQUIRE_EQUAL(health.getFailureCount(healthUri), 2);
+}
+
+BOOST_AUTO_TEST_CASE( test_failure_recovery_n )
+{
+// Test that a success resets the failures
+  ServerHealth health(0, 0, 30);
+  health.markFailure(healthUri);
+  BOOST_REQUIRE(health.isAvailable(healthUri));
+  health.markSuccess(healthUri);
+  BOOST_REQUIRE_EQUAL(health.getFailureCount(healthUri), 0);
+  BOOST_REQUIRE(health.isKnownHealthy(healthUri));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -5,6 +5,11 @@ setsockopt(int p1, int* p2, int p3){
   return true;
 }
 
+void
+getsockopt(int p1, void* p2, size_t* p3){
+  memset(p2, 0, *p3);
+}
+
 namespace zmq {
 
 
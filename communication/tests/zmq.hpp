@@ -1,6 +1,9 @@
 #include <iostream>
 #include <cstdlib>
 #include <cstring>
+#include <deque>
+#include <string>
+#include <vector>
 
 #ifndef TOTO
 #define TOTO
@@ -13,15 +16,24 @@
 #define ZMQ_ROUTER 1
 #define ZMQ_DEALER 1
 #define ZMQ_QUEUE 1
+#define ZMQ_PUSH 1
+#define ZMQ_PULL 1
+#define ZMQ_SNDMORE 2
+#define ZMQ_RCVMORE 13
 
 bool
 setsockopt(int p1, int* p2, int p3);
 
+void
+getsockopt(int p1, void* p2, size_t* p3);
+
 
 namespace zmq {
 
 typedef int context_t;
 
+typedef void (free_fn)(void* data, void* hint);
+
 class error_t : public std::exception {
 public:
   error_t(){}
@@ -35,46 +47,51 @@ public:
 
 class message_t{
 public:
-  message_t() : mbuff("ok") {
-    msize = mbuff.length();
+  message_t() {
+    assign("ok", 2);
+  }
+
+  message_t(const std::string& p1) {
+    assign("ok", 2);
   }
 
-  message_t(const std::string& p1) : mbuff("ok") {
-    msize = mbuff.length();
+  message_t(int p1) : mbuff(p1) {
   }
 
-  message_t(int p1) : mbuff("ok") {
-    msize = mbuff.length();
+  message_t(void* p1, size_t p2, free_fn* ffn, void* hint) {
+    assign(static_cast<char*>(p1), p2);
+    ffn(p1, hint);
   }
 
   void*
   data(){
-    char* s = static_cast<char *>(malloc(sizeof(char) * mbuff.length()));
-    memcpy(s, mbuff.c_str(), mbuff.length() + 1);
-    return s;
+    return mbuff.empty() ? NULL : &mbuff[0];
   }
 
   int
   size(){
-    return msize;
+    return mbuff.size();
+  }
+
+  // not in zmq, sets the content of a received message
+  void
+  assign(const char* p1, size_t p2){
+    mbuff.assign(p1, p1 + p2);
   }
 
 private :
-  int msize;
-  std::string mbuff;
+  std::vector<char> mbuff;
 };
 
 
+// a socket connected to "echo" receives the frames it sent
 class socket_t{
 public:
   socket_t(context_t p1, int p2){
   }
   bool
   send(message_t msg, int flag){
-    if (maddr.compare("bad")==0){
-      return false;
-    }
-    return true;
+    return send(msg);
   }
 
   bool
@@ -82,6 +99,9 @@ public:
     if (maddr.compare("bad")==0){
       return false;
     }
+    if (maddr.compare("echo")==0){
+      mframes.push_back(std::string(static_cast<char*>(msg.data()), msg.size()));
+    }
     return true;
   }
 
@@ -90,15 +110,16 @@ public:
     if (maddr.compare("bad")==0){
       return false;
     }
+    if (maddr.compare("echo")==0 && !mframes.empty()){
+      msg->assign(mframes.front().data(), mframes.front().size());
+      mframes.pop_front();
+    }
     return true;
   }
 
   bool
   recv(message_t* msg, int flag){
-    if (maddr.compare("bad")==0){
-      return false;
-    }
-    return true;
+    return recv(msg);
   }
 
   void
@@ -111,6 +132,7 @@ public:
   }
 private :
   std::string maddr;
+  std::deque<std::string> mframes;
 };
 
 
@@ -10,6 +10,7 @@
 #include <iostream>
 #include <cstring>
 #include <cerrno>
+#include <stdint.h>
 
 #include <zmq.hpp>
 #include <boost/format.hpp>
@@ -23,6 +24,11 @@
  */
 const int DEFAULT_TIMEOUT = 120; // seconds
 
+/**
+ * \brief The default number of attempts of a request
+ */
+const int DEFAULT_RETRIES = 3;
+
 /**
  * \class Socket
  * \brief wraps zmq::socket_t to simplify its use
@@ -77,14 +83,15 @@ public:
   }
 
   /**
-   * \brief send data
+   * \brief send data. The frame carries its length, no trailing NUL is
+   * appended.
    * \param data string to be sent
    * \param flags zmq flags
    * \return true if it succeeded
    */
   bool
   send(const std::string& data, int flags = 0) {
-    return send(data.c_str(), data.length()+1, flags);
+    return send(data.data(), data.length(), flags);
   }
 
   /**
@@ -95,7 +102,23 @@ public:
    */
   bool
   send(const char* data, int flags = 0) {
-    return send(data, strlen(data)+1, flags);
+    return send(data, strlen(data), flags);
+  }
+
+  /**
+   * \brief send data without copying it, zmq takes over the buffer and
+   * releases it once sent
+   * \param data string to be sent, left empty on return
+   * \param flags zmq flags
+   * \return true if it succeeded
+   */
+  bool
+  sendZeroCopy(std::string& data, int flags = 0) {
+    std::string* owned = new std::string;
+    owned->swap(data);
+    zmq::message_t msg(const_cast<char*>(owned->data()), owned->size(),
+                       &Socket::releaseString, owned);
+    return socket_t::send(msg, flags);
   }
 
   /**
@@ -105,7 +128,89 @@ public:
    */
   std::string
   get(int flags = 0) {
+    std::string ret;
+    get(ret, flags);
+    return ret;
+  }
+
+  /**
+   * \brief get response for server into a buffer, reusing its storage.
+   * A trailing NUL, appended by older peers, is dropped.
+   * \param buffer OUT, the message
+   * \param flags zmq flags
+   */
+  void
+  get(std::string& buffer, int flags = 0) {
+    zmq::message_t message;
+    receive(message, flags);
+    size_t size = message.size();
+    const char* data = static_cast<const char*>(message.data());
+    if (size > 0 && data[size - 1] == '\0') {
+      --size;
+    }
+    buffer.assign(data, size);
+  }
+
+  /**
+   * \brief get a frame as is, unlike get nothing is removed so it is
+   * suited to binary frames such as socket identities
+   * \param flags zmq flags
+   * \return the frame
+   */
+  std::string
+  getRaw(int flags = 0) {
     zmq::message_t message;
+    receive(message, flags);
+    return std::string(static_cast<char*>(message.data()), message.size());
+  }
+
+  /**
+   * \brief send an empty frame, used as envelope delimiter
+   * \param flags zmq flags
+   * \return true if it succeeded
+   */
+  bool
+  sendDelimiter(int flags = ZMQ_SNDMORE) {
+    zmq::message_t msg(0);
+    return socket_t::send(msg, flags);
+  }
+
+  /**
+   * \brief tells whether the last received frame is followed by others
+   * \return true if more frames are pending
+   */
+  bool
+  hasMore() {
+    int64_t more(0);
+    size_t moreSize = sizeof(more);
+    getsockopt(ZMQ_RCVMORE, &more, &moreSize);
+    return (more != 0);
+  }
+
+private:
+  /**
+   * \brief internal method that sends message
+   * \param data buffer to be sent
+   * \param len size of the buffer
+   * \param flags zmq flags
+   * \return true if it succeeded
+   */
+  bool
+  send(const char* data, size_t len, int flags = 0) {
+    zmq::message_t msg(len);
+    memcpy(msg.data(), data, len);
+    return socket_t::send(msg, flags);
+  }
+
+  /**
+   * \brief internal method that receives a frame, retrying when
+   * interrupted by a signal
+   * \param message OUT, the frame
+   * \param flags zmq flags
+   * \throw error_t if it fails
+   */
+  void
+  receive(zmq::message_t& message, int flags) {
     bool rv = false;
 
     do {
@@ -124,44 +229,16 @@ public:
     if (!rv) {
       throw zmq::error_t();
     }
-
-    char* decData;
-    int decDataLength = message.size();
-    //    if (cipher != NULL) {
-    //      decDataLength = cipher->aesDecrypt(reinterpret_cast<unsigned char*>(message.data()), decDataLength, &decData);
-    //    } else {
-    decData = static_cast<char*>(message.data());
-    //   }
-    const char* pos = decData + decDataLength;
-    std::string ret = std::string(static_cast<const char*>(decData), pos);
-    ret.erase(std::remove(ret.begin(), ret.end(), '\0'), ret.end());
-    return ret;
   }
 
-private:
   /**
-   * \brief internal method that sends message
-   * \param data buffer to be sent
-   * \param len size of the buffer
-   * \param flags zmq flags
-   * \return true if it succeeded
+   * \brief release the buffer of a message sent by sendZeroCopy
+   * \param data the buffer
+   * \param hint the string owning the buffer
    */
-  bool
-  send(const char* data, size_t len, int flags = 0) {
-
-    unsigned char* encData;
-    int encDataLength = len;
-    //    if (cipher != NULL) {
-    //      encDataLength = cipher->aesEncrypt(data, len, &encData);
-    //    } else {
-    char* tmp = const_cast<char*>(data);
-    encData = reinterpret_cast<unsigned char*>(tmp);
-    //    }
-
-    zmq::message_t msg(encDataLength);
-    memcpy(msg.data(), encData, encDataLength);
-
-    return socket_t::send(msg, flags);
+  static void
+  releaseString(void* data, void* hint) {
+    delete static_cast<std::string*>(hint);
   }
 };
 
@@ -190,12 +267,14 @@ public:
    * \brief most of the pattern is implemented here
    * \param data message to be sent
    * \param retries number of retries
+   * \param routing if not empty, sent in a first frame ahead of data
    * \return true if it succeeded
    */
   bool
-  send(const std::string& data, int retries = 3) {
+  send(const std::string& data, int retries = DEFAULT_RETRIES,
+       const std::string& routing = "") {
     while (retries) {
-      sock_->send(data);
+      sendRequest(data, routing);
       bool expect_reply(true);
 
       while (expect_reply) {
@@ -203,7 +282,7 @@ public:
         zmq::poll(&items[0], 1, timeout_);
 
         if (items[0].revents & ZMQ_POLLIN) {
-          buff_ = sock_->get();
+          sock_->get(buff_);
           if (buff_.length()) {
             return true;
           } else {
@@ -224,7 +303,7 @@ public:
               std::cerr << boost::format("W: no response from %1%, retrying ...\n") % addr_;
             }
             reset();
-            sock_->send(data);
+            sendRequest(data, routing);
           }
         }
       }
@@ -240,8 +319,57 @@ public:
     return buff_;
   }
 
+  /**
+   * \brief Take the message received without copying it
+   * \param data OUT, the message
+   */
+  void
+  recv(std::string& data) {
+    data.swap(buff_);
+    buff_.clear();
+  }
+
+  /**
+   * \brief Change the timeout used for the next requests
+   * \param timeout the timeout in seconds
+   */
+  void
+  setTimeout(int timeout) {
+    timeout_ = timeout * 1000000L;
+  }
+
+  /**
+   * \brief Change the verbosity used for the next requests
+   * \param verbosity the verbosity level
+   */
+  void
+  setVerbosity(int verbosity) {
+    _verbosity = verbosity;
+  }
+
+  /**
+   * \brief Get the address the client is connected to
+   */
+  const std::string&
+  getAddress() const {
+    return addr_;
+  }
+
 
 private:
+  /**
+   * \brief Send the request, with its routing frame if any
+   * \param data message to be sent
+   * \param routing the routing frame (none if empty)
+   */
+  void
+  sendRequest(const std::string& data, const std::string& routing) {
+    if (!routing.empty()) {
+      sock_->send(routing, ZMQ_SNDMORE);
+    }
+    sock_->send(data);
+  }
+
   /**
    * \brief Reset the connection
    */
@@ -0,0 +1,105 @@
+#!/bin/sh
+#
+# Upgrade the schema of an existing VISHNU database.
+#
+# The migrations below are applied in order, each one at most once: the
+# applied versions are recorded in the schemaversion table, created if
+# missing. A database created with postgre_create.sql or mysql_create.sql
+# already contains them all.
+#
+# A database upgraded by hand with some of the database_update_*.sql
+# scripts can be marked as up to date until a given version with
+# <baseline_version>, without running them again.
+#
+# The password is read from ~/.pgpass or PGPASSWORD (PostgreSQL), and from
+# ~/.my.cnf or MYSQL_PWD (MySQL). Stop the VISHNU servers first.
+#
+
+# version:name, the script being database_update_<name>_<postgre|mysql>.sql
+MIGRATIONS="1:idcounter 2:indexes"
+
+if [ $# -lt 3 ] || [ $# -gt 4 ]; then
+    echo "Usage: " $0 " <postgresql|mysql> <database_name> <database_username> [baseline_version]"
+    exit 1
+fi
+
+dbType=$1
+dbName=$2
+dbUser=$3
+baseline=${4:-0}
+scriptDir=$(cd "$(dirname "$0")" && pwd)
+
+case $dbType in
+    postgresql)
+        suffix=postgre
+        run_sql() {
+            psql -q -X -v ON_ERROR_STOP=1 -U "$dbUser" -d "$dbName" "$@"
+        }
+        query() {
+            run_sql -t -A -c "$1"
+        }
+        versionTable="CREATE TABLE IF NOT EXISTS schemaversion (
+                        version integer NOT NULL PRIMARY KEY,
+                        name character varying(64) NOT NULL,
+                        applied timestamp without time zone DEFAULT CURRENT_TIMESTAMP);
+                      GRANT SELECT, INSERT, UPDATE, DELETE ON schemaversion TO \"vishnu_user\";"
+        ;;
+    mysql)
+        suffix=mysql
+        run_sql() {
+            mysql -u "$dbUser" "$dbName" "$@"
+        }
+        query() {
+            run_sql -N -B -e "$1"
+        }
+        versionTable="CREATE TABLE IF NOT EXISTS schemaversion (
+                        version int(11) NOT NULL PRIMARY KEY,
+                        name varchar(64) NOT NULL,
+                        applied timestamp NOT NULL DEFAULT CURRENT_TIMESTAMP
+                      ) ENGINE=InnoDB DEFAULT CHARSET=latin1;"
+        ;;
+    *)
+        echo "Unknown database type: $dbType"
+        exit 1
+        ;;
+esac
+
+query "$versionTable" || exit 1
+
+current=$(query "SELECT COALESCE(MAX(version), 0) FROM schemaversion") || exit 1
+echo "Current schema version: $current"
+
+for migration in $MIGRATIONS; do
+    version=${migration%%:*}
+    name=${migration#*:}
+    if [ "$version" -le "$current" ]; then
+        continue
+    fi
+    record="INSERT INTO schemaversion (version, name) VALUES ($version, '$name');"
+
+    if [ "$version" -le "$baseline" ]; then
+        echo "Marking version $version ($name) as applied"
+        query "$record" || exit 1
+        continue
+    fi
+
+    script="$scriptDir/database_update_${name}_${suffix}.sql"
+    if [ ! -f "$script" ]; then
+        echo "Missing migration script: $script"
+        exit 1
+    fi
+    echo "Applying version $version ($name)"
+    # PostgreSQL runs each migration in a transaction, MySQL commits DDL
+    # statements at once: a failed migration must then be fixed by hand
+    if [ "$dbType" = "postgresql" ]; then
+        { echo "BEGIN;"; cat "$script"; echo "$record"; echo "COMMIT;"; } | run_sql
+    else
+        { cat "$script"; echo "$record"; } | run_sql
+    fi
+    if [ $? -ne 0 ]; then
+        echo "Migration to version $version failed"
+        exit 1
+    fi
+done
+
+echo "Schema is up to date"
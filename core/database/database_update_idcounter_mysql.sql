@@ -0,0 +1,19 @@
+-- This script is for update of the VISHNU database content
+-- Script name          : database_update_idcounter_mysql.sql
+-- Script owner         : SysFera SA
+
+-- REVISIONS
+-- Revision nb          : 1.0
+-- Revision date        : 18/10/26
+-- Revision author      : Haikel Guemar <haikel.guemar@sysfera.com>
+-- Revision comment     : counters of the generated ids, reserved by blocks.
+--                        The servers start them after the existing rows.
+
+CREATE TABLE idcounter (
+  name VARCHAR(32) NOT NULL,
+  value BIGINT NOT NULL,
+  PRIMARY KEY (name)
+);
+
+GRANT SELECT, INSERT, UPDATE, DELETE ON idcounter TO "vishnu_db_admin";
+GRANT SELECT, INSERT, UPDATE, DELETE ON idcounter TO "vishnu_user";
@@ -0,0 +1,30 @@
+-- This script is for update of the VISHNU database content
+-- Script name          : database_update_indexes_mysql.sql
+-- Script owner         : SysFera SA
+
+-- REVISIONS
+-- Revision nb          : 1.0
+-- Revision date        : 18/10/26
+-- Revision author      : Haikel Guemar <haikel.guemar@sysfera.com>
+-- Revision comment     : indexes matching the queries of the servers and
+--                        of the monitor. The foreign keys are already
+--                        indexed by InnoDB. Stop the servers first.
+
+-- session checks, export and closure on timeout
+CREATE INDEX vsession_sessionkey_idx ON vsession (sessionkey);
+CREATE INDEX vsession_vsessionid_idx ON vsession (vsessionid);
+CREATE INDEX vsession_state_closepolicy_idx ON vsession (state, closepolicy);
+
+-- job lookups, MonitorXMS::checkJobs and the job listings of a machine
+CREATE INDEX job_jobid_idx ON job (jobid);
+CREATE INDEX job_submitmachineid_batchtype_status_idx ON job (submitmachineid, batchtype, status);
+CREATE INDEX job_submitmachineid_submitdate_idx ON job (submitmachineid, submitdate);
+
+-- commands of a session, ordered by start time
+CREATE INDEX command_vsession_numsessionid_starttime_idx ON command (vsession_numsessionid, starttime);
+
+-- transfers in progress and transfer lookups
+CREATE INDEX filetransfer_status_idx ON filetransfer (status);
+CREATE INDEX filetransfer_transferid_idx ON filetransfer (transferid);
+
+ANALYZE TABLE vsession, job, command, filetransfer;
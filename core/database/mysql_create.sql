@@ -305,6 +305,7 @@ CREATE TABLE `command` (
   `vsession_numsessionid` bigint(20) NOT NULL,
   PRIMARY KEY (`numcommandid`),
   KEY `FK38A5DF4BF58538BC` (`vsession_numsessionid`),
+  KEY `command_vsession_numsessionid_starttime_idx` (`vsession_numsessionid`,`starttime`),
   CONSTRAINT `FK38A5DF4BF58538BC` FOREIGN KEY (`vsession_numsessionid`) REFERENCES `vsession` (`numsessionid`) ON DELETE CASCADE
 ) ENGINE=InnoDB AUTO_INCREMENT=2450 DEFAULT CHARSET=latin1;
 /*!40101 SET character_set_client = @saved_cs_client */;
@@ -352,6 +353,8 @@ CREATE TABLE `filetransfer` (
   `vsession_numsessionid` bigint(20) NOT NULL,
   PRIMARY KEY (`numfiletransferid`),
   KEY `FKFCE97167F58538BC` (`vsession_numsessionid`),
+  KEY `filetransfer_status_idx` (`status`),
+  KEY `filetransfer_transferid_idx` (`transferid`),
   CONSTRAINT `FKFCE97167F58538BC` FOREIGN KEY (`vsession_numsessionid`) REFERENCES `vsession` (`numsessionid`) ON DELETE CASCADE
 ) ENGINE=InnoDB DEFAULT CHARSET=latin1;
 /*!40101 SET character_set_client = @saved_cs_client */;
@@ -392,6 +395,35 @@ CREATE TABLE `global_project_role_permissions` (
 ) ENGINE=InnoDB DEFAULT CHARSET=latin1;
 /*!40101 SET character_set_client = @saved_cs_client */;
 
+--
+-- Table structure for table `idcounter`
+--
+
+DROP TABLE IF EXISTS `idcounter`;
+/*!40101 SET @saved_cs_client     = @@character_set_client */;
+/*!40101 SET character_set_client = utf8 */;
+CREATE TABLE `idcounter` (
+  `name` varchar(32) NOT NULL,
+  `value` bigint(20) NOT NULL,
+  PRIMARY KEY (`name`)
+) ENGINE=InnoDB DEFAULT CHARSET=latin1;
+/*!40101 SET character_set_client = @saved_cs_client */;
+
+--
+-- Table structure for table `schemaversion`
+--
+
+DROP TABLE IF EXISTS `schemaversion`;
+/*!40101 SET @saved_cs_client     = @@character_set_client */;
+/*!40101 SET character_set_client = utf8 */;
+CREATE TABLE `schemaversion` (
+  `version` int(11) NOT NULL,
+  `name` varchar(64) NOT NULL,
+  `applied` timestamp NOT NULL DEFAULT CURRENT_TIMESTAMP,
+  PRIMARY KEY (`version`)
+) ENGINE=InnoDB DEFAULT CHARSET=latin1;
+/*!40101 SET character_set_client = @saved_cs_client */;
+
 --
 -- Table structure for table `job`
 --
@@ -438,6 +470,9 @@ CREATE TABLE `job` (
   KEY `FK19BBDF58538BC` (`vsession_numsessionid`),
   KEY `FK19BBD9207FB3B` (`machine_id`),
   KEY `FK19BBD355BF2A6` (`job_owner_id`),
+  KEY `job_jobid_idx` (`jobid`),
+  KEY `job_submitmachineid_batchtype_status_idx` (`submitmachineid`,`batchtype`,`status`),
+  KEY `job_submitmachineid_submitdate_idx` (`submitmachineid`,`submitdate`),
   CONSTRAINT `FK19BBD355BF2A6` FOREIGN KEY (`job_owner_id`) REFERENCES `users` (`numuserid`) ON DELETE CASCADE,
   CONSTRAINT `FK19BBD9207FB3B` FOREIGN KEY (`machine_id`) REFERENCES `machine` (`nummachineid`) ON DELETE CASCADE,
   CONSTRAINT `FK19BBDF381DC90` FOREIGN KEY (`workId`) REFERENCES `work` (`id`) ON DELETE CASCADE,
@@ -938,6 +973,9 @@ CREATE TABLE `vsession` (
   PRIMARY KEY (`numsessionid`),
   KEY `FK581B3160C401BD40` (`clmachine_numclmachineid`),
   KEY `FK581B3160A63719F2` (`users_numuserid`),
+  KEY `vsession_sessionkey_idx` (`sessionkey`),
+  KEY `vsession_vsessionid_idx` (`vsessionid`),
+  KEY `vsession_state_closepolicy_idx` (`state`,`closepolicy`),
   CONSTRAINT `FK581B3160A63719F2` FOREIGN KEY (`users_numuserid`) REFERENCES `users` (`numuserid`) ON DELETE CASCADE,
   CONSTRAINT `FK581B3160C401BD40` FOREIGN KEY (`clmachine_numclmachineid`) REFERENCES `clmachine` (`numclmachineid`) ON DELETE CASCADE
 ) ENGINE=InnoDB AUTO_INCREMENT=1129 DEFAULT CHARSET=latin1;
@@ -1007,6 +1045,7 @@ GRANT SELECT, INSERT, UPDATE, DELETE ON process TO "vishnu_db_admin";
 GRANT SELECT, INSERT, UPDATE, DELETE ON authaccount TO "vishnu_db_admin";
 GRANT SELECT, INSERT, UPDATE, DELETE ON authsystem TO "vishnu_db_admin";
 GRANT SELECT, INSERT, UPDATE, DELETE ON ldapauthsystem TO "vishnu_db_admin";
+GRANT SELECT, INSERT, UPDATE, DELETE ON idcounter TO "vishnu_db_admin";
 GRANT SELECT, INSERT, UPDATE, DELETE ON work TO "vishnu_db_admin";
 
 
@@ -1032,4 +1071,10 @@ GRANT SELECT, INSERT, UPDATE, DELETE ON process TO "vishnu_user";
 GRANT SELECT, INSERT, UPDATE, DELETE ON authaccount TO "vishnu_user";
 GRANT SELECT, INSERT, UPDATE, DELETE ON authsystem TO "vishnu_user";
 GRANT SELECT, INSERT, UPDATE, DELETE ON ldapauthsystem TO "vishnu_user";
+GRANT SELECT, INSERT, UPDATE, DELETE ON idcounter TO "vishnu_user";
 GRANT SELECT, INSERT, UPDATE, DELETE ON work TO "vishnu_user";
+GRANT SELECT, INSERT, UPDATE, DELETE ON schemaversion TO "vishnu_user";
+
+-- the migrations of database_migrate.sh already contained in this schema
+INSERT INTO schemaversion (version, name) VALUES (1, 'idcounter');
+INSERT INTO schemaversion (version, name) VALUES (2, 'indexes');
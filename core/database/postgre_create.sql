@@ -1070,6 +1070,31 @@ ALTER TABLE public.users_numuserid_seq OWNER TO vishnu_user;
 ALTER SEQUENCE users_numuserid_seq OWNED BY users.numuserid;
 
 
+--
+-- Name: idcounter; Type: TABLE; Schema: public; Owner: vishnu_user; Tablespace: 
+--
+
+CREATE TABLE idcounter (
+    name character varying(32) NOT NULL,
+    value bigint NOT NULL
+);
+
+
+ALTER TABLE public.idcounter OWNER TO vishnu_user;
+
+--
+-- Name: schemaversion; Type: TABLE; Schema: public; Owner: vishnu_user; Tablespace: 
+--
+
+CREATE TABLE schemaversion (
+    version integer NOT NULL,
+    name character varying(64) NOT NULL,
+    applied timestamp without time zone DEFAULT CURRENT_TIMESTAMP
+);
+
+
+ALTER TABLE public.schemaversion OWNER TO vishnu_user;
+
 --
 -- Name: vishnu; Type: TABLE; Schema: public; Owner: vishnu_user; Tablespace: 
 --
@@ -1697,6 +1722,22 @@ ALTER TABLE ONLY users
     ADD CONSTRAINT users_pkey PRIMARY KEY (numuserid);
 
 
+--
+-- Name: idcounter_pkey; Type: CONSTRAINT; Schema: public; Owner: vishnu_user; Tablespace: 
+--
+
+ALTER TABLE ONLY idcounter
+    ADD CONSTRAINT idcounter_pkey PRIMARY KEY (name);
+
+
+--
+-- Name: schemaversion_pkey; Type: CONSTRAINT; Schema: public; Owner: vishnu_user; Tablespace: 
+--
+
+ALTER TABLE ONLY schemaversion
+    ADD CONSTRAINT schemaversion_pkey PRIMARY KEY (version);
+
+
 --
 -- Name: vishnu_pkey; Type: CONSTRAINT; Schema: public; Owner: vishnu_user; Tablespace: 
 --
@@ -1721,6 +1762,83 @@ ALTER TABLE ONLY work
     ADD CONSTRAINT work_pkey PRIMARY KEY (id);
 
 
+--
+-- Name: vsession_sessionkey_idx; Type: INDEX; Schema: public; Owner: vishnu_user; Tablespace: 
+--
+
+CREATE INDEX vsession_sessionkey_idx ON vsession USING btree (sessionkey);
+
+
+--
+-- Name: vsession_vsessionid_idx; Type: INDEX; Schema: public; Owner: vishnu_user; Tablespace: 
+--
+
+CREATE INDEX vsession_vsessionid_idx ON vsession USING btree (vsessionid);
+
+
+--
+-- Name: vsession_state_closepolicy_idx; Type: INDEX; Schema: public; Owner: vishnu_user; Tablespace: 
+--
+
+CREATE INDEX vsession_state_closepolicy_idx ON vsession USING btree (state, closepolicy);
+
+
+--
+-- Name: job_jobid_idx; Type: INDEX; Schema: public; Owner: vishnu_user; Tablespace: 
+--
+
+CREATE INDEX job_jobid_idx ON job USING btree (jobid);
+
+
+--
+-- Name: job_submitmachineid_batchtype_status_idx; Type: INDEX; Schema: public; Owner: vishnu_user; Tablespace: 
+--
+
+CREATE INDEX job_submitmachineid_batchtype_status_idx ON job USING btree (submitmachineid, batchtype, status);
+
+
+--
+-- Name: job_submitmachineid_submitdate_idx; Type: INDEX; Schema: public; Owner: vishnu_user; Tablespace: 
+--
+
+CREATE INDEX job_submitmachineid_submitdate_idx ON job USING btree (submitmachineid, submitdate);
+
+
+--
+-- Name: job_vsession_numsessionid_idx; Type: INDEX; Schema: public; Owner: vishnu_user; Tablespace: 
+--
+
+CREATE INDEX job_vsession_numsessionid_idx ON job USING btree (vsession_numsessionid);
+
+
+--
+-- Name: command_vsession_numsessionid_starttime_idx; Type: INDEX; Schema: public; Owner: vishnu_user; Tablespace: 
+--
+
+CREATE INDEX command_vsession_numsessionid_starttime_idx ON command USING btree (vsession_numsessionid, starttime);
+
+
+--
+-- Name: filetransfer_status_idx; Type: INDEX; Schema: public; Owner: vishnu_user; Tablespace: 
+--
+
+CREATE INDEX filetransfer_status_idx ON filetransfer USING btree (status);
+
+
+--
+-- Name: filetransfer_transferid_idx; Type: INDEX; Schema: public; Owner: vishnu_user; Tablespace: 
+--
+
+CREATE INDEX filetransfer_transferid_idx ON filetransfer USING btree (transferid);
+
+
+--
+-- Name: filetransfer_vsession_numsessionid_idx; Type: INDEX; Schema: public; Owner: vishnu_user; Tablespace: 
+--
+
+CREATE INDEX filetransfer_vsession_numsessionid_idx ON filetransfer USING btree (vsession_numsessionid);
+
+
 --
 -- Name: fk143bf46a813ac84c; Type: FK CONSTRAINT; Schema: public; Owner: vishnu_user
 --
@@ -2187,6 +2305,7 @@ GRANT SELECT, INSERT, UPDATE, DELETE ON process TO "vishnu_db_admin";
 GRANT SELECT, INSERT, UPDATE, DELETE ON authaccount TO "vishnu_db_admin";
 GRANT SELECT, INSERT, UPDATE, DELETE ON authsystem TO "vishnu_db_admin";
 GRANT SELECT, INSERT, UPDATE, DELETE ON ldapauthsystem TO "vishnu_db_admin";
+GRANT SELECT, INSERT, UPDATE, DELETE ON idcounter TO "vishnu_db_admin";
 
 
 --CREATE ROLE vishnu_user;
@@ -2211,6 +2330,7 @@ GRANT SELECT, INSERT, UPDATE, DELETE ON process TO "vishnu_user";
 GRANT SELECT, INSERT, UPDATE, DELETE ON authaccount TO "vishnu_user";
 GRANT SELECT, INSERT, UPDATE, DELETE ON authsystem TO "vishnu_user";
 GRANT SELECT, INSERT, UPDATE, DELETE ON ldapauthsystem TO "vishnu_user";
+GRANT SELECT, INSERT, UPDATE, DELETE ON idcounter TO "vishnu_user";
 
 --Grant on sequences
 
@@ -2232,7 +2352,8 @@ GRANT ALL ON SEQUENCE process_numprocess_seq TO vishnu_user;
 GRANT ALL ON SEQUENCE authaccount_authaccountid_seq TO "vishnu_user";
 GRANT ALL ON SEQUENCE authsystem_numauthsystemid_seq TO "vishnu_user";
 GRANT ALL ON SEQUENCE ldapauthsystem_ldapauthsystid_seq TO "vishnu_user";
+GRANT SELECT, INSERT, UPDATE, DELETE ON schemaversion TO "vishnu_user";
 
-
-
-
+-- the migrations of database_migrate.sh already contained in this schema
+INSERT INTO schemaversion (version, name) VALUES (1, 'idcounter');
+INSERT INTO schemaversion (version, name) VALUES (2, 'indexes');
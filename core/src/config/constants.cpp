@@ -47,7 +47,22 @@ namespace vishnu {
     /* [34] */ {HAS_UMS, "enableUMS", BOOL_PARAMETER},
     /* [35] */ {HAS_TMS, "enableTMS", BOOL_PARAMETER},
     /* [36] */ {HAS_FMS, "enableFMS", BOOL_PARAMETER},
-    /* [37] */ {IPC_URI_BASE, "ipcUriBase", URI_PARAMETER}
+    /* [37] */ {IPC_URI_BASE, "ipcUriBase", URI_PARAMETER},
+    /* [38] */ {DISP_ELECTION, "disp_electionPolicy", STRING_PARAMETER},
+    /* [39] */ {BINARY_PROFILES, "binaryProfiles", BOOL_PARAMETER},
+    /* [40] */ {DBPOOLTIMEOUT, "databaseConnectionTimeout", INT_PARAMETER},
+    /* [41] */ {SESSIONCACHETTL, "sessionCacheTTL", INT_PARAMETER},
+    /* [42] */ {COMMANDJOURNALDELAY, "commandJournalDelay", INT_PARAMETER},
+    /* [43] */ {DBREPLICAS, "databaseReplicas", STRING_PARAMETER},
+    /* [44] */ {DBREPLICAPOOLSIZE, "databaseReplicaConnectionsNb", INT_PARAMETER},
+    /* [45] */ {DBREPLICAMAXLAG, "databaseReplicaMaxLag", INT_PARAMETER},
+    /* [46] */ {JOBEVENTDIR, "jobEventDirectory", STRING_PARAMETER},
+    /* [47] */ {JOBACCOUNTINGDIR, "jobAccountingDirectory", STRING_PARAMETER},
+    /* [48] */ {JOBPOLLINGINTERVAL, "jobPollingInterval", INT_PARAMETER},
+    /* [49] */ {SESSIONMONITORINTERVAL, "sessionMonitorInterval", INT_PARAMETER},
+    /* [50] */ {FILEMONITORINTERVAL, "fileMonitorInterval", INT_PARAMETER},
+    /* [51] */ {MONITORSHARDCOUNT, "monitorShardCount", INT_PARAMETER},
+    /* [52] */ {MONITORSHARDINDEX, "monitorShardIndex", INT_PARAMETER}
   };
 
   std::map<cloud_env_vars_t, std::string> CLOUD_ENV_VARS =  boost::assign::map_list_of
@@ -60,7 +60,22 @@ namespace vishnu {
     HAS_UMS,
     HAS_TMS,
     HAS_FMS,
-    IPC_URI_BASE
+    IPC_URI_BASE,
+    DISP_ELECTION,
+    BINARY_PROFILES,
+    DBPOOLTIMEOUT,
+    SESSIONCACHETTL,
+    COMMANDJOURNALDELAY,
+    DBREPLICAS,
+    DBREPLICAPOOLSIZE,
+    DBREPLICAMAXLAG,
+    JOBEVENTDIR,
+    JOBACCOUNTINGDIR,
+    JOBPOLLINGINTERVAL,
+    SESSIONMONITORINTERVAL,
+    FILEMONITORINTERVAL,
+    MONITORSHARDCOUNT,
+    MONITORSHARDINDEX
   };
 
   /**
@@ -1,7 +1,38 @@
 #include "Database.hpp"
 
+#include <boost/thread/locks.hpp>
+#include "SystemException.hpp"
+
 Database:: Database(){};
 
 Database::~Database(){};
 
+int
+Database::processBatch(const std::vector<std::string>& requests, int transacId) {
+  for (std::vector<std::string>::const_iterator it = requests.begin(); it != requests.end(); ++it) {
+    process(*it, transacId);
+  }
+  return SUCCESS;
+}
+
+void
+Database::prepare(const std::string& name, const std::string& query) {
+  boost::lock_guard<boost::mutex> lock(mstatementMutex);
+  std::map<std::string, std::string>::const_iterator it = mstatements.find(name);
+  if (it == mstatements.end()) {
+    mstatements[name] = query;
+  } else if (it->second != query) {
+    // the connections may already hold the former version
+    throw SystemException(ERRCODE_DBERR, "The statement " + name + " is already prepared with another request");
+  }
+}
 
+std::string
+Database::getStatement(const std::string& name) {
+  boost::lock_guard<boost::mutex> lock(mstatementMutex);
+  std::map<std::string, std::string>::const_iterator it = mstatements.find(name);
+  if (it == mstatements.end()) {
+    throw SystemException(ERRCODE_DBERR, "Unknown prepared statement " + name);
+  }
+  return it->second;
+}
@@ -8,9 +8,14 @@
 #ifndef _ABSTRACTDATABASE_H_
 #define _ABSTRACTDATABASE_H_
 
+#include <map>
 #include <string>
+#include <vector>
+#include <boost/thread/mutex.hpp>
+#include "DatabaseCursor.hpp"
 #include "DatabaseResult.hpp"
 #include "DbConfiguration.hpp"
+#include "DbParams.hpp"
 
 static const int SUCCESS = 0;
 /**
@@ -27,6 +32,17 @@ public :
    */
   virtual int
   process(std::string request, int transacId = -1) = 0;
+  /**
+   * \brief Run several requests which do not return rows, sending them
+   * together when the database allows it rather than one round trip each
+   * \param requests The requests, each a SINGLE SQL statement without a semicolon
+   * \param transacId the id of the transaction if one is used
+   * \return raises an exception on the first failing request; the requests
+   * are not guaranteed to be all or nothing outside of a transaction
+   */
+  virtual int
+  processBatch(const std::vector<std::string>& requests, int transacId = -1);
+
   /**
   * \brief To make a connection to the database
   * \return raises an exception on error
@@ -41,6 +57,14 @@ public :
   */
   virtual DatabaseResult*
   getResult(std::string request, int transacId = -1) = 0;
+  /**
+  * \brief To stream the rows of a select request instead of loading them
+  * \param request The request to process
+  * \param transacId the id of the transaction if one is used
+  * \return A cursor on the rows, holding a connection until it is destroyed
+  */
+  virtual DatabaseCursor*
+  getCursor(std::string request, int transacId = -1) = 0;
   /**
    * \brief To get the type of database
    * \return An enum identifying the type of database
@@ -102,6 +126,37 @@ virtual ~Database();
    */
   virtual std::string escapeData(const std::string& data) = 0;
 
+  /**
+   * \brief Register a statement to run through the prepared statement API.
+   * The statement is prepared lazily on each connection of the pool the
+   * first time it runs there, then reused. Registering the same name twice
+   * is harmless as long as the query is the same.
+   * \param name The name of the statement
+   * \param query The request, with a '?' per parameter and no semicolon
+   */
+  virtual void
+  prepare(const std::string& name, const std::string& query);
+
+  /**
+   * \brief Run a prepared statement which does not return rows
+   * \param name The name of the statement
+   * \param params The parameters of the statement
+   * \param transacId the id of the transaction if one is used
+   * \return raises an exception on error
+   */
+  virtual int
+  processPrepared(const std::string& name, const DbParams& params, int transacId = -1) = 0;
+
+  /**
+   * \brief Run a prepared statement returning rows
+   * \param name The name of the statement
+   * \param params The parameters of the statement
+   * \param transacId the id of the transaction if one is used
+   * \return An object which encapsulates the database results
+   */
+  virtual DatabaseResult*
+  getPreparedResult(const std::string& name, const DbParams& params, int transacId = -1) = 0;
+
 
 protected :
   /**
@@ -109,6 +164,14 @@ protected :
    */
   Database();
 
+  /**
+   * \brief Get the request of a registered statement
+   * \param name The name of the statement
+   * \return the request, raises an exception if the name is unknown
+   */
+  std::string
+  getStatement(const std::string& name);
+
 private :
   /**
    * \brief To disconnect from the database
@@ -116,6 +179,16 @@ private :
    */
   virtual int
   disconnect() = 0;
+
+  /**
+   * \brief The registered statements indexed by name
+   */
+  std::map<std::string, std::string> mstatements;
+
+  /**
+   * \brief Mutex protecting the registered statements
+   */
+  boost::mutex mstatementMutex;
 };
 
 
@@ -0,0 +1,138 @@
+/**
+ * \file DatabaseCursor.cpp
+ * \brief This file implements the typed accessors of the database cursors
+ * \author Haikel Guemar (haikel.guemar@sysfera.com)
+ */
+
+#include "DatabaseCursor.hpp"
+
+#include <limits>
+
+// anonymous namespace
+namespace {
+  /**
+   * \brief Parse a signed decimal integer
+   * \param ref the text
+   * \param value OUT, the integer
+   * \return false if the text is not an integer or overflows
+   */
+  bool
+  parseInteger(const DbStringRef& ref, long long& value) {
+    const char* it = ref.data;
+    const char* end = ref.data + ref.size;
+    bool negative = false;
+    if (it != end && (*it == '-' || *it == '+')) {
+      negative = (*it == '-');
+      ++it;
+    }
+    if (it == end) {
+      return false;
+    }
+    unsigned long long res = 0;
+    const unsigned long long limit =
+      static_cast<unsigned long long>(std::numeric_limits<long long>::max()) + (negative ? 1 : 0);
+    for (; it != end; ++it) {
+      if (*it < '0' || *it > '9') {
+        return false;
+      }
+      res = res * 10 + (*it - '0');
+      if (res > limit) {
+        return false;
+      }
+    }
+    value = negative ? -static_cast<long long>(res - 1) - 1 : static_cast<long long>(res);
+    return true;
+  }
+
+  /**
+   * \brief Parse a fixed number of digits
+   * \param it IN/OUT, the first digit, moved after the last one
+   * \param end the end of the text
+   * \param nbDigits the number of digits
+   * \param value OUT, the number
+   * \return false if there are not enough digits
+   */
+  bool
+  parseDigits(const char*& it, const char* end, int nbDigits, int& value) {
+    value = 0;
+    for (int i = 0; i < nbDigits; ++i, ++it) {
+      if (it == end || *it < '0' || *it > '9') {
+        return false;
+      }
+      value = value * 10 + (*it - '0');
+    }
+    return true;
+  }
+
+  /**
+   * \brief Get the number of days between the epoch and a date
+   */
+  long long
+  daysFromCivil(int year, int month, int day) {
+    year -= (month <= 2);
+    long long era = (year >= 0 ? year : year - 399) / 400;
+    long long yoe = year - era * 400;
+    long long doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    long long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+  }
+}
+
+DatabaseCursor::DatabaseCursor() {}
+
+DatabaseCursor::~DatabaseCursor() {}
+
+std::string
+DatabaseCursor::getString(size_t col) const {
+  return getRef(col).str();
+}
+
+int
+DatabaseCursor::getInt(size_t col, int defaultValue) const {
+  long long value;
+  if (isNull(col) || !parseInteger(getRef(col), value)
+      || value < std::numeric_limits<int>::min()
+      || value > std::numeric_limits<int>::max()) {
+    return defaultValue;
+  }
+  return static_cast<int>(value);
+}
+
+long long
+DatabaseCursor::getInt64(size_t col, long long defaultValue) const {
+  long long value;
+  if (isNull(col) || !parseInteger(getRef(col), value)) {
+    return defaultValue;
+  }
+  return value;
+}
+
+std::time_t
+DatabaseCursor::getTime(size_t col) const {
+  if (isNull(col)) {
+    return 0;
+  }
+  DbStringRef ref = getRef(col);
+  const char* it = ref.data;
+  const char* end = ref.data + ref.size;
+
+  int year, month, day;
+  int hour = 0, minute = 0, second = 0;
+  if (!parseDigits(it, end, 4, year) || it == end || *it++ != '-'
+      || !parseDigits(it, end, 2, month) || it == end || *it++ != '-'
+      || !parseDigits(it, end, 2, day)
+      || month < 1 || month > 12 || day < 1 || day > 31) {
+    return 0;
+  }
+  if (it != end) {
+    if ((*it++ != ' ')
+        || !parseDigits(it, end, 2, hour) || it == end || *it++ != ':'
+        || !parseDigits(it, end, 2, minute) || it == end || *it++ != ':'
+        || !parseDigits(it, end, 2, second)) {
+      return 0;
+    }
+    // the fraction of second is dropped
+  }
+  return static_cast<std::time_t>(daysFromCivil(year, month, day) * 86400
+                                  + hour * 3600 + minute * 60 + second);
+}
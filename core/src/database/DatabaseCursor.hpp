@@ -0,0 +1,134 @@
+/**
+ * \file DatabaseCursor.hpp
+ * \brief This file presents the forward-only cursor on the rows of a request
+ * \author Haikel Guemar (haikel.guemar@sysfera.com)
+ */
+
+#ifndef _DATABASECURSOR_HPP_
+#define _DATABASECURSOR_HPP_
+
+#include <ctime>
+#include <string>
+#include <boost/noncopyable.hpp>
+
+/**
+ * \struct DbStringRef
+ * \brief A value of the current row, pointing into the buffers of the
+ * client library. Only valid until the cursor moves.
+ */
+struct DbStringRef {
+  /**
+   * \brief The first character
+   */
+  const char* data;
+  /**
+   * \brief The number of characters
+   */
+  size_t size;
+
+  /**
+   * \brief Copy the value
+   * \return the value
+   */
+  std::string
+  str() const { return std::string(data, size); }
+};
+
+/**
+ * \class DatabaseCursor
+ * \brief Streams the rows of a request one at a time instead of building
+ * a DatabaseResult, so that the memory used doesn't depend on the number
+ * of rows.
+ *
+ * The cursor holds its connection until it reaches the end of the rows or
+ * is destroyed, so it must not be kept while issuing other requests that
+ * may need the same connection.
+ */
+class DatabaseCursor : public boost::noncopyable {
+public:
+  /**
+   * \brief Destructor, releases the connection
+   */
+  virtual ~DatabaseCursor();
+
+  /**
+   * \brief Move to the next row
+   * \return false when there are no more rows
+   */
+  virtual bool
+  next() = 0;
+
+  /**
+   * \brief Get the number of fields of the rows
+   * \return the number of fields
+   */
+  virtual size_t
+  getNbFields() const = 0;
+
+  /**
+   * \brief Get the name of a field
+   * \param col the position of the field
+   * \return the name
+   */
+  virtual std::string
+  getFieldName(size_t col) const = 0;
+
+  /**
+   * \brief Check whether a value of the current row is NULL
+   * \param col the position of the field
+   * \return true if the value is NULL
+   */
+  virtual bool
+  isNull(size_t col) const = 0;
+
+  /**
+   * \brief Get a value of the current row without copying it
+   * \param col the position of the field
+   * \return the value, empty if NULL
+   */
+  virtual DbStringRef
+  getRef(size_t col) const = 0;
+
+  /**
+   * \brief Get a value of the current row as a string
+   * \param col the position of the field
+   * \return the value, empty if NULL
+   */
+  std::string
+  getString(size_t col) const;
+
+  /**
+   * \brief Get a value of the current row as an integer
+   * \param col the position of the field
+   * \param defaultValue the value returned if NULL or not a number
+   * \return the value
+   */
+  int
+  getInt(size_t col, int defaultValue = -1) const;
+
+  /**
+   * \brief Get a value of the current row as a 64 bits integer
+   * \param col the position of the field
+   * \param defaultValue the value returned if NULL or not a number
+   * \return the value
+   */
+  long long
+  getInt64(size_t col, long long defaultValue = -1) const;
+
+  /**
+   * \brief Get a date of the current row (YYYY-MM-DD[ HH:MM:SS[.ffffff]],
+   * read as UTC like vishnu::string_to_time_t)
+   * \param col the position of the field
+   * \return the date in seconds since the epoch, 0 if NULL or invalid
+   */
+  std::time_t
+  getTime(size_t col) const;
+
+protected:
+  /**
+   * \brief Constructor
+   */
+  DatabaseCursor();
+};
+
+#endif // _DATABASECURSOR_HPP_
@@ -8,11 +8,15 @@
 #include "DbConfiguration.hpp"
 #include <iostream>
 #include <boost/format.hpp>
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
 #include <cstdlib>
 
 using namespace std;
 
 const unsigned DbConfiguration::defaultDbPoolSize = 10;  //%RELAX<MISRA_0_1_3> Used in this file
+const unsigned DbConfiguration::defaultDbPoolTimeout = 30;  //%RELAX<MISRA_0_1_3> Used in this file
+const unsigned DbConfiguration::defaultDbReplicaMaxLag = 10;  //%RELAX<MISRA_0_1_3> Used in this file
 
 /**
  * \brief Constructor
@@ -23,7 +27,10 @@ DbConfiguration::DbConfiguration(const ExecConfiguration& execConfig)
   mdbType(POSTGRESQL),
   mdbPort(0),
   mdbPoolSize(defaultDbPoolSize),
-  museSsl(false)
+  mdbPoolTimeout(defaultDbPoolTimeout),
+  museSsl(false),
+  mreplicaPoolSize(defaultDbPoolSize),
+  mreplicaMaxLag(defaultDbReplicaMaxLag)
 {
 }
 
@@ -51,6 +58,34 @@ void DbConfiguration::check() throw (UserException)
   mexecConfig.getRequiredConfigValue<std::string>(vishnu::DBUSERNAME, mdbUserName);
   mexecConfig.getRequiredConfigValue<std::string>(vishnu::DBPASSWORD, mdbPassword);
   mexecConfig.getConfigValue<unsigned>(vishnu::DBPOOLSIZE, mdbPoolSize);
+  mexecConfig.getConfigValue<unsigned>(vishnu::DBPOOLTIMEOUT, mdbPoolTimeout);
+
+  // Read-only replicas: host[:port] separated by commas
+  std::string replicas;
+  if (mexecConfig.getConfigValue<std::string>(vishnu::DBREPLICAS, replicas)) {
+    std::vector<std::string> endpoints;
+    boost::split(endpoints, replicas, boost::is_any_of(","));
+    for (std::vector<std::string>::iterator it = endpoints.begin(); it != endpoints.end(); ++it) {
+      boost::trim(*it);
+      if (it->empty()) {
+        continue;
+      }
+      std::string::size_type colon = it->rfind(':');
+      unsigned port = mdbPort;
+      if (colon != std::string::npos) {
+        try {
+          port = boost::lexical_cast<unsigned>(it->substr(colon + 1));
+        } catch (const boost::bad_lexical_cast&) {
+          throw UserException(ERRCODE_INVALID_PARAM, "Invalid database replica: " + *it);
+        }
+        it->erase(colon);
+      }
+      mreplicas.push_back(std::make_pair(*it, port));
+    }
+  }
+  mreplicaPoolSize = mdbPoolSize;
+  mexecConfig.getConfigValue<unsigned>(vishnu::DBREPLICAPOOLSIZE, mreplicaPoolSize);
+  mexecConfig.getConfigValue<unsigned>(vishnu::DBREPLICAMAXLAG, mreplicaMaxLag);
 
   // SSL params
   bool ret = mexecConfig.getConfigValue<bool>(vishnu::DB_USE_SSL, museSsl);
@@ -64,3 +99,14 @@ void DbConfiguration::check() throw (UserException)
                                "      > Certifcate trust store (CA): %1%\n")%msslCaFile;
   }
 }
+
+DbConfiguration
+DbConfiguration::getReplicaConfiguration(size_t index) const
+{
+  DbConfiguration replica(*this);
+  replica.mdbHost = mreplicas.at(index).first;
+  replica.mdbPort = mreplicas.at(index).second;
+  replica.mdbPoolSize = mreplicaPoolSize;
+  replica.mreplicas.clear();
+  return replica;
+}
@@ -8,6 +8,8 @@
 #ifndef _DBCONFIGURATION_HPP_
 #define _DBCONFIGURATION_HPP_
 
+#include <utility>
+#include <vector>
 #include "ExecConfiguration.hpp"
 #include "UserException.hpp"
 
@@ -33,6 +35,16 @@ public:
    */
   static const unsigned defaultDbPoolSize;
 
+  /**
+   * \brief Default value for the time to wait for a db connection (s)
+   */
+  static const unsigned defaultDbPoolTimeout;
+
+  /**
+   * \brief Default value for the maximum replication lag of a replica (s)
+   */
+  static const unsigned defaultDbReplicaMaxLag;
+
   /**
    * \brief Constructor
    * \param execConfig  the configuration of the program
@@ -93,6 +105,12 @@ public:
    */
   unsigned getDbPoolSize() { return mdbPoolSize; }
 
+  /**
+   * \brief Get the maximum time to wait for a free connection of the pool
+   * \return the timeout in seconds, 0 means no timeout
+   */
+  unsigned getDbPoolTimeout() const { return mdbPoolTimeout; }
+
   /**
    * \brief Gets the value of the property museSsl
    * \return the value of the property museSsl
@@ -105,6 +123,26 @@ public:
    */
   std::string getSslCaFile() { return msslCaFile; }
 
+  /**
+   * \brief Get the number of read-only replicas of the database
+   * \return the number of replicas, 0 if none is configured
+   */
+  size_t getNbReplicas() const { return mreplicas.size(); }
+
+  /**
+   * \brief Get the configuration of a replica, same as this one except for
+   * the host, the port and the size of the pool
+   * \param index the index of the replica
+   * \return the configuration of the replica
+   */
+  DbConfiguration getReplicaConfiguration(size_t index) const;
+
+  /**
+   * \brief Get the maximum replication lag of a replica to be queried
+   * \return the lag in seconds
+   */
+  unsigned getReplicaMaxLag() const { return mreplicaMaxLag; }
+
 protected:
 
   /////////////////////////////////
@@ -151,6 +189,11 @@ protected:
    */
   unsigned mdbPoolSize;
 
+  /**
+   * \brief Attribute maximum wait for a db connection of the pool
+   */
+  unsigned mdbPoolTimeout;
+
   /**
    * \brief Sets whether to use SSL
    */
@@ -161,6 +204,21 @@ protected:
    */
   std::string msslCaFile;
 
+  /**
+   * \brief The host and port of the read-only replicas
+   */
+  std::vector<std::pair<std::string, unsigned> > mreplicas;
+
+  /**
+   * \brief Attribute number of db connections in the pool of each replica
+   */
+  unsigned mreplicaPoolSize;
+
+  /**
+   * \brief Attribute maximum replication lag of a replica to be queried
+   */
+  unsigned mreplicaMaxLag;
+
 };
 
 #endif // _DBCONFIGURATION_HPP_
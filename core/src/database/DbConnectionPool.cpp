@@ -0,0 +1,90 @@
+/**
+ * \file DbConnectionPool.cpp
+ * \brief This file implements the pool of database connection slots
+ * \author Haikel Guemar (haikel.guemar@sysfera.com)
+ */
+
+#include "DbConnectionPool.hpp"
+
+#include <algorithm>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/format.hpp>
+
+#include "SystemException.hpp"
+
+DbConnectionPool::DbConnectionPool(unsigned size, unsigned timeout,
+                                   unsigned idleCheck)
+  : mused(size, false),
+    mlastUse(size, boost::posix_time::microsec_clock::universal_time()),
+    mtimeout(boost::posix_time::seconds(timeout)),
+    midleCheck(boost::posix_time::seconds(idleCheck)) {
+  // pushed backwards so that slot 0 is handed out first
+  for (int i = static_cast<int>(size) - 1; i >= 0; --i) {
+    mfree.push_back(i);
+  }
+  mmetrics.size = size;
+}
+
+int
+DbConnectionPool::acquire(bool& idle) {
+  using boost::posix_time::microsec_clock;
+  using boost::posix_time::ptime;
+
+  boost::unique_lock<boost::mutex> lock(mmutex);
+  ptime start = microsec_clock::universal_time();
+  if (mfree.empty()) {
+    ++mmetrics.waits;
+    ptime deadline = start + mtimeout;
+    while (mfree.empty()) {
+      if (mtimeout.total_seconds() == 0) {
+        mavailable.wait(lock);
+      } else if (!mavailable.timed_wait(lock, deadline) && mfree.empty()) {
+        ++mmetrics.timeouts;
+        throw SystemException(ERRCODE_DBCONN,
+                              boost::str(boost::format("No database connection available after %1%s")
+                                         % mtimeout.total_seconds()));
+      }
+    }
+    double wait = static_cast<double>(
+      (microsec_clock::universal_time() - start).total_microseconds()) / 1000.;
+    mmetrics.totalWait += wait;
+    mmetrics.maxWait = std::max(mmetrics.maxWait, wait);
+  }
+
+  int pos = mfree.back();
+  mfree.pop_back();
+  mused[pos] = true;
+  idle = (midleCheck.total_seconds() != 0)
+    && (microsec_clock::universal_time() - mlastUse[pos] > midleCheck);
+
+  ++mmetrics.acquisitions;
+  ++mmetrics.inUse;
+  mmetrics.maxInUse = std::max(mmetrics.maxInUse, mmetrics.inUse);
+  return pos;
+}
+
+void
+DbConnectionPool::release(int pos) {
+  {
+    boost::lock_guard<boost::mutex> lock(mmutex);
+    if (pos < 0 || static_cast<size_t>(pos) >= mused.size() || !mused[pos]) {
+      throw SystemException(ERRCODE_DBCONN, "Cannot release a connection which is not in use");
+    }
+    mused[pos] = false;
+    mlastUse[pos] = boost::posix_time::microsec_clock::universal_time();
+    mfree.push_back(pos);
+    --mmetrics.inUse;
+  }
+  mavailable.notify_one();
+}
+
+unsigned
+DbConnectionPool::getSize() const {
+  return static_cast<unsigned>(mused.size());
+}
+
+DbPoolMetrics
+DbConnectionPool::getMetrics() const {
+  boost::lock_guard<boost::mutex> lock(mmutex);
+  return mmetrics;
+}
@@ -0,0 +1,152 @@
+/**
+ * \file DbConnectionPool.hpp
+ * \brief This file defines the pool of database connection slots shared by
+ * the database backends
+ * \author Haikel Guemar (haikel.guemar@sysfera.com)
+ */
+
+#ifndef _DBCONNECTIONPOOL_HPP_
+#define _DBCONNECTIONPOOL_HPP_
+
+#include <vector>
+#include <boost/noncopyable.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
+/**
+ * \brief Idle time (s) after which a pooled connection is checked before
+ * being handed out again
+ */
+const unsigned DB_IDLE_CHECK_INTERVAL = 60;
+
+/**
+ * \struct DbPoolMetrics
+ * \brief Statistics on the usage of a connection pool
+ */
+struct DbPoolMetrics {
+  /**
+   * \brief The number of connections in the pool
+   */
+  unsigned size;
+  /**
+   * \brief The number of connections checked out
+   */
+  unsigned inUse;
+  /**
+   * \brief The highest number of connections checked out at the same time
+   */
+  unsigned maxInUse;
+  /**
+   * \brief The number of checkouts
+   */
+  unsigned long acquisitions;
+  /**
+   * \brief The number of checkouts which had to wait for a connection
+   */
+  unsigned long waits;
+  /**
+   * \brief The number of checkouts which gave up waiting
+   */
+  unsigned long timeouts;
+  /**
+   * \brief The time spent waiting for a connection (ms)
+   */
+  double totalWait;
+  /**
+   * \brief The longest wait for a connection (ms)
+   */
+  double maxWait;
+
+  DbPoolMetrics()
+    : size(0), inUse(0), maxInUse(0), acquisitions(0), waits(0),
+      timeouts(0), totalWait(0.), maxWait(0.) {}
+};
+
+/**
+ * \class DbConnectionPool
+ * \brief Hands out the slots of a connection pool to the threads.
+ *
+ * The pool only deals with slot indexes, the backends keep the
+ * connections themselves in an array indexed the same way (the index is
+ * also used as transaction id). Free slots are kept in a free-list, a
+ * thread finding it empty blocks on a condition variable until a slot is
+ * released or the timeout expires.
+ */
+class DbConnectionPool : public boost::noncopyable {
+public:
+  /**
+   * \brief Constructor
+   * \param size the number of slots
+   * \param timeout the maximum time (s) to wait for a slot, 0 to wait forever
+   * \param idleCheck the idle time (s) after which a connection should be
+   * checked before being used again
+   */
+  DbConnectionPool(unsigned size, unsigned timeout, unsigned idleCheck);
+
+  /**
+   * \brief Check out a slot, raises an exception on timeout
+   * \param idle OUT, true if the connection of the slot stayed idle long
+   * enough to need a check
+   * \return the index of the slot
+   */
+  int
+  acquire(bool& idle);
+
+  /**
+   * \brief Give back a slot, raises an exception if it was not checked out
+   * \param pos the index of the slot
+   */
+  void
+  release(int pos);
+
+  /**
+   * \brief Get the number of slots
+   * \return the number of slots
+   */
+  unsigned
+  getSize() const;
+
+  /**
+   * \brief Get the statistics of the pool
+   * \return a copy of the statistics
+   */
+  DbPoolMetrics
+  getMetrics() const;
+
+private:
+  /**
+   * \brief The free slots, the last released comes first
+   */
+  std::vector<int> mfree;
+  /**
+   * \brief Whether each slot is checked out
+   */
+  std::vector<bool> mused;
+  /**
+   * \brief When each slot was last released
+   */
+  std::vector<boost::posix_time::ptime> mlastUse;
+  /**
+   * \brief The maximum wait for a slot
+   */
+  boost::posix_time::time_duration mtimeout;
+  /**
+   * \brief The idle time after which a connection should be checked
+   */
+  boost::posix_time::time_duration midleCheck;
+  /**
+   * \brief The statistics
+   */
+  DbPoolMetrics mmetrics;
+  /**
+   * \brief Mutex protecting the pool
+   */
+  mutable boost::mutex mmutex;
+  /**
+   * \brief Signaled when a slot is released
+   */
+  boost::condition_variable mavailable;
+};
+
+#endif // _DBCONNECTIONPOOL_HPP_
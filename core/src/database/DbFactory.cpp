@@ -7,6 +7,11 @@
 
 #include "DbFactory.hpp"
 
+#include <iostream>
+#include <boost/format.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/locks.hpp>
+#include "DatabaseCursor.hpp"
 #include "SystemException.hpp"
 #ifdef USE_POSTGRES
 #include "POSTGREDatabase.hpp"
@@ -16,6 +21,40 @@
 #endif
 
 Database* DbFactory::mdb = NULL; //%RELAX<MISRA_0_1_3> Used in this file
+std::vector<DbFactory::Replica> DbFactory::mreplicas; //%RELAX<MISRA_0_1_3> Used in this file
+int DbFactory::mreplicaMaxLag = 0; //%RELAX<MISRA_0_1_3> Used in this file
+size_t DbFactory::mnextReplica = 0; //%RELAX<MISRA_0_1_3> Used in this file
+boost::mutex DbFactory::mreplicaMutex; //%RELAX<MISRA_0_1_3> Used in this file
+
+// anonymous namespace
+namespace {
+  /**
+   * \brief Create a database from a configuration
+   * \param config  the configuration of the database
+   * \return A database
+   */
+  Database*
+  newDatabase(const DbConfiguration& config) {
+    switch (config.getDbType()){
+    case DbConfiguration::POSTGRESQL :
+#ifdef USE_POSTGRES
+      return new POSTGREDatabase(config);
+#else
+      throw SystemException(ERRCODE_DBERR, "PostgreSQL is not enabled (re-compile with ENABLE_POSTGRES)");
+#endif
+    case DbConfiguration::MYSQL:
+#ifdef USE_MYSQL
+      return new MYSQLDatabase(config);
+#else
+      throw SystemException(ERRCODE_DBERR, "MySQL is not enabled (re-compile with ENABLE_MYSQL)");
+#endif
+    case DbConfiguration::ORACLE:
+      // Intentional fallthrough, Oracle is not managed
+    default:
+      throw SystemException(ERRCODE_DBERR, "Database instance type unknown or not managed");
+    }
+  }
+}
 
 DbFactory::DbFactory(){
 }
@@ -29,26 +68,7 @@ DbFactory::createDatabaseInstance(DbConfiguration config)
   if (mdb != NULL) {
     throw SystemException(ERRCODE_DBERR, "Database instance already initialized");
   }
-  switch (config.getDbType()){
-  case DbConfiguration::POSTGRESQL :
-#ifdef USE_POSTGRES
-    mdb = new POSTGREDatabase(config);
-#else
-    throw SystemException(ERRCODE_DBERR, "PostgreSQL is not enabled (re-compile with ENABLE_POSTGRES)");
-#endif
-    break;
-  case DbConfiguration::MYSQL:
-#ifdef USE_MYSQL
-    mdb = new MYSQLDatabase(config);
-#else
-    throw SystemException(ERRCODE_DBERR, "MySQL is not enabled (re-compile with ENABLE_MYSQL)");
-#endif
-    break;
-  case DbConfiguration::ORACLE:
-    // Intentional fallthrough, Oracle is not managed
-  default:
-    throw SystemException(ERRCODE_DBERR, "Database instance type unknown or not managed");
-  }
+  mdb = newDatabase(config);
   return mdb;
 }
 
@@ -59,3 +79,107 @@ Database* DbFactory::getDatabaseInstance()
   }
   return mdb;
 }
+
+void
+DbFactory::createReplicaInstances(DbConfiguration config)
+{
+  boost::lock_guard<boost::mutex> lock(mreplicaMutex);
+  if (!mreplicas.empty()) {
+    throw SystemException(ERRCODE_DBERR, "Database replicas already initialized");
+  }
+  mreplicaMaxLag = static_cast<int>(config.getReplicaMaxLag());
+  for (size_t i = 0; i < config.getNbReplicas(); ++i) {
+    DbConfiguration replicaConfig = config.getReplicaConfiguration(i);
+    Database* replica = NULL;
+    try {
+      replica = newDatabase(replicaConfig);
+      replica->connect();
+    } catch (const std::exception& e) {
+      delete replica;
+      std::cerr << boost::format("[WARNING] Skipping the database replica %1%: %2%\n")
+                   % replicaConfig.getDbHost() % e.what();
+      continue;
+    }
+    Replica entry;
+    entry.db = replica;
+    entry.lag = -1;
+    entry.checkTime = 0;
+    entry.measuring = false;
+    mreplicas.push_back(entry);
+  }
+}
+
+Database*
+DbFactory::getReadDatabaseInstance()
+{
+  std::vector<size_t> stale;
+  {
+    boost::lock_guard<boost::mutex> lock(mreplicaMutex);
+    time_t now = std::time(NULL);
+    for (size_t i = 0; i < mreplicas.size(); ++i) {
+      if (!mreplicas[i].measuring && now - mreplicas[i].checkTime >= DB_REPLICA_CHECK_INTERVAL) {
+        mreplicas[i].measuring = true;
+        stale.push_back(i);
+      }
+    }
+  }
+
+  // measured out of the lock, so that a slow replica does not stall the
+  // other listings, which meanwhile rely on the former measure
+  for (size_t i = 0; i < stale.size(); ++i) {
+    time_t checkTime = std::time(NULL);
+    int lag = measureLag(mreplicas[stale[i]].db);
+    boost::lock_guard<boost::mutex> lock(mreplicaMutex);
+    mreplicas[stale[i]].lag = lag;
+    mreplicas[stale[i]].checkTime = checkTime;
+    mreplicas[stale[i]].measuring = false;
+  }
+
+  {
+    boost::lock_guard<boost::mutex> lock(mreplicaMutex);
+    time_t now = std::time(NULL);
+    for (size_t i = 0; i < mreplicas.size(); ++i) {
+      size_t index = (mnextReplica + i) % mreplicas.size();
+      Replica& replica = mreplicas[index];
+      // the replication may have stopped since the lag was measured
+      if (replica.lag >= 0 && replica.lag + (now - replica.checkTime) <= mreplicaMaxLag) {
+        mnextReplica = (index + 1) % mreplicas.size();
+        return replica.db;
+      }
+    }
+  }
+  return getDatabaseInstance();
+}
+
+int
+DbFactory::measureLag(Database* replica)
+{
+  try {
+    switch (replica->getDbType()) {
+    case DbConfiguration::POSTGRESQL: {
+      // a server which is not in recovery is not lagging
+      boost::scoped_ptr<DatabaseCursor> cursor(replica->getCursor(
+        "SELECT CASE WHEN pg_is_in_recovery()"
+        " THEN COALESCE(CAST(EXTRACT(EPOCH FROM now() - pg_last_xact_replay_timestamp()) AS integer), -1)"
+        " ELSE 0 END"));
+      return cursor->next() ? cursor->getInt(0, -1) : -1;
+    }
+    case DbConfiguration::MYSQL: {
+      boost::scoped_ptr<DatabaseCursor> cursor(replica->getCursor("SHOW SLAVE STATUS"));
+      if (!cursor->next()) {
+        return 0;
+      }
+      for (size_t col = 0; col < cursor->getNbFields(); ++col) {
+        if (cursor->getFieldName(col) == "Seconds_Behind_Master") {
+          return cursor->getInt(col, -1);
+        }
+      }
+      return -1;
+    }
+    default:
+      return -1;
+    }
+  } catch (const std::exception& e) {
+    return -1;
+  }
+}
@@ -8,9 +8,17 @@
 #ifndef _DBFACTORY_H_
 #define _DBFACTORY_H_
 
+#include <ctime>
+#include <vector>
+#include <boost/thread/mutex.hpp>
 #include "Database.hpp"
 #include "DbConfiguration.hpp"
 
+/**
+ * \brief Time in seconds after which the lag of a replica is measured again
+ */
+const int DB_REPLICA_CHECK_INTERVAL = 1;
+
 
 /**
  * \class DbFactory
@@ -42,11 +50,66 @@ public :
   Database*
   getDatabaseInstance();
 
+  /**
+   * \brief Create and connect the read-only replicas of a configuration,
+   * the replicas which cannot be reached are left out
+   * \param dbConfig  the configuration of the database
+   */
+  void
+  createReplicaInstances(DbConfiguration dbConfig);
+
+  /**
+   * \brief Get a database for the queries which can read slightly stale
+   * data: a replica lagging less than the configured bound, else the
+   * single instance of the database
+   * \return A database or a nil pointer
+   */
+  Database*
+  getReadDatabaseInstance();
+
 private :
+  /**
+   * \struct Replica
+   * \brief A replica and its last measured lag
+   */
+  struct Replica {
+    Database* db;
+    int lag;
+    time_t checkTime;
+    /**
+     * \brief Whether a thread is measuring the lag
+     */
+    bool measuring;
+  };
+
+  /**
+   * \brief Measure the replication lag of a replica
+   * \param replica the replica
+   * \return the lag in seconds, -1 if unknown or not replicating
+   */
+  static int
+  measureLag(Database* replica);
+
   /**
    * \brief The unique instance of the database
    */
   static Database* mdb;
+  /**
+   * \brief The read-only replicas
+   */
+  static std::vector<Replica> mreplicas;
+  /**
+   * \brief The maximum lag of a replica to be queried
+   */
+  static int mreplicaMaxLag;
+  /**
+   * \brief The replica to try first on the next read
+   */
+  static size_t mnextReplica;
+  /**
+   * \brief Protects the replicas
+   */
+  static boost::mutex mreplicaMutex;
 };
 
 
@@ -0,0 +1,45 @@
+/**
+ * \file DbParams.cpp
+ * \brief This file implements the parameters bound to a prepared statement
+ * \author Haikel Guemar (haikel.guemar@sysfera.com)
+ */
+
+#include "DbParams.hpp"
+
+#include <boost/lexical_cast.hpp>
+
+DbParams&
+DbParams::add(const std::string& value) {
+  mvalues.push_back(value);
+  mtypes.push_back(TEXT);
+  return *this;
+}
+
+DbParams&
+DbParams::add(long value) {
+  mvalues.push_back(boost::lexical_cast<std::string>(value));
+  mtypes.push_back(INTEGER);
+  return *this;
+}
+
+DbParams&
+DbParams::addNull() {
+  mvalues.push_back(std::string());
+  mtypes.push_back(NULLVALUE);
+  return *this;
+}
+
+size_t
+DbParams::size() const {
+  return mvalues.size();
+}
+
+const std::string&
+DbParams::getValue(size_t pos) const {
+  return mvalues.at(pos);
+}
+
+DbParams::param_type_t
+DbParams::getType(size_t pos) const {
+  return mtypes.at(pos);
+}
@@ -0,0 +1,87 @@
+/**
+ * \file DbParams.hpp
+ * \brief This file presents the parameters bound to a prepared statement
+ * \author Haikel Guemar (haikel.guemar@sysfera.com)
+ */
+
+#ifndef _DBPARAMS_HPP_
+#define _DBPARAMS_HPP_
+
+#include <string>
+#include <vector>
+
+/**
+ * \class DbParams
+ * \brief The typed parameters of a prepared statement, in the order of the
+ * placeholders. Values are kept in their text form, the type tells the
+ * backends how to bind them.
+ */
+class DbParams {
+public:
+  /**
+   * \brief The type of a parameter
+   */
+  typedef enum {
+    TEXT,
+    INTEGER,
+    NULLVALUE
+  } param_type_t;
+
+  /**
+   * \brief Add a string parameter
+   * \param value the value, sent as is (no escaping needed)
+   * \return the parameters, to chain the calls
+   */
+  DbParams&
+  add(const std::string& value);
+
+  /**
+   * \brief Add an integer parameter
+   * \param value the value
+   * \return the parameters, to chain the calls
+   */
+  DbParams&
+  add(long value);
+
+  /**
+   * \brief Add a NULL parameter
+   * \return the parameters, to chain the calls
+   */
+  DbParams&
+  addNull();
+
+  /**
+   * \brief Get the number of parameters
+   * \return the number of parameters
+   */
+  size_t
+  size() const;
+
+  /**
+   * \brief Get the text form of a parameter
+   * \param pos the position of the parameter
+   * \return the value, empty for NULL
+   */
+  const std::string&
+  getValue(size_t pos) const;
+
+  /**
+   * \brief Get the type of a parameter
+   * \param pos the position of the parameter
+   * \return the type
+   */
+  param_type_t
+  getType(size_t pos) const;
+
+private:
+  /**
+   * \brief The values
+   */
+  std::vector<std::string> mvalues;
+  /**
+   * \brief The types of the values
+   */
+  std::vector<param_type_t> mtypes;
+};
+
+#endif // _DBPARAMS_HPP_
@@ -6,9 +6,14 @@
  */
 #include "MYSQLDatabase.hpp"
 
+#include <cstring>
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <boost/lexical_cast.hpp>
 #include <boost/scoped_ptr.hpp>
 #include <vector>
 
+#include "SqlEscape.hpp"
 #include "SystemException.hpp"
 #include "utilVishnu.hpp"
 #include "errmsg.h"
@@ -25,6 +30,128 @@ int dbErrorNo(MYSQL *conn) {
   return mysql_errno(conn);
 }
 
+string stmtErrorMsg(MYSQL_STMT *stmt) {
+  const char *msg = mysql_stmt_error(stmt);
+  return (msg && *msg) ? " {" + string(msg) + "}" : "";
+}
+
+// anonymous namespace
+namespace {
+  /**
+   * \class MySQLCursor
+   * \brief Cursor reading the rows as they come with mysql_use_result
+   */
+  class MySQLCursor : public DatabaseCursor {
+  public:
+    /**
+     * \brief Constructor
+     * \param conn the connection the request was sent on
+     * \param res the unbuffered result
+     * \param release gives back the connection, empty in a transaction
+     */
+    MySQLCursor(MYSQL* conn, MYSQL_RES* res, boost::function<void()> release)
+      : mconn(conn), mres(res), mrow(NULL), mlengths(NULL), mrelease(release) {
+      MYSQL_FIELD* field;
+      while ((field = mysql_fetch_field(mres))) {
+        mnames.push_back(string(field->name));
+      }
+    }
+
+    ~MySQLCursor() {
+      if (mres != NULL) {
+        finish();
+      }
+    }
+
+    bool
+    next() {
+      if (mres == NULL) {
+        return false;
+      }
+      mrow = mysql_fetch_row(mres);
+      if (mrow != NULL) {
+        mlengths = mysql_fetch_lengths(mres);
+        return true;
+      }
+      int err = dbErrorNo(mconn);
+      string errorMsg = dbErrorMsg(mconn);
+      finish();
+      if (err) {
+        throw SystemException(ERRCODE_DBERR, "Cannot get query results" + errorMsg);
+      }
+      return false;
+    }
+
+    size_t
+    getNbFields() const {
+      return mnames.size();
+    }
+
+    string
+    getFieldName(size_t col) const {
+      return mnames.at(col);
+    }
+
+    bool
+    isNull(size_t col) const {
+      return mrow[col] == NULL;
+    }
+
+    DbStringRef
+    getRef(size_t col) const {
+      DbStringRef ref = {mrow[col] ? mrow[col] : "", mrow[col] ? mlengths[col] : 0};
+      return ref;
+    }
+
+  private:
+    /**
+     * \brief Free the result and give back the connection
+     */
+    void
+    finish() {
+      // reads and drops the rows left
+      mysql_free_result(mres);
+      mres = NULL;
+      mrow = NULL;
+      // due to CLIENT_MULTI_STATEMENTS, other results may follow
+      while (mysql_next_result(mconn) == 0) {
+        MYSQL_RES* res = mysql_store_result(mconn);
+        if (res) {
+          mysql_free_result(res);
+        }
+      }
+      if (mrelease) {
+        mrelease();
+      }
+    }
+
+    /**
+     * \brief The connection
+     */
+    MYSQL* mconn;
+    /**
+     * \brief The result being read
+     */
+    MYSQL_RES* mres;
+    /**
+     * \brief The current row
+     */
+    MYSQL_ROW mrow;
+    /**
+     * \brief The lengths of the values of the current row
+     */
+    unsigned long* mlengths;
+    /**
+     * \brief The names of the fields
+     */
+    vector<string> mnames;
+    /**
+     * \brief Gives back the connection
+     */
+    boost::function<void()> mrelease;
+  };
+}
+
 int
 MYSQLDatabase::process(string request, int transacId){
   int reqPos;
@@ -50,7 +177,9 @@ MYSQLDatabase::process(string request, int transacId){
   res=mysql_real_query(conn, request.c_str (), request.length());
   if (res) {
     if((dbErrorNo(conn) != CR_SERVER_LOST) && (dbErrorNo(conn) != CR_SERVER_GONE_ERROR)) {
-      throw SystemException(ERRCODE_DBERR, dbErrorMsg(conn));
+      string errorMsg = dbErrorMsg(conn);
+      releaseConnection(reqPos);
+      throw SystemException(ERRCODE_DBERR, errorMsg);
     }
     connectPoolIndex(reqPos);  // try to reinitialise the socket
     res=mysql_real_query(conn, request.c_str (), request.length());
@@ -87,6 +216,20 @@ MYSQLDatabase::process(string request, int transacId){
   releaseConnection(reqPos);
   return SUCCESS;
 }
+
+int
+MYSQLDatabase::processBatch(const std::vector<std::string>& requests, int transacId) {
+  if (requests.empty()) {
+    return SUCCESS;
+  }
+  // CLIENT_MULTI_STATEMENTS lets a single query carry them all
+  string request;
+  for (vector<string>::const_iterator it = requests.begin(); it != requests.end(); ++it) {
+    request += *it + ";";
+  }
+  return process(request, transacId);
+}
+
 /**
  * \brief To make a connection to the database
  * \return raises an exception on error
@@ -96,6 +239,12 @@ MYSQLDatabase::connect(){
   for (unsigned int i=0; i<mconfig.getDbPoolSize();i++) {
     connectPoolIndex(i);
   }
+  // all the connections share the same settings
+  if (mconfig.getDbPoolSize() > 0) {
+    MYSQL* conn = &(mpool[0].mmysql);
+    mlocalEscape = SqlEscape::isSafeCharset(mysql_character_set_name(conn));
+    mnoBackslashEscapes = (conn->server_status & SERVER_STATUS_NO_BACKSLASH_ESCAPES) != 0;
+  }
   return SUCCESS;
 }
 
@@ -134,14 +283,15 @@ MYSQLDatabase::connectPoolIndex(const int& poolIdx) {
  * \brief Constructor, raises an exception on error
  */
 MYSQLDatabase::MYSQLDatabase(DbConfiguration dbConfig)
-  : Database(), mconfig(dbConfig) {
+  : Database(), mconfig(dbConfig), mlocalEscape(false), mnoBackslashEscapes(false) {
   mysql_library_init(0, NULL, NULL);
   mpool = new pool_t[mconfig.getDbPoolSize()];
   for (unsigned int i=0;i<mconfig.getDbPoolSize();i++) {
-    pthread_mutex_init(&(mpool[i].mmutex), NULL);
-    mpool[i].mused = false;
     mysql_init(&(mpool[i].mmysql));
   }
+  mslots.reset(new DbConnectionPool(mconfig.getDbPoolSize(),
+                                    mconfig.getDbPoolTimeout(),
+                                    DB_IDLE_CHECK_INTERVAL));
 }
 
 /**
@@ -159,6 +309,7 @@ MYSQLDatabase::~MYSQLDatabase(){
 int
 MYSQLDatabase::disconnect(){
   for (unsigned int i = 0 ; i < mconfig.getDbPoolSize() ; i++) {
+    closeStatements(i);
     mysql_close (&(mpool[i].mmysql));
   }
   return SUCCESS;
@@ -185,7 +336,9 @@ MYSQLDatabase::getResult(string request, int transacId) {
   if ((res=mysql_real_query(conn, request.c_str (), request.length())) != 0) {
 
     if((dbErrorNo(conn) != CR_SERVER_LOST) && (dbErrorNo(conn) != CR_SERVER_GONE_ERROR)) {
-      throw SystemException(ERRCODE_DBERR, dbErrorMsg(conn));
+      string errorMsg = dbErrorMsg(conn);
+      releaseConnection(reqPos);
+      throw SystemException(ERRCODE_DBERR, errorMsg);
     }
     connectPoolIndex(reqPos);  // try to reinitialise the socket
     res=mysql_real_query(conn, request.c_str (), request.length());
@@ -229,35 +382,61 @@ MYSQLDatabase::getResult(string request, int transacId) {
 }
 
 
+DatabaseCursor*
+MYSQLDatabase::getCursor(string request, int transacId) {
+  int reqPos;
+  MYSQL* conn = NULL;
+  if (transacId==-1) {
+    conn = getConnection(reqPos);
+  } else {
+    reqPos = -1;
+    conn = (&(mpool[transacId].mmysql));
+  }
+
+  if (mysql_real_query(conn, request.c_str (), request.length()) != 0) {
+    if((dbErrorNo(conn) != CR_SERVER_LOST) && (dbErrorNo(conn) != CR_SERVER_GONE_ERROR)) {
+      string errorMsg = dbErrorMsg(conn);
+      releaseConnection(reqPos);
+      throw SystemException(ERRCODE_DBERR, errorMsg);
+    }
+    connectPoolIndex(reqPos);  // try to reinitialise the socket
+    if (mysql_real_query(conn, request.c_str (), request.length())) {
+      string errorMsg = dbErrorMsg(conn);
+      releaseConnection(reqPos);
+      throw SystemException(ERRCODE_DBERR, "S-Query error" + errorMsg);
+    }
+  }
+
+  // the rows stay on the server until fetched
+  MYSQL_RES *result = mysql_use_result(conn);
+  if (!result) {
+    string errorMsg = dbErrorMsg(conn);
+    releaseConnection(reqPos);
+    throw SystemException(ERRCODE_DBERR, "Cannot get query results" + errorMsg);
+  }
+
+  boost::function<void()> release;
+  if (reqPos != -1) {
+    release = boost::bind(&MYSQLDatabase::releaseConnection, this, reqPos);
+  }
+  return new MySQLCursor(conn, result, release);
+}
+
 MYSQL*
 MYSQLDatabase::getConnection(int& id){
-  int i = 0;
-  int locked;
-  // Looking for an unused connection (will block until a connection is free)
-  while (true) {
-    // If the connection is not used
-    if(!mpool[i].mused) {
-      locked = pthread_mutex_trylock(&(mpool[i].mmutex));
-      // If lock fails-> the mutex was taken before trylock call
-      if (locked) {
-        // Try next connexion
-        sleep(2);
-        continue;
-      }
-      else {
-        mpool[i].mused=true;
-        id = i;
-        return &(mpool[i].mmysql);
-      }
-    }
-    i++;
-    // I do not use modulo '%' because i need to be sure i>0
-    if (i==mconfig.getDbPoolSize()) {
-      i=0;
-      sleep(10);
+  bool idle;
+  id = mslots->acquire(idle);
+  MYSQL* conn = &(mpool[id].mmysql);
+  // the server may have dropped a connection idle for too long
+  if (idle && mysql_ping(conn) != 0) {
+    try {
+      resetPoolIndex(id);
+    } catch (const SystemException&) {
+      mslots->release(id);
+      throw;
     }
   }
-  throw SystemException(ERRCODE_DBCONN, "Cannot get available DB connection");
+  return conn;
 }
 
 void
@@ -265,11 +444,7 @@ MYSQLDatabase::releaseConnection(int pos) {
   if (pos==-1){
     return;
   }
-  int ret = pthread_mutex_unlock(&(mpool[pos].mmutex));
-  if (ret) {
-    throw SystemException(ERRCODE_DBCONN, "Cannot release connection lock");
-  }
-  mpool[pos].mused = false;
+  mslots->release(pos);
 }
 
 int
@@ -368,6 +543,11 @@ MYSQLDatabase::getRequest(const int key){
 std::string
 MYSQLDatabase::escapeData(const std::string& data)
 {
+  if (mlocalEscape) {
+    return SqlEscape::escapeMySQL(data, mnoBackslashEscapes);
+  }
+
+  // multibyte charset, let the library handle it
   size_t len = data.size();
   char escapedSql[2*len + 1];
 
@@ -378,3 +558,202 @@ MYSQLDatabase::escapeData(const std::string& data)
 
   return std::string(escapedSql, escapedSqlLen);
 }
+
+DbPoolMetrics
+MYSQLDatabase::getPoolMetrics() const {
+  return mslots->getMetrics();
+}
+
+void
+MYSQLDatabase::resetPoolIndex(int pos) {
+  closeStatements(pos);
+  mysql_close(&(mpool[pos].mmysql));
+  mysql_init(&(mpool[pos].mmysql));
+  connectPoolIndex(pos);
+}
+
+void
+MYSQLDatabase::closeStatements(int pos) {
+  std::map<std::string, MYSQL_STMT*>::iterator it;
+  for (it = mpool[pos].mstatements.begin(); it != mpool[pos].mstatements.end(); ++it) {
+    mysql_stmt_close(it->second);
+  }
+  mpool[pos].mstatements.clear();
+}
+
+MYSQL_STMT*
+MYSQLDatabase::getStatementHandle(int pos, const std::string& name) {
+  std::map<std::string, MYSQL_STMT*>::iterator it = mpool[pos].mstatements.find(name);
+  if (it != mpool[pos].mstatements.end()) {
+    return it->second;
+  }
+
+  MYSQL* conn = &(mpool[pos].mmysql);
+  MYSQL_STMT* stmt = mysql_stmt_init(conn);
+  if (stmt == NULL) {
+    throw SystemException(ERRCODE_DBERR, "Cannot allocate a statement" + dbErrorMsg(conn));
+  }
+  std::string query = getStatement(name);
+  if (mysql_stmt_prepare(stmt, query.c_str(), query.length())) {
+    std::string errorMsg = stmtErrorMsg(stmt);
+    mysql_stmt_close(stmt);
+    throw SystemException(ERRCODE_DBERR, "Cannot prepare " + name + errorMsg);
+  }
+  // lets getPreparedResult size its buffers
+  my_bool updateMaxLength = 1;
+  mysql_stmt_attr_set(stmt, STMT_ATTR_UPDATE_MAX_LENGTH, &updateMaxLength);
+  mpool[pos].mstatements[name] = stmt;
+  return stmt;
+}
+
+MYSQL_STMT*
+MYSQLDatabase::execPrepared(int pos, const std::string& name, const DbParams& params, bool retry) {
+  std::vector<MYSQL_BIND> binds(params.size());
+  std::vector<long long> integers(params.size());
+  std::vector<unsigned long> lengths(params.size());
+  if (!binds.empty()) {
+    memset(&binds[0], 0, binds.size() * sizeof(MYSQL_BIND));
+  }
+  for (size_t i = 0; i < params.size(); ++i) {
+    switch (params.getType(i)) {
+    case DbParams::INTEGER:
+      integers[i] = boost::lexical_cast<long long>(params.getValue(i));
+      binds[i].buffer_type = MYSQL_TYPE_LONGLONG;
+      binds[i].buffer = &integers[i];
+      break;
+    case DbParams::NULLVALUE:
+      binds[i].buffer_type = MYSQL_TYPE_NULL;
+      break;
+    case DbParams::TEXT:
+    default:
+      lengths[i] = params.getValue(i).length();
+      binds[i].buffer_type = MYSQL_TYPE_STRING;
+      binds[i].buffer = const_cast<char*>(params.getValue(i).data());
+      binds[i].buffer_length = lengths[i];
+      binds[i].length = &lengths[i];
+      break;
+    }
+  }
+
+  while (true) {
+    MYSQL_STMT* stmt = getStatementHandle(pos, name);
+    if (mysql_stmt_param_count(stmt) != params.size()) {
+      throw SystemException(ERRCODE_DBERR, "Wrong number of parameters for " + name);
+    }
+    if ((binds.empty() || !mysql_stmt_bind_param(stmt, &binds[0]))
+        && !mysql_stmt_execute(stmt)) {
+      return stmt;
+    }
+    int err = mysql_stmt_errno(stmt);
+    if (!retry || ((err != CR_SERVER_LOST) && (err != CR_SERVER_GONE_ERROR))) {
+      throw SystemException(ERRCODE_DBERR, "S-Query error" + stmtErrorMsg(stmt));
+    }
+    resetPoolIndex(pos);  // try to reinitialise the socket
+    retry = false;
+  }
+}
+
+int
+MYSQLDatabase::processPrepared(const std::string& name, const DbParams& params, int transacId) {
+  int reqPos = -1;
+  int pos = transacId;
+  if (transacId == -1) {
+    getConnection(reqPos);
+    pos = reqPos;
+  }
+
+  try {
+    MYSQL_STMT* stmt = execPrepared(pos, name, params, transacId == -1);
+    mysql_stmt_free_result(stmt);
+  } catch (const SystemException&) {
+    releaseConnection(reqPos);
+    throw;
+  }
+  releaseConnection(reqPos);
+  return SUCCESS;
+}
+
+DatabaseResult*
+MYSQLDatabase::getPreparedResult(const std::string& name, const DbParams& params, int transacId) {
+  int reqPos = -1;
+  int pos = transacId;
+  if (transacId == -1) {
+    getConnection(reqPos);
+    pos = reqPos;
+  }
+
+  vector<vector<string> > results;
+  vector<string> attributesNames;
+  MYSQL_RES* meta = NULL;
+  MYSQL_STMT* stmt = NULL;
+  try {
+    stmt = execPrepared(pos, name, params, transacId == -1);
+    meta = mysql_stmt_result_metadata(stmt);
+    if (meta == NULL) {
+      throw SystemException(ERRCODE_DBERR, "The statement " + name + " does not return rows");
+    }
+    // buffered so that the longest value of each column is known
+    if (mysql_stmt_store_result(stmt)) {
+      throw SystemException(ERRCODE_DBERR, "Cannot get query results" + stmtErrorMsg(stmt));
+    }
+
+    unsigned int size = mysql_num_fields(meta);
+    MYSQL_FIELD* fields = mysql_fetch_fields(meta);
+    vector<vector<char> > buffers(size);
+    vector<unsigned long> lengths(size);
+    vector<my_bool> nulls(size);
+    vector<MYSQL_BIND> binds(size);
+    if (size > 0) {
+      memset(&binds[0], 0, size * sizeof(MYSQL_BIND));
+    }
+    for (unsigned int i = 0; i < size; i++) {
+      attributesNames.push_back(string(fields[i].name));
+      buffers[i].resize(fields[i].max_length + 1);
+      binds[i].buffer_type = MYSQL_TYPE_STRING;
+      binds[i].buffer = &buffers[i][0];
+      binds[i].buffer_length = buffers[i].size();
+      binds[i].length = &lengths[i];
+      binds[i].is_null = &nulls[i];
+    }
+    if (size > 0 && mysql_stmt_bind_result(stmt, &binds[0])) {
+      throw SystemException(ERRCODE_DBERR, "Cannot get query results" + stmtErrorMsg(stmt));
+    }
+
+    int res;
+    while ((res = mysql_stmt_fetch(stmt)) == 0 || res == MYSQL_DATA_TRUNCATED) {
+      results.push_back(vector<string>());
+      vector<string>& rowStr = results.back();
+      rowStr.reserve(size);
+      for (unsigned int i = 0; i < size; i++) {
+        if (nulls[i]) {
+          rowStr.push_back("");
+        } else if (lengths[i] < buffers[i].size()) {
+          rowStr.push_back(string(&buffers[i][0], lengths[i]));
+        } else {
+          // max_length is not reliable for every type, fetch it again
+          vector<char> value(lengths[i]);
+          MYSQL_BIND bind = binds[i];
+          bind.buffer = &value[0];
+          bind.buffer_length = value.size();
+          mysql_stmt_fetch_column(stmt, &bind, i, 0);
+          rowStr.push_back(string(&value[0], value.size()));
+        }
+      }
+    }
+    mysql_stmt_free_result(stmt);
+    mysql_free_result(meta);
+    meta = NULL;
+    if (res != MYSQL_NO_DATA) {
+      throw SystemException(ERRCODE_DBERR, "Cannot get query results" + stmtErrorMsg(stmt));
+    }
+  } catch (const SystemException&) {
+    if (meta != NULL) {
+      mysql_stmt_free_result(stmt);
+      mysql_free_result(meta);
+    }
+    releaseConnection(reqPos);
+    throw;
+  }
+  releaseConnection(reqPos);
+  return new DatabaseResult(results, attributesNames);
+}
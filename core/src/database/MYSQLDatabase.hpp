@@ -8,12 +8,15 @@
 #ifndef _MYSDLDATABASE_H_
 #define _MYSQLDATABASE_H_
 
+#include <map>
 #include <string>
-#include <pthread.h>
+#include <vector>
+#include <boost/scoped_ptr.hpp>
 
 #include "Database.hpp"
 #include "DatabaseResult.hpp"
 #include "DbConfiguration.hpp"
+#include "DbConnectionPool.hpp"
 #include "MYSQLRequestFactory.hpp"
 
 #include "mysql.h"
@@ -32,6 +35,16 @@ public :
    */
   int
   process(std::string request, int transacId = -1);
+  /**
+   * \brief Run several requests which do not return rows in a single
+   * multi-statement query; those before a failing one are kept unless a
+   * transaction is used
+   * \param requests The requests, each a SINGLE SQL statement without a semicolon
+   * \param transacId the id of the transaction if one is used
+   * \return raises an exception on the first failing request
+   */
+  int
+  processBatch(const std::vector<std::string>& requests, int transacId = -1);
   /**
   * \brief To make a create a pool of MySQL connections
   * \return raises an exception on error
@@ -65,6 +78,14 @@ public :
   */
   DatabaseResult*
   getResult(std::string request, int transacId = -1);
+  /**
+  * \brief To stream the rows of a select request instead of loading them
+  * \param request The request to process
+  * \param transacId the id of the transaction if one is used
+  * \return A cursor on the rows, holding a connection until it is destroyed
+  */
+  DatabaseCursor*
+  getCursor(std::string request, int transacId = -1);
 
   /**
    * \brief To get the type of database
@@ -127,9 +148,37 @@ public :
   virtual std::string
   escapeData(const std::string& data);
 
+  /**
+   * \brief Get the statistics of the connection pool
+   * \return the statistics
+   */
+  DbPoolMetrics
+  getPoolMetrics() const;
+
+  /**
+   * \brief Run a prepared statement which does not return rows
+   * \param name The name of the statement
+   * \param params The parameters of the statement
+   * \param transacId the id of the transaction if one is used
+   * \return raises an exception on error
+   */
+  virtual int
+  processPrepared(const std::string& name, const DbParams& params, int transacId = -1);
+
+  /**
+   * \brief Run a prepared statement returning rows
+   * \param name The name of the statement
+   * \param params The parameters of the statement
+   * \param transacId the id of the transaction if one is used
+   * \return An object which encapsulates the database results
+   */
+  virtual DatabaseResult*
+  getPreparedResult(const std::string& name, const DbParams& params, int transacId = -1);
+
 private :
   /**
-   * \brief To get a valid connexion
+   * \brief To get a valid connexion, blocks until one is free or the
+   * timeout of the pool expires
    * \param pos The position of the connection gotten in the pool
    * \return A valid and free connection
    */
@@ -141,22 +190,50 @@ private :
    */
   void releaseConnection(int pos);
 
+  /**
+   * \brief Close and reopen a connection of the pool, dropping its
+   * prepared statements
+   * \param pos The position of the connection in the pool
+   */
+  void resetPoolIndex(int pos);
+
+  /**
+   * \brief Close the prepared statements of a connection
+   * \param pos The position of the connection in the pool
+   */
+  void closeStatements(int pos);
+
+  /**
+   * \brief Get the handle of a statement on a connection, preparing it
+   * if the connection does not know it yet
+   * \param pos The position of the connection in the pool
+   * \param name The name of the statement
+   * \return the handle
+   */
+  MYSQL_STMT* getStatementHandle(int pos, const std::string& name);
+
+  /**
+   * \brief Bind the parameters of a prepared statement and run it
+   * \param pos The position of the connection in the pool
+   * \param name The name of the statement
+   * \param params The parameters of the statement
+   * \param retry Whether to reconnect and retry once if the server is gone
+   * \return the handle of the statement
+   */
+  MYSQL_STMT* execPrepared(int pos, const std::string& name, const DbParams& params, bool retry);
+
   /**
    * \brief An element of the pool
    */
   typedef struct pool_t{
-    /**
-     * \brief If the connexion is used
-     */
-    bool mused;
     /**
      * \brief The connection mysql structure
      */
     MYSQL mmysql;
     /**
-     * \brief The associated mutex
+     * \brief The statements prepared on the connection indexed by name
      */
-    pthread_mutex_t mmutex;
+    std::map<std::string, MYSQL_STMT*> mstatements;
   }pool_t;
   /////////////////////////////////
   // Attributes
@@ -169,6 +246,10 @@ private :
    * \brief The pool of connection
    */
   pool_t *mpool;
+  /**
+   * \brief The slots of the pool available for checkout
+   */
+  boost::scoped_ptr<DbConnectionPool> mslots;
 
   /////////////////////////////////
   // Functions
@@ -184,6 +265,17 @@ private :
    * \brief Request factory
    */
   MYSQLRequestFactory mmysqlfact;
+
+  /**
+   * \brief Whether escapeData can do without a connection, depends on
+   * the charset of the connections
+   */
+  bool mlocalEscape;
+
+  /**
+   * \brief Whether the server runs with the NO_BACKSLASH_ESCAPES sql mode
+   */
+  bool mnoBackslashEscapes;
 };
 
 
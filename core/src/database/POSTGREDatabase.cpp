@@ -6,16 +6,231 @@
  */
 #include "POSTGREDatabase.hpp"
 
+#include <cerrno>
 #include <sstream>
 #include <vector>
+#include <poll.h>
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
 #include <boost/scoped_ptr.hpp>
 
+#include "SqlEscape.hpp"
 #include "SystemException.hpp"
 #include "utilVishnu.hpp"
 #include <boost/format.hpp>
 
 using namespace std;
 
+// anonymous namespace
+namespace {
+  /**
+   * \brief Replace the '?' placeholders of a request by the $n of libpq
+   * \param query the request
+   * \return the request for libpq
+   */
+  std::string
+  toPgPlaceholders(const std::string& query) {
+    std::string res;
+    bool quoted(false);
+    int count(0);
+    for (std::string::const_iterator it = query.begin(); it != query.end(); ++it) {
+      if (*it == '\'') {
+        quoted = !quoted;
+      }
+      if (*it == '?' && !quoted) {
+        res += "$" + vishnu::convertToString(++count);
+      } else {
+        res += *it;
+      }
+    }
+    return res;
+  }
+
+  /**
+   * \brief Copy the rows of a result
+   * \param res the result
+   * \return An object which encapsulates the database results
+   */
+  DatabaseResult*
+  toDatabaseResult(PGresult* res) {
+    std::vector<std::vector<std::string> > results;
+    std::vector<std::string> attributesNames;
+    int nFields = PQnfields(res);
+    for (int i = 0; i < nFields; i++) {
+      attributesNames.push_back(std::string(PQfname(res, i)));
+    }
+
+    int nTuples = PQntuples(res);
+    results.reserve(nTuples);
+    for (int i = 0; i < nTuples; i++) {
+      results.push_back(std::vector<std::string>());
+      std::vector<std::string>& tmp = results.back();
+      tmp.reserve(nFields);
+      for (int j = 0; j < nFields; j++) {
+        tmp.push_back(std::string(PQgetvalue(res, i, j), PQgetlength(res, i, j)));
+      }
+    }
+    return new DatabaseResult(results, attributesNames);
+  }
+
+  /**
+   * \brief Read all the results left on a connection
+   * \param conn the connection
+   */
+  void
+  drainResults(PGconn* conn) {
+    PGresult* res;
+    while ((res = PQgetResult(conn)) != NULL) {
+      PQclear(res);
+    }
+  }
+
+#ifdef LIBPQ_HAS_PIPELINING
+  /**
+   * \brief Send the output buffer of a connection in non-blocking mode,
+   * reading the incoming results meanwhile so that the server never waits
+   * for us to empty the socket while we wait for it
+   * \param conn the connection
+   * \return false on error
+   */
+  bool
+  flushNonBlocking(PGconn* conn) {
+    int rc;
+    while ((rc = PQflush(conn)) == 1) {
+      struct pollfd fd;
+      fd.fd = PQsocket(conn);
+      fd.events = POLLIN | POLLOUT;
+      fd.revents = 0;
+      if (poll(&fd, 1, -1) < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return false;
+      }
+      if ((fd.revents & POLLIN) && !PQconsumeInput(conn)) {
+        return false;
+      }
+    }
+    return rc == 0;
+  }
+#endif
+
+  /**
+   * \class PGCursor
+   * \brief Cursor reading the rows in the single row mode of libpq
+   */
+  class PGCursor : public DatabaseCursor {
+  public:
+    /**
+     * \brief Constructor
+     * \param conn the connection the request was sent on
+     * \param release gives back the connection, empty in a transaction
+     */
+    PGCursor(PGconn* conn, boost::function<void()> release)
+      : mconn(conn), mres(NULL), mrelease(release), mdone(false) {}
+
+    ~PGCursor() {
+      if (!mdone) {
+        // a cancel would abort the transaction, and costs more than
+        // draining the rows already received
+        if (mrelease && isStreaming()) {
+          PGcancel* cancel = PQgetCancel(mconn);
+          if (cancel != NULL) {
+            char errbuf[256];
+            PQcancel(cancel, errbuf, sizeof(errbuf));
+            PQfreeCancel(cancel);
+          }
+        }
+        finish();
+      }
+      PQclear(mres);
+    }
+
+    bool
+    next() {
+      if (mdone) {
+        return false;
+      }
+      PQclear(mres);
+      mres = PQgetResult(mconn);
+      switch (PQresultStatus(mres)) {
+      case PGRES_SINGLE_TUPLE:
+        return true;
+      case PGRES_TUPLES_OK:
+        // the empty result closing the rows, still describes the fields
+        finish();
+        return false;
+      default: {
+        std::string errorMsg = std::string(PQerrorMessage(mconn));
+        finish();
+        throw SystemException(ERRCODE_DBERR, errorMsg);
+      }
+      }
+    }
+
+    size_t
+    getNbFields() const {
+      return (mres != NULL) ? PQnfields(mres) : 0;
+    }
+
+    std::string
+    getFieldName(size_t col) const {
+      return std::string(PQfname(mres, static_cast<int>(col)));
+    }
+
+    bool
+    isNull(size_t col) const {
+      return PQgetisnull(mres, 0, static_cast<int>(col)) != 0;
+    }
+
+    DbStringRef
+    getRef(size_t col) const {
+      DbStringRef ref = {PQgetvalue(mres, 0, static_cast<int>(col)),
+                         static_cast<size_t>(PQgetlength(mres, 0, static_cast<int>(col)))};
+      return ref;
+    }
+
+  private:
+    /**
+     * \brief Tell whether rows are still to come from the server
+     * \return true if reading the end of the result would block
+     */
+    bool
+    isStreaming() {
+      return PQconsumeInput(mconn) != 0 && PQisBusy(mconn) != 0;
+    }
+
+    /**
+     * \brief Read what is left and give back the connection
+     */
+    void
+    finish() {
+      drainResults(mconn);
+      mdone = true;
+      if (mrelease) {
+        mrelease();
+      }
+    }
+
+    /**
+     * \brief The connection
+     */
+    PGconn* mconn;
+    /**
+     * \brief The current row
+     */
+    PGresult* mres;
+    /**
+     * \brief Gives back the connection
+     */
+    boost::function<void()> mrelease;
+    /**
+     * \brief Whether all the rows were read
+     */
+    bool mdone;
+  };
+}
+
 /**
  * \brief Function to process the request in the database
  * \param request The request to process
@@ -24,7 +239,13 @@ using namespace std;
 int
 POSTGREDatabase::process(std::string request, int transacId){
   int reqPos;
-  PGconn* lconn = getConnection(reqPos);
+  PGconn* lconn = NULL;
+  if (transacId == -1) {
+    lconn = getConnection(reqPos);
+  } else {
+    reqPos = -1;
+    lconn = mpool[transacId].mconn;
+  }
 
   if (PQstatus(lconn) == CONNECTION_OK) {
     PGresult* res = PQexec(lconn, request.c_str());
@@ -46,6 +267,101 @@ POSTGREDatabase::process(std::string request, int transacId){
 }
 
 
+int
+POSTGREDatabase::processBatch(const std::vector<std::string>& requests, int transacId) {
+  if (requests.empty()) {
+    return SUCCESS;
+  }
+  int reqPos = -1;
+  int pos = transacId;
+  if (transacId == -1) {
+    getConnection(reqPos);
+    pos = reqPos;
+  }
+  PGconn* lconn = mpool[pos].mconn;
+  if (PQstatus(lconn) != CONNECTION_OK) {
+    releaseConnection(reqPos);
+    throw SystemException(ERRCODE_DBCONN, std::string(PQerrorMessage(lconn)));
+  }
+
+  std::string errorMsg;
+#ifdef LIBPQ_HAS_PIPELINING
+  errorMsg = execPipeline(pos, requests);
+#else
+  // without pipelining, a multi-statement query also costs one round trip
+  std::string request;
+  for (std::vector<std::string>::const_iterator it = requests.begin(); it != requests.end(); ++it) {
+    request += *it + ";";
+  }
+  PGresult* res = PQexec(lconn, request.c_str());
+  if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+    errorMsg = std::string(PQerrorMessage(lconn));
+  }
+  PQclear(res);
+#endif
+  releaseConnection(reqPos);
+  if (!errorMsg.empty()) {
+    throw SystemException(ERRCODE_DBERR, errorMsg);
+  }
+  return SUCCESS;
+}
+
+#ifdef LIBPQ_HAS_PIPELINING
+std::string
+POSTGREDatabase::execPipeline(int pos, const std::vector<std::string>& requests) {
+  PGconn* conn = mpool[pos].mconn;
+  if (!PQenterPipelineMode(conn)) {
+    return std::string(PQerrorMessage(conn));
+  }
+
+  // everything is queued before any result is read, the single sync
+  // closing the implicit transaction of the batch
+  PQsetnonblocking(conn, 1);
+  bool sent = true;
+  for (std::vector<std::string>::const_iterator it = requests.begin();
+       sent && it != requests.end(); ++it) {
+    sent = PQsendQueryParams(conn, it->c_str(), 0, NULL, NULL, NULL, NULL, 0);
+  }
+  sent = sent && PQpipelineSync(conn) && flushNonBlocking(conn);
+  PQsetnonblocking(conn, 0);
+
+  std::string errorMsg;
+  bool closed = false;
+  if (!sent) {
+    errorMsg = std::string(PQerrorMessage(conn));
+  } else {
+    for (size_t i = 0; i < requests.size(); ++i) {
+      PGresult* res = PQgetResult(conn);
+      if (res == NULL) {
+        break;
+      }
+      ExecStatusType status = PQresultStatus(res);
+      // the requests following a failure are reported as aborted
+      if (status != PGRES_COMMAND_OK && status != PGRES_TUPLES_OK && errorMsg.empty()) {
+        errorMsg = std::string(PQresultErrorMessage(res));
+      }
+      PQclear(res);
+      // the NULL ending the results of the request
+      drainResults(conn);
+    }
+    PGresult* res = PQgetResult(conn);
+    closed = (PQresultStatus(res) == PGRES_PIPELINE_SYNC) && PQexitPipelineMode(conn);
+    PQclear(res);
+  }
+
+  if (!closed) {
+    if (errorMsg.empty()) {
+      errorMsg = std::string(PQerrorMessage(conn));
+    }
+    // the connexion is out of step, start a new session
+    mpool[pos].mprepared.clear();
+    PQreset(conn);
+  }
+  return errorMsg;
+}
+#endif
+
+
 /**
  * \brief To make a connection to the database
  * \return raises an exception on error
@@ -90,6 +406,13 @@ POSTGREDatabase::connect() {
       throw SystemException(ERRCODE_DBCONN, "The database is already connected");
     }
   }
+  // all the connections share the same settings
+  if (mconfig.getDbPoolSize() > 0) {
+    PGconn* conn = mpool[0].mconn;
+    const char* standardStrings = PQparameterStatus(conn, "standard_conforming_strings");
+    mstandardStrings = (standardStrings != NULL) && (std::string(standardStrings) == "on");
+    mlocalEscape = SqlEscape::isSafeCharset(pg_encoding_to_char(PQclientEncoding(conn)));
+  }
   return SUCCESS;
 }
 
@@ -97,14 +420,16 @@ POSTGREDatabase::connect() {
  * \brief Constructor
  */
 POSTGREDatabase::POSTGREDatabase(DbConfiguration dbConfig)
-  : Database(), mconfig(dbConfig), misConnected(false) {
+  : Database(), mconfig(dbConfig), misConnected(false),
+    mlocalEscape(false), mstandardStrings(false) {
   int i;
   mpool = new pool_t[mconfig.getDbPoolSize()];
   for (i=0;i<mconfig.getDbPoolSize();i++){
-    pthread_mutex_init(&(mpool[i].mmutex), NULL);
-    mpool[i].mused = false;
     mpool[i].mconn = NULL;
   }
+  mslots.reset(new DbConnectionPool(mconfig.getDbPoolSize(),
+                                    mconfig.getDbPoolTimeout(),
+                                    DB_IDLE_CHECK_INTERVAL));
 }
 
 /**
@@ -127,7 +452,6 @@ POSTGREDatabase::disconnect(){
     if (mpool[i].mconn != NULL) {
       PQfinish(mpool[i].mconn);
     }
-    pthread_mutex_destroy(&(mpool[i].mmutex));
   }
   return SUCCESS;
 }
@@ -140,80 +464,90 @@ POSTGREDatabase::disconnect(){
  */
 DatabaseResult*
 POSTGREDatabase::getResult(std::string request, int transacId) {
-  std::vector<std::vector<std::string> > results;
-  std::vector<std::string> attributesNames;
-  std::vector<std::string> tmp;
+  DatabaseResult* result = NULL;
   int reqPos;
-  PGconn* lconn = getConnection(reqPos);
+  PGconn* lconn = NULL;
+  if (transacId == -1) {
+    lconn = getConnection(reqPos);
+  } else {
+    reqPos = -1;
+    lconn = mpool[transacId].mconn;
+  }
 
   if (PQstatus(lconn) == CONNECTION_OK) {
     PGresult* res = PQexec(lconn, request.c_str());
-    int i;
-    int j;
 
     if (PQresultStatus(res) != PGRES_TUPLES_OK) {
       PQclear(res);
       releaseConnection(reqPos);
       throw SystemException(ERRCODE_DBERR, std::string(PQerrorMessage(lconn)));
     }
-    int nFields = PQnfields(res);
-    for (i = 0; i < nFields; i++) {
-      attributesNames.push_back(std::string(PQfname(res, i)));
-    }
-
-    for (i = 0; i < PQntuples(res); i++) {
-      tmp.clear();
-      for (j = 0; j < nFields; j++) {
-        tmp.push_back(std::string(PQgetvalue(res, i, j)));
-      }
-      results.push_back(tmp);
-    }
+    result = toDatabaseResult(res);
     releaseConnection(reqPos);
     PQclear(res);
   } else {
     releaseConnection(reqPos);
     throw SystemException(ERRCODE_DBCONN, "The database is not connected");
   }
-  return new DatabaseResult(results, attributesNames);
+  return result;
+}
+
+DatabaseCursor*
+POSTGREDatabase::getCursor(std::string request, int transacId) {
+  int reqPos;
+  PGconn* lconn = NULL;
+  if (transacId == -1) {
+    lconn = getConnection(reqPos);
+  } else {
+    reqPos = -1;
+    lconn = mpool[transacId].mconn;
+  }
+
+  if (!PQsendQuery(lconn, request.c_str()) || !PQsetSingleRowMode(lconn)) {
+    std::string errorMsg = std::string(PQerrorMessage(lconn));
+    drainResults(lconn);
+    releaseConnection(reqPos);
+    throw SystemException(ERRCODE_DBERR, errorMsg);
+  }
+
+  boost::function<void()> release;
+  if (reqPos != -1) {
+    release = boost::bind(&POSTGREDatabase::releaseConnection, this, reqPos);
+  }
+  return new PGCursor(lconn, release);
 }
 
 PGconn* POSTGREDatabase::getConnection(int& id){
-  int i = 0;
-  int locked;
-  // Looking for an unused connection
-  while (true) {
-    // If the connection is not used
-    if(!mpool[i].mused) {
-      locked = pthread_mutex_trylock(&(mpool[i].mmutex));
-      // If lock fails-> the mutex was taken before trylock call
-      if (locked) {
-        // Try next connexion
-        sleep(2);
-        continue;
-      }
-      else {
-        mpool[i].mused=true;
-        id = i;
-        return mpool[i].mconn;
-      }
-    }
-    i++;
-    // I do not use modulo '%' because i need to be sure i>0
-    if (i==mconfig.getDbPoolSize()) {
-      i=0;
-      sleep(10);
+  bool idle;
+  id = mslots->acquire(idle);
+  PGconn* conn = mpool[id].mconn;
+
+  // PQstatus only knows about failures already seen, so a connection idle
+  // for long is checked with an empty query (a single round-trip)
+  bool alive = (PQstatus(conn) == CONNECTION_OK);
+  if (alive && idle) {
+    PGresult* res = PQexec(conn, "");
+    alive = (PQresultStatus(res) == PGRES_EMPTY_QUERY);
+    PQclear(res);
+  }
+  if (!alive) {
+    // the statements prepared on the former session are gone
+    mpool[id].mprepared.clear();
+    PQreset(conn);
+    if (PQstatus(conn) != CONNECTION_OK) {
+      std::string errorMsg = std::string(PQerrorMessage(conn));
+      mslots->release(id);
+      throw SystemException(ERRCODE_DBCONN, errorMsg);
     }
   }
-  throw SystemException(ERRCODE_DBCONN, "Unknown error, cannot get connexion on database");
+  return conn;
 }
 
 void POSTGREDatabase::releaseConnection(int pos){
-  int ret;
-  ret = pthread_mutex_unlock(&(mpool[pos].mmutex));
-  if (ret) {
-    throw SystemException(ERRCODE_DBCONN, "Fail to release a mutex");
+  if (pos == -1) {
+    return;
   }
-  mpool[pos].mused = false;
+  mslots->release(pos);
 }
 
 int
@@ -276,6 +610,11 @@ POSTGREDatabase::getRequest(const int key){
 std::string
 POSTGREDatabase::escapeData(const std::string& data)
 {
+  if (mlocalEscape) {
+    return SqlEscape::escapePostgreSQL(data, mstandardStrings);
+  }
+
+  // multibyte encoding, let libpq handle it
   size_t len = data.size();
   char escapedSql[2*len + 1];
 
@@ -286,3 +625,91 @@ POSTGREDatabase::escapeData(const std::string& data)
 
   return std::string(escapedSql, escapedSqlLen);
 }
+
+DbPoolMetrics
+POSTGREDatabase::getPoolMetrics() const {
+  return mslots->getMetrics();
+}
+
+PGresult*
+POSTGREDatabase::execPrepared(int pos, const std::string& name, const DbParams& params) {
+  PGconn* conn = mpool[pos].mconn;
+  if (PQstatus(conn) != CONNECTION_OK) {
+    throw SystemException(ERRCODE_DBCONN, "The database is not connected");
+  }
+
+  if (mpool[pos].mprepared.find(name) == mpool[pos].mprepared.end()) {
+    // the server infers the types of the parameters
+    PGresult* res = PQprepare(conn, name.c_str(),
+                              toPgPlaceholders(getStatement(name)).c_str(),
+                              0, NULL);
+    bool prepared = (PQresultStatus(res) == PGRES_COMMAND_OK);
+    PQclear(res);
+    if (!prepared) {
+      throw SystemException(ERRCODE_DBERR, std::string(PQerrorMessage(conn)));
+    }
+    mpool[pos].mprepared.insert(name);
+  }
+
+  std::vector<const char*> values(params.size());
+  for (size_t i = 0; i < params.size(); ++i) {
+    values[i] = (params.getType(i) == DbParams::NULLVALUE) ? NULL : params.getValue(i).c_str();
+  }
+  return PQexecPrepared(conn, name.c_str(), static_cast<int>(params.size()),
+                        values.empty() ? NULL : &values[0], NULL, NULL, 0);
+}
+
+int
+POSTGREDatabase::processPrepared(const std::string& name, const DbParams& params, int transacId) {
+  int reqPos = -1;
+  int pos = transacId;
+  if (transacId == -1) {
+    getConnection(reqPos);
+    pos = reqPos;
+  }
+
+  PGresult* res = NULL;
+  try {
+    res = execPrepared(pos, name, params);
+  } catch (const SystemException&) {
+    releaseConnection(reqPos);
+    throw;
+  }
+  if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+    std::string errorMsg = std::string(PQerrorMessage(mpool[pos].mconn));
+    PQclear(res);
+    releaseConnection(reqPos);
+    throw SystemException(ERRCODE_DBERR, errorMsg);
+  }
+  PQclear(res);
+  releaseConnection(reqPos);
+  return SUCCESS;
+}
+
+DatabaseResult*
+POSTGREDatabase::getPreparedResult(const std::string& name, const DbParams& params, int transacId) {
+  int reqPos = -1;
+  int pos = transacId;
+  if (transacId == -1) {
+    getConnection(reqPos);
+    pos = reqPos;
+  }
+
+  PGresult* res = NULL;
+  try {
+    res = execPrepared(pos, name, params);
+  } catch (const SystemException&) {
+    releaseConnection(reqPos);
+    throw;
+  }
+  if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+    std::string errorMsg = std::string(PQerrorMessage(mpool[pos].mconn));
+    PQclear(res);
+    releaseConnection(reqPos);
+    throw SystemException(ERRCODE_DBERR, errorMsg);
+  }
+  DatabaseResult* result = toDatabaseResult(res);
+  PQclear(res);
+  releaseConnection(reqPos);
+  return result;
+}
@@ -8,12 +8,15 @@
 #ifndef _POSTGREDATABASE_H_
 #define _POSTGREDATABASE_H_
 
+#include <set>
 #include <string>
-#include <pthread.h>
+#include <vector>
+#include <boost/scoped_ptr.hpp>
 
 #include "Database.hpp"
 #include "DatabaseResult.hpp"
 #include "DbConfiguration.hpp"
+#include "DbConnectionPool.hpp"
 #include "PGSQLRequestFactory.hpp"
 
 #include "libpq-fe.h"
@@ -33,6 +36,17 @@ public :
   int
   process(std::string request, int transacId = -1);
 
+  /**
+   * \brief Run several requests which do not return rows. With a libpq
+   * supporting it, they are sent in pipeline mode and cost a single round
+   * trip; outside of a transaction, they then succeed or fail together.
+   * \param requests The requests, each a SINGLE SQL statement without a semicolon
+   * \param transacId the id of the transaction if one is used
+   * \return raises an exception on the first failing request
+   */
+  int
+  processBatch(const std::vector<std::string>& requests, int transacId = -1);
+
 
   /**
   * \brief To make a connection to the database
@@ -59,6 +73,14 @@ public :
    */
   DatabaseResult*
   getResult(std::string request, int transacId = -1);
+  /**
+  * \brief To stream the rows of a select request instead of loading them
+  * \param request The request to process
+  * \param transacId the id of the transaction if one is used
+  * \return A cursor on the rows, holding a connection until it is destroyed
+  */
+  DatabaseCursor*
+  getCursor(std::string request, int transacId = -1);
 
   /**
    * \brief To get the type of database
@@ -117,28 +139,52 @@ public :
   virtual std::string
   escapeData(const std::string& data);
 
+  /**
+   * \brief Get the statistics of the connection pool
+   * \return the statistics
+   */
+  DbPoolMetrics
+  getPoolMetrics() const;
+
+  /**
+   * \brief Run a prepared statement which does not return rows
+   * \param name The name of the statement
+   * \param params The parameters of the statement
+   * \param transacId the id of the transaction if one is used
+   * \return raises an exception on error
+   */
+  virtual int
+  processPrepared(const std::string& name, const DbParams& params, int transacId = -1);
+
+  /**
+   * \brief Run a prepared statement returning rows
+   * \param name The name of the statement
+   * \param params The parameters of the statement
+   * \param transacId the id of the transaction if one is used
+   * \return An object which encapsulates the database results
+   */
+  virtual DatabaseResult*
+  getPreparedResult(const std::string& name, const DbParams& params, int transacId = -1);
+
 private :
 
   /**
    * \brief An element of the pool
    */
   typedef struct pool_t{
-    /**
-     * \brief If the connexion is used
-     */
-    bool mused;
     /**
      * \brief The connexion
      */
     PGconn* mconn;
     /**
-     * \brief The associated mutex
+     * \brief The statements already prepared on the connexion
      */
-    pthread_mutex_t mmutex;
+    std::set<std::string> mprepared;
   }pool_t;
 
   /**
-   * \brief To get a valid connexion
+   * \brief To get a valid connexion, blocks until one is free or the
+   * timeout of the pool expires
    * \param pos The position of the connexion gotten in the pool
    * \return A valid and free connexion
    */
@@ -150,6 +196,27 @@ private :
    */
   void releaseConnection(int pos);
 
+  /**
+   * \brief Run a prepared statement, preparing it first if the connexion
+   * does not know it yet
+   * \param pos The position of the connexion in the pool
+   * \param name The name of the statement
+   * \param params The parameters of the statement
+   * \return the result, to be cleared by the caller
+   */
+  PGresult* execPrepared(int pos, const std::string& name, const DbParams& params);
+
+#ifdef LIBPQ_HAS_PIPELINING
+  /**
+   * \brief Send requests in pipeline mode and read their results, resetting
+   * the connexion if the pipeline cannot be closed
+   * \param pos The position of the connexion in the pool
+   * \param requests The requests
+   * \return the error of the first failing request, empty on success
+   */
+  std::string execPipeline(int pos, const std::vector<std::string>& requests);
+#endif
+
   /////////////////////////////////
   // Attributes
   /////////////////////////////////
@@ -164,10 +231,26 @@ private :
    */
   pool_t *mpool;
 
+  /**
+   * \brief The slots of the pool available for checkout
+   */
+  boost::scoped_ptr<DbConnectionPool> mslots;
+
   /**
    * \brief If the connection is right
    */
   bool misConnected;
+
+  /**
+   * \brief Whether escapeData can do without a connection, depends on
+   * the client encoding of the connections
+   */
+  bool mlocalEscape;
+
+  /**
+   * \brief Whether standard_conforming_strings is on
+   */
+  bool mstandardStrings;
   /**
    * \brief Request factory
    */
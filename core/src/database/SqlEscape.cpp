@@ -0,0 +1,81 @@
+/**
+ * \file SqlEscape.cpp
+ * \brief This file implements the escaping of SQL literals without a
+ * database connection
+ * \author Haikel Guemar (haikel.guemar@sysfera.com)
+ */
+
+#include "SqlEscape.hpp"
+
+#include <boost/algorithm/string/predicate.hpp>
+
+std::string
+SqlEscape::escapeMySQL(const std::string& data, bool noBackslashEscapes) {
+  std::string res;
+  res.reserve(data.size() + data.size() / 8 + 1);
+  for (std::string::const_iterator it = data.begin(); it != data.end(); ++it) {
+    if (noBackslashEscapes) {
+      if (*it == '\'') {
+        res += '\'';
+      }
+      res += *it;
+      continue;
+    }
+    switch (*it) {
+    case '\0':
+      res += "\\0";
+      break;
+    case '\n':
+      res += "\\n";
+      break;
+    case '\r':
+      res += "\\r";
+      break;
+    case '\032':
+      res += "\\Z";
+      break;
+    case '\\':
+    case '\'':
+    case '"':
+      res += '\\';
+      res += *it;
+      break;
+    default:
+      res += *it;
+      break;
+    }
+  }
+  return res;
+}
+
+std::string
+SqlEscape::escapePostgreSQL(const std::string& data, bool standardStrings) {
+  std::string res;
+  res.reserve(data.size() + data.size() / 8 + 1);
+  for (std::string::const_iterator it = data.begin(); it != data.end(); ++it) {
+    // like libpq, stop at the first NUL
+    if (*it == '\0') {
+      break;
+    }
+    if (*it == '\'' || (*it == '\\' && !standardStrings)) {
+      res += *it;
+    }
+    res += *it;
+  }
+  return res;
+}
+
+bool
+SqlEscape::isSafeCharset(const std::string& charset) {
+  using boost::algorithm::istarts_with;
+  using boost::algorithm::iequals;
+
+  return istarts_with(charset, "utf8")
+    || istarts_with(charset, "latin")
+    || istarts_with(charset, "iso_8859")
+    || istarts_with(charset, "cp125")
+    || istarts_with(charset, "win125")
+    || iequals(charset, "ascii")
+    || iequals(charset, "sql_ascii")
+    || iequals(charset, "binary");
+}
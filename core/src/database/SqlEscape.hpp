@@ -0,0 +1,54 @@
+/**
+ * \file SqlEscape.hpp
+ * \brief This file presents the escaping of SQL literals without a
+ * database connection
+ * \author Haikel Guemar (haikel.guemar@sysfera.com)
+ */
+
+#ifndef _SQLESCAPE_HPP_
+#define _SQLESCAPE_HPP_
+
+#include <string>
+
+/**
+ * \class SqlEscape
+ * \brief Escapes the data put between single quotes in a request the way
+ * the client libraries do, without borrowing a connection.
+ *
+ * Only valid for character sets where none of the escaped characters can
+ * be the trailing byte of a multibyte character (UTF-8, single byte
+ * character sets); the backends check the charset of their connections
+ * with isSafeCharset and keep the libraries' functions otherwise.
+ */
+class SqlEscape {
+public:
+  /**
+   * \brief Escape a string for MySQL, as mysql_real_escape_string does
+   * \param data the string to escape
+   * \param noBackslashEscapes true if the server runs with the
+   * NO_BACKSLASH_ESCAPES sql mode
+   * \return the escaped string
+   */
+  static std::string
+  escapeMySQL(const std::string& data, bool noBackslashEscapes);
+
+  /**
+   * \brief Escape a string for PostgreSQL, as PQescapeStringConn does
+   * \param data the string to escape
+   * \param standardStrings true if standard_conforming_strings is on
+   * \return the escaped string
+   */
+  static std::string
+  escapePostgreSQL(const std::string& data, bool standardStrings);
+
+  /**
+   * \brief Check whether a charset can be escaped locally
+   * \param charset the name of the charset as reported by the client
+   * library (e.g. utf8mb4, latin1, UTF8, SQL_ASCII)
+   * \return true if the local escaping is safe
+   */
+  static bool
+  isSafeCharset(const std::string& charset);
+};
+
+#endif // _SQLESCAPE_HPP_
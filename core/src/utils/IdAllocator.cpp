@@ -0,0 +1,235 @@
+/**
+ * \file IdAllocator.cpp
+ * \brief This file implements the allocator of the VISHNU object ids
+ * \author Haikel Guemar (haikel.guemar@sysfera.com)
+ */
+
+#include "IdAllocator.hpp"
+
+#include <ctime>
+#include <boost/algorithm/string/replace.hpp>
+#include <boost/format.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/locks.hpp>
+#include "DatabaseResult.hpp"
+#include "DbFactory.hpp"
+#include "SystemException.hpp"
+#include "utilVishnu.hpp"
+
+// anonymous namespace
+namespace {
+  /**
+   * \struct IdTable
+   * \brief Where the objects of a type are stored
+   */
+  struct IdTable {
+    /**
+     * \brief The table, also the name of the counter
+     */
+    const char* table;
+    /**
+     * \brief The serial primary key
+     */
+    const char* key;
+    /**
+     * \brief The column of the generated id
+     */
+    const char* idColumn;
+    /**
+     * \brief The columns filled when reserving the row
+     */
+    const char* fields;
+    /**
+     * \brief Their values, %1% standing for the vishnu id
+     */
+    const char* values;
+  };
+
+  /**
+   * \brief The tables, indexed by vishnu::IdType
+   */
+  const IdTable ID_TABLES[] = {
+    {"machine", "nummachineid", "machineid", "vishnu_vishnuid", "%1%"},
+    {"users", "numuserid", "userid", "vishnu_vishnuid, pwd", "%1%, ''"},
+    {"job", "numjobid", "jobid",
+     "job_owner_id, machine_id, workId, vsession_numsessionid",
+     //FIXME insert invalid value then update it
+     "(select max(numuserid) from users), (select max(nummachineid) from machine),"
+     " NULL, (select max(numsessionid) from vsession)"},
+    {"filetransfer", "numfiletransferid", "transferid",
+     "vsession_numsessionid",
+     "(select max(numsessionid) from vsession)"},
+    {"authsystem", "numauthsystemid", "authsystemid", "vishnu_vishnuid", "%1%"},
+    {"work", "id", "identifier",
+     "application_id, date_created, done_ratio, nbcpus, owner_id,"
+     " project_id, status, subject, consolidated",
+     "(select min(id) from application_version), CURRENT_TIMESTAMP, 1,"
+     " 1, (select min(numuserid) from users), (select min(id) from project),"
+     " 1, 'toto', false"}
+  };
+}
+
+IdAllocator&
+IdAllocator::getInstance() {
+  static IdAllocator instance;
+  return instance;
+}
+
+IdAllocator::IdAllocator() {
+  for (int i = 0; i < NB_ID_TYPES; ++i) {
+    mblocks[i] = NULL;
+  }
+}
+
+IdAllocator::~IdAllocator() {
+  for (int i = 0; i < NB_ID_TYPES; ++i) {
+    delete mblocks[i];
+  }
+  for (size_t i = 0; i < mretired.size(); ++i) {
+    delete mretired[i];
+  }
+}
+
+long long
+IdAllocator::nextCounter(vishnu::IdType type) {
+  if (type < 0 || type >= NB_ID_TYPES) {
+    throw SystemException(ERRCODE_SYSTEM, "Cannot reserve Object id, type in unrecognized");
+  }
+
+  for (;;) {
+    IdBlock* block = mblocks[type];
+    if (block != NULL) {
+      long long value = __sync_fetch_and_add(&block->next, 1);
+      if (value <= block->last) {
+        return value;
+      }
+    }
+
+    // exhausted, the first thread here reserves the next block
+    boost::lock_guard<boost::mutex> lock(mreserveMutex);
+    if (mblocks[type] == block) {
+      long long last = reserveBlock(type);
+      IdBlock* fresh = new IdBlock(last - ID_BLOCK_SIZE + 1, last);
+      __sync_synchronize();
+      mblocks[type] = fresh;
+      if (block != NULL) {
+        mretired.push_back(block);
+      }
+    }
+  }
+}
+
+long long
+IdAllocator::reserveBlock(vishnu::IdType type) {
+  Database* database = DbFactory().getDatabaseInstance();
+  const IdTable& idTable = ID_TABLES[type];
+
+  std::string reserve = boost::str(boost::format("UPDATE idcounter SET value=value+%1%"
+                                                 " WHERE name='%2%'")
+                                   % ID_BLOCK_SIZE % idTable.table);
+  std::string select = boost::str(boost::format("SELECT value FROM idcounter"
+                                                " WHERE name='%1%'")
+                                  % idTable.table);
+  // the ids generated before the counter existed used the primary key
+  std::string create = boost::str(boost::format("INSERT INTO idcounter (name, value)"
+                                                " SELECT '%1%', COALESCE(MAX(%2%), 0) FROM %1%"
+                                                " WHERE NOT EXISTS"
+                                                " (SELECT name FROM idcounter WHERE name='%1%')")
+                                  % idTable.table % idTable.key);
+
+  for (int attempt = 0; attempt < 2; ++attempt) {
+    std::string value;
+    int tid = database->startTransaction();
+    try {
+      database->process(reserve, tid);
+      boost::scoped_ptr<DatabaseResult> result(database->getResult(select, tid));
+      value = result->getFirstElement();
+    } catch (const std::exception& e) {
+      database->cancelTransaction(tid);
+      throw;
+    }
+    database->endTransaction(tid);
+
+    if (!value.empty()) {
+      return vishnu::convertToLong(value);
+    }
+    try {
+      database->process(create);
+    } catch (SystemException& e) {
+      // created meanwhile by another server
+    }
+  }
+  throw SystemException(ERRCODE_DBERR,
+                        std::string("Cannot reserve ids for the table ") + idTable.table);
+}
+
+std::string
+IdAllocator::getFormat(int vishnuId, const std::string& formatName) {
+  std::pair<int, std::string> key(vishnuId, formatName);
+  time_t now = std::time(NULL);
+  {
+    boost::lock_guard<boost::mutex> lock(mformatMutex);
+    std::map<std::pair<int, std::string>, CachedFormat>::const_iterator it = mformats.find(key);
+    if (it != mformats.end() && now - it->second.loadTime < ID_FORMAT_REFRESH) {
+      return it->second.format;
+    }
+  }
+
+  CachedFormat cached;
+  cached.format = vishnu::getAttrVishnu(formatName, vishnu::convertToString(vishnuId));
+  cached.loadTime = now;
+
+  boost::lock_guard<boost::mutex> lock(mformatMutex);
+  mformats[key] = cached;
+  return cached.format;
+}
+
+void
+IdAllocator::invalidateFormats() {
+  boost::lock_guard<boost::mutex> lock(mformatMutex);
+  mformats.clear();
+}
+
+std::string
+IdAllocator::getObjectId(int vishnuId,
+                         const std::string& formatName,
+                         vishnu::IdType type,
+                         const std::string& stringforgeneration) {
+  std::string format = getFormat(vishnuId, formatName);
+  if (format.empty()) {
+    throw SystemException(ERRCODE_SYSTEM, "The format "+ formatName +" is undefined");
+  }
+
+  long long counter = nextCounter(type);
+  std::string idGenerated = vishnu::getGeneratedName(format.c_str(), static_cast<int>(counter),
+                                                     type, stringforgeneration);
+  if (idGenerated.empty()) {
+    throw SystemException(ERRCODE_SYSTEM, "There is a problem during the id generation with the format:"+ formatName);
+  }
+
+  const IdTable& idTable = ID_TABLES[type];
+  // the counter is unique, other formats may give an id already used
+  if (format.find("$CPT") == std::string::npos) {
+    while (!vishnu::checkObjectId(idTable.table, idTable.idColumn, idGenerated)) {
+      idGenerated += vishnu::convertToString(counter);
+    }
+  }
+
+  // To reserve the row with the idGenerated
+  Database* database = DbFactory().getDatabaseInstance();
+  std::string values = idTable.values;
+  boost::algorithm::replace_all(values, "%1%", vishnu::convertToString(vishnuId));
+  std::string sqlReserve = boost::str(boost::format("INSERT INTO %1% (%2%, %3%) VALUES (%4%, '%5%')")
+                                      % idTable.table
+                                      % idTable.fields
+                                      % idTable.idColumn
+                                      % values
+                                      % database->escapeData(idGenerated));
+  try {
+    database->process(sqlReserve);
+  } catch (std::exception const & e) {
+    throw SystemException(ERRCODE_SYSTEM,
+                          boost::str(boost::format("Cannot reserve Object id: %1%") % e.what()));
+  }
+  return idGenerated;
+}
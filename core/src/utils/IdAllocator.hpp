@@ -0,0 +1,155 @@
+/**
+ * \file IdAllocator.hpp
+ * \brief This file presents the allocator of the VISHNU object ids
+ * \author Haikel Guemar (haikel.guemar@sysfera.com)
+ */
+
+#ifndef _IDALLOCATOR_HPP_
+#define _IDALLOCATOR_HPP_
+
+#include <map>
+#include <string>
+#include <vector>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/mutex.hpp>
+#include "utilServer.hpp"
+
+/**
+ * \brief Number of counter values reserved at once in the database
+ */
+const int ID_BLOCK_SIZE = 100;
+
+/**
+ * \brief Time in seconds after which a cached id format is read again
+ */
+const int ID_FORMAT_REFRESH = 60;
+
+/**
+ * \class IdAllocator
+ * \brief Generates the ids of the VISHNU objects (jobs, transfers, users...)
+ *
+ * The counters used by the formats are reserved by blocks of ID_BLOCK_SIZE
+ * values in the idcounter table, shared by all the servers, and handed out
+ * in memory without locking. A block is lost when the server stops, leaving
+ * a gap in the counters. The formats of the vishnu table are cached.
+ */
+class IdAllocator : public boost::noncopyable {
+public:
+  /**
+   * \brief Get the allocator of the process
+   * \return the allocator
+   */
+  static IdAllocator&
+  getInstance();
+
+  /**
+   * \brief Generate an id and reserve its row in the table of the object
+   * \param vishnuId the vishnu Id
+   * \param formatName the name of the format
+   * \param type the type of the Id generated
+   * \param stringforgeneration the string used for generation
+   * \return the id generated
+   */
+  std::string
+  getObjectId(int vishnuId,
+              const std::string& formatName,
+              vishnu::IdType type,
+              const std::string& stringforgeneration);
+
+  /**
+   * \brief Get the next value of a counter
+   * \param type the type of the object
+   * \return the value, unique among all the servers
+   */
+  long long
+  nextCounter(vishnu::IdType type);
+
+  /**
+   * \brief Get a format of the vishnu table
+   * \param vishnuId the vishnu Id
+   * \param formatName the name of the format
+   * \return the format, empty if undefined
+   */
+  std::string
+  getFormat(int vishnuId, const std::string& formatName);
+
+  /**
+   * \brief Forget the cached formats, to call when they are changed
+   */
+  void
+  invalidateFormats();
+
+  /**
+   * \brief Constructor, a server uses the allocator of getInstance
+   */
+  IdAllocator();
+
+  /**
+   * \brief Destructor
+   */
+  ~IdAllocator();
+
+private:
+  /**
+   * \struct IdBlock
+   * \brief Counter values reserved in the database, [next, last]
+   */
+  struct IdBlock {
+    IdBlock(long long first, long long lastValue)
+      : next(first), last(lastValue) {}
+    /**
+     * \brief The next value to hand out, incremented atomically
+     */
+    volatile long long next;
+    /**
+     * \brief The last value of the block
+     */
+    long long last;
+  };
+
+  /**
+   * \struct CachedFormat
+   * \brief A format and the time it was read
+   */
+  struct CachedFormat {
+    std::string format;
+    time_t loadTime;
+  };
+
+  /**
+   * \brief Reserve a block of values in the database
+   * \param type the type of the object
+   * \return the last value of the block
+   */
+  long long
+  reserveBlock(vishnu::IdType type);
+
+  /**
+   * \brief Number of types of ids
+   */
+  static const int NB_ID_TYPES = 6;
+
+  /**
+   * \brief The current block of each type, replaced when exhausted
+   */
+  IdBlock* volatile mblocks[NB_ID_TYPES];
+  /**
+   * \brief The exhausted blocks, freed with the allocator since other
+   * threads may still read them
+   */
+  std::vector<IdBlock*> mretired;
+  /**
+   * \brief Serializes the reservations of new blocks
+   */
+  boost::mutex mreserveMutex;
+  /**
+   * \brief The formats, by vishnu id and name
+   */
+  std::map<std::pair<int, std::string>, CachedFormat> mformats;
+  /**
+   * \brief Protects the formats
+   */
+  boost::mutex mformatMutex;
+};
+
+#endif // _IDALLOCATOR_HPP_
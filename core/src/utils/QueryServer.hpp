@@ -37,7 +37,8 @@ public:
   {
     mlistObject = NULL;
     DbFactory factory;
-    mdatabaseInstance = factory.getDatabaseInstance();
+    // the listings can be served by a replica of the database
+    mdatabaseInstance = factory.getReadDatabaseInstance();
   }
 
   /**
@@ -0,0 +1,138 @@
+/**
+ * \file SessionCache.cpp
+ * \brief This file implements the cache of the validated session keys
+ * \author Haikel Guemar (haikel.guemar@sysfera.com)
+ */
+
+#include "SessionCache.hpp"
+
+#include <boost/thread/locks.hpp>
+
+SessionCache&
+SessionCache::getInstance() {
+  static SessionCache instance;
+  return instance;
+}
+
+SessionCache::SessionCache() : mttl(DEFAULT_SESSION_CACHE_TTL) {}
+
+void
+SessionCache::setTtl(int ttl) {
+  boost::lock_guard<boost::mutex> lock(mmutex);
+  mttl = (ttl > 0) ? ttl : 0;
+  if (mttl == 0) {
+    minfos.clear();
+    mchecked.clear();
+  }
+}
+
+bool
+SessionCache::getInfo(const std::string& sessionKey, const std::string& machineId,
+                      UserSessionInfo& info) {
+  boost::lock_guard<boost::mutex> lock(mmutex);
+  InfoMap::const_iterator it = minfos.find(std::make_pair(sessionKey, machineId));
+  if (it == minfos.end() || it->second.expiry <= std::time(NULL)) {
+    return false;
+  }
+  info = it->second.info;
+  return true;
+}
+
+void
+SessionCache::putInfo(const std::string& sessionKey, const std::string& machineId,
+                      const UserSessionInfo& info) {
+  boost::lock_guard<boost::mutex> lock(mmutex);
+  if (mttl == 0) {
+    return;
+  }
+  time_t now = std::time(NULL);
+  purge(now);
+  InfoEntry& entry = minfos[std::make_pair(sessionKey, machineId)];
+  entry.info = info;
+  entry.expiry = now + mttl;
+}
+
+bool
+SessionCache::isChecked(const std::string& sessionKey) {
+  boost::lock_guard<boost::mutex> lock(mmutex);
+  std::map<std::string, CheckEntry>::const_iterator it = mchecked.find(sessionKey);
+  return it != mchecked.end() && it->second.expiry > std::time(NULL);
+}
+
+void
+SessionCache::setChecked(const std::string& sessionKey, const std::string& userId) {
+  boost::lock_guard<boost::mutex> lock(mmutex);
+  if (mttl == 0) {
+    return;
+  }
+  time_t now = std::time(NULL);
+  purge(now);
+  CheckEntry& entry = mchecked[sessionKey];
+  entry.userId = userId;
+  entry.expiry = now + mttl;
+}
+
+void
+SessionCache::invalidateSession(const std::string& sessionKey) {
+  boost::lock_guard<boost::mutex> lock(mmutex);
+  mchecked.erase(sessionKey);
+  InfoMap::iterator it = minfos.lower_bound(std::make_pair(sessionKey, std::string()));
+  while (it != minfos.end() && it->first.first == sessionKey) {
+    minfos.erase(it++);
+  }
+}
+
+void
+SessionCache::invalidateUser(const std::string& userId) {
+  boost::lock_guard<boost::mutex> lock(mmutex);
+  for (InfoMap::iterator it = minfos.begin(); it != minfos.end();) {
+    if (it->second.info.userid == userId) {
+      minfos.erase(it++);
+    } else {
+      ++it;
+    }
+  }
+  for (std::map<std::string, CheckEntry>::iterator it = mchecked.begin(); it != mchecked.end();) {
+    if (it->second.userId == userId) {
+      mchecked.erase(it++);
+    } else {
+      ++it;
+    }
+  }
+}
+
+void
+SessionCache::clear() {
+  boost::lock_guard<boost::mutex> lock(mmutex);
+  minfos.clear();
+  mchecked.clear();
+}
+
+void
+SessionCache::purge(time_t now) {
+  if (minfos.size() >= SESSION_CACHE_MAX_SIZE) {
+    for (InfoMap::iterator it = minfos.begin(); it != minfos.end();) {
+      if (it->second.expiry <= now) {
+        minfos.erase(it++);
+      } else {
+        ++it;
+      }
+    }
+    // all still valid, start again rather than growing
+    if (minfos.size() >= SESSION_CACHE_MAX_SIZE) {
+      minfos.clear();
+    }
+  }
+  if (mchecked.size() >= SESSION_CACHE_MAX_SIZE) {
+    for (std::map<std::string, CheckEntry>::iterator it = mchecked.begin(); it != mchecked.end();) {
+      if (it->second.expiry <= now) {
+        mchecked.erase(it++);
+      } else {
+        ++it;
+      }
+    }
+    if (mchecked.size() >= SESSION_CACHE_MAX_SIZE) {
+      mchecked.clear();
+    }
+  }
+}
@@ -0,0 +1,161 @@
+/**
+ * \file SessionCache.hpp
+ * \brief This file presents the cache of the validated session keys
+ * \author Haikel Guemar (haikel.guemar@sysfera.com)
+ */
+
+#ifndef _SESSIONCACHE_HPP_
+#define _SESSIONCACHE_HPP_
+
+#include <ctime>
+#include <map>
+#include <string>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/mutex.hpp>
+#include "utilServer.hpp"
+
+/**
+ * \brief Default time in seconds a validated session key is trusted
+ */
+const int DEFAULT_SESSION_CACHE_TTL = 30;
+
+/**
+ * \brief Number of entries above which the expired ones are dropped
+ */
+const size_t SESSION_CACHE_MAX_SIZE = 10000;
+
+/**
+ * \class SessionCache
+ * \brief Keeps the result of the session key checks for a short time, so
+ * that repeated calls with the same session don't join vsession, users,
+ * account and machine each time.
+ *
+ * Only successful checks are cached. The servers invalidate the entries
+ * when they close a session or change a user, a local account or a
+ * machine; changes made by another process are seen after the TTL.
+ */
+class SessionCache : public boost::noncopyable {
+public:
+  /**
+   * \brief Get the cache of the process
+   * \return the cache
+   */
+  static SessionCache&
+  getInstance();
+
+  /**
+   * \brief Set the time the entries are kept
+   * \param ttl the time in seconds, 0 disables the cache
+   */
+  void
+  setTtl(int ttl);
+
+  /**
+   * \brief Get the information of a validated session
+   * \param sessionKey the session key
+   * \param machineId the machine checked with the key, empty if none
+   * \param info OUT, the information
+   * \return true if found and not expired
+   */
+  bool
+  getInfo(const std::string& sessionKey, const std::string& machineId,
+          UserSessionInfo& info);
+
+  /**
+   * \brief Record the information of a validated session
+   * \param sessionKey the session key
+   * \param machineId the machine checked with the key, empty if none
+   * \param info the information
+   */
+  void
+  putInfo(const std::string& sessionKey, const std::string& machineId,
+          const UserSessionInfo& info);
+
+  /**
+   * \brief Check whether a session passed SessionServer::check recently
+   * \param sessionKey the session key
+   * \return true if found and not expired
+   */
+  bool
+  isChecked(const std::string& sessionKey);
+
+  /**
+   * \brief Record that a session passed SessionServer::check
+   * \param sessionKey the session key
+   * \param userId the owner of the session
+   */
+  void
+  setChecked(const std::string& sessionKey, const std::string& userId);
+
+  /**
+   * \brief Forget a session, to call when it is closed
+   * \param sessionKey the session key
+   */
+  void
+  invalidateSession(const std::string& sessionKey);
+
+  /**
+   * \brief Forget the sessions of a user, to call when the user or one of
+   * its local accounts changes
+   * \param userId the VISHNU user id
+   */
+  void
+  invalidateUser(const std::string& userId);
+
+  /**
+   * \brief Forget all the sessions, e.g. when a machine changes
+   */
+  void
+  clear();
+
+private:
+  /**
+   * \brief Constructor
+   */
+  SessionCache();
+
+  /**
+   * \brief Drop the expired entries when the cache is too big
+   * \param now the current time
+   */
+  void
+  purge(time_t now);
+
+  /**
+   * \struct InfoEntry
+   * \brief A cached result of validateAuthKey
+   */
+  struct InfoEntry {
+    UserSessionInfo info;
+    time_t expiry;
+  };
+
+  /**
+   * \struct CheckEntry
+   * \brief A cached result of SessionServer::check
+   */
+  struct CheckEntry {
+    std::string userId;
+    time_t expiry;
+  };
+
+  /**
+   * \brief The validated sessions, by session key and machine
+   */
+  typedef std::map<std::pair<std::string, std::string>, InfoEntry> InfoMap;
+  InfoMap minfos;
+  /**
+   * \brief The checked sessions, by session key
+   */
+  std::map<std::string, CheckEntry> mchecked;
+  /**
+   * \brief The time the entries are kept, in seconds
+   */
+  int mttl;
+  /**
+   * \brief Protects the entries
+   */
+  boost::mutex mmutex;
+};
+
+#endif // _SESSIONCACHE_HPP_
@@ -46,6 +46,11 @@ typedef enum {
 
 static const std::string AUTOM_KEYWORD="autom";
 static const std::string ALL_KEYWORD="all";
+/**
+ * \brief Environment variable through which the slave or the server gives
+ * PosixServer the directory where tms-posix reports the end of the jobs
+ */
+static const std::string JOB_EVENT_DIR_ENV="VISHNU_JOB_EVENT_DIR";
 
 
 const std::map<std::string, int> BATCH_NAME_TO_TYPE_MAP = boost::assign::map_list_of
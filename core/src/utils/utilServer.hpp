@@ -247,15 +247,6 @@ namespace vishnu {
                 std::string objectId);
 
 
-  /**
-   * \brief Function to get a specific vishnu counter
-   * \param vishnuId the id of the vishnu configuration
-   * \param type : the type of id generated
-   * \return The int counter value
-   */
-  int
-  getVishnuCounter(std::string vishnuId, IdType type);
-
   /**
    * \brief Function to get information from the table vishnu
    * \param attrname the name of the attribut
@@ -275,15 +266,6 @@ namespace vishnu {
   void
   incrementCpt(std::string cptName, int cpt, int transacId = -1);
 
-  /**
-   * \brief To set the objectId in the specified row in the database
-   * \param key : the key to identify the reserved row
-   * \param objectId : the objectId to set
-   * \param type : the type of the object
-   */
-  void
-  reserveObjectId(int key, std::string &objectId, IdType type);
-
   /**
   * \brief Function to get an Id generated by VISHNU
   * \param vishnuId the vishnu Id
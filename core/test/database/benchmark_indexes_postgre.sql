@@ -0,0 +1,71 @@
+-- Benchmark of the indexes of database_update_indexes_postgre.sql
+--
+-- Run it with psql on a scratch database created with postgre_create.sql,
+-- as a superuser (the foreign keys are not checked while populating):
+--   psql -d vishnu_bench -f benchmark_indexes_postgre.sql > bench.log
+--
+-- It fills 1M jobs, 1M commands and 200k transfers over 10k sessions and
+-- 20 machines, then runs the main queries of the servers and of the monitor
+-- without the indexes and with them. Compare the "Execution time" lines.
+
+\set ON_ERROR_STOP 1
+SET client_min_messages = warning;
+
+DROP INDEX IF EXISTS vsession_sessionkey_idx;
+DROP INDEX IF EXISTS vsession_vsessionid_idx;
+DROP INDEX IF EXISTS vsession_state_closepolicy_idx;
+DROP INDEX IF EXISTS job_jobid_idx;
+DROP INDEX IF EXISTS job_submitmachineid_batchtype_status_idx;
+DROP INDEX IF EXISTS job_submitmachineid_submitdate_idx;
+DROP INDEX IF EXISTS job_vsession_numsessionid_idx;
+DROP INDEX IF EXISTS command_vsession_numsessionid_starttime_idx;
+DROP INDEX IF EXISTS filetransfer_status_idx;
+DROP INDEX IF EXISTS filetransfer_transferid_idx;
+DROP INDEX IF EXISTS filetransfer_vsession_numsessionid_idx;
+
+SET session_replication_role = replica;
+
+-- 10k sessions, 1% of them opened
+INSERT INTO vsession (numsessionid, clmachine_numclmachineid, closepolicy, creation,
+                      lastconnect, sessionkey, state, timeout, users_numuserid, vsessionid)
+SELECT n, 1, 1 + n % 2, now() - interval '30 days', now() - (n % 3600) * interval '1 second',
+       md5('key' || n), CASE WHEN n % 100 = 0 THEN 1 ELSE 0 END, 3600, 1 + n % 100, 'S_' || n
+FROM generate_series(1, 10000) AS n;
+
+-- 1M jobs over 20 machines with 2 batch types each, 0.5% of them not terminated
+INSERT INTO job (numjobid, batchjobid, batchtype, jobid, owner, status, submitdate,
+                 submitmachineid, vsession_numsessionid, job_owner_id, machine_id)
+SELECT n, 'B_' || n, (n % 20) % 2, 'J_' || n, 'user_' || (n % 100),
+       CASE WHEN n % 200 = 0 THEN 1 + n % 4 ELSE 5 + n % 4 END,
+       now() - (n % 525600) * interval '1 minute',
+       'MA_' || (n % 20), 1 + n % 10000, 1 + n % 100, 1 + n % 20
+FROM generate_series(1, 1000000) AS n;
+
+-- 1M commands
+INSERT INTO command (numcommandid, ctype, description, endtime, starttime, status,
+                     vishnuobjectid, vsession_numsessionid)
+SELECT n, n % 3, 'vishnu_list_jobs -m MA_' || (n % 20), now() - n * interval '1 second',
+       now() - n * interval '1 second', 1, '', 1 + n % 10000
+FROM generate_series(1, 1000000) AS n;
+
+-- 200k transfers, 0.1% of them in progress
+INSERT INTO filetransfer (numfiletransferid, processid, status, transferid, userid,
+                          vsession_numsessionid)
+SELECT n, n, CASE WHEN n % 1000 = 0 THEN 0 ELSE 1 END, 'FT_' || n, 'user_' || (n % 100),
+       1 + n % 10000
+FROM generate_series(1, 200000) AS n;
+
+SET session_replication_role = DEFAULT;
+
+ANALYZE vsession;
+ANALYZE job;
+ANALYZE command;
+ANALYZE filetransfer;
+
+\echo '==================== without the indexes ===================='
+\ir benchmark_queries_postgre.sql
+
+\ir ../../database/database_update_indexes_postgre.sql
+
+\echo '==================== with the indexes ===================='
+\ir benchmark_queries_postgre.sql
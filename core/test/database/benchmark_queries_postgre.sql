@@ -0,0 +1,52 @@
+-- Queries timed by benchmark_indexes_postgre.sql
+
+\echo '---- MonitorXMS::checkJobs'
+EXPLAIN ANALYZE
+SELECT jobId, batchJobId, vmIp, vmId, owner
+ FROM job, vsession
+ WHERE vsession.numsessionid=job.vsession_numsessionid
+ AND submitMachineId='MA_4'
+ AND batchType=0
+ AND status >= 0
+ AND status < 5;
+
+\echo '---- job lookup by id'
+EXPLAIN ANALYZE
+SELECT owner, status, batchJobId FROM job WHERE jobId='J_424242';
+
+\echo '---- jobs of a machine submitted during the last day'
+EXPLAIN ANALYZE
+SELECT jobId, status FROM job, vsession
+ WHERE vsession.numsessionid=job.vsession_numsessionid
+ AND job.submitMachineId='MA_4'
+ AND submitDate >= now() - interval '1 day'
+ ORDER BY submitDate;
+
+\echo '---- SessionServer::check'
+EXPLAIN ANALYZE
+SELECT state, status, passwordstate, userid
+ FROM users, vsession
+ WHERE users.numuserid = vsession.users_numuserid
+ AND vsession.sessionkey=md5('key4242')
+ AND vsession.state<>-1;
+
+\echo '---- sessions to close on timeout'
+EXPLAIN ANALYZE
+SELECT sessionkey FROM vsession
+ WHERE EXTRACT(epoch FROM CURRENT_TIMESTAMP) - EXTRACT(epoch FROM lastconnect) > timeout
+ AND state=1 AND closepolicy=1;
+
+\echo '---- ShellExporter::exporte'
+EXPLAIN ANALYZE
+SELECT command.ctype, command.description, command.starttime
+ FROM command, vsession
+ WHERE vsession.numsessionid=command.vsession_numsessionid
+ AND vsession.vsessionid='S_4242'
+ ORDER BY starttime ASC;
+
+\echo '---- MonitorXMS::checkFile'
+EXPLAIN ANALYZE
+SELECT transferid, processid
+ FROM filetransfer, vsession
+ WHERE vsession.numsessionid=filetransfer.vsession_numsessionid
+ AND filetransfer.status=0;
@@ -4,4 +4,14 @@ Database:: Database(){};
 
 Database::~Database(){};
 
+int
+Database::processBatch(const std::vector<std::string>& requests, int transacId) {
+  for (std::vector<std::string>::const_iterator it = requests.begin(); it != requests.end(); ++it) {
+    process(*it, transacId);
+  }
+  return SUCCESS;
+}
 
+void
+Database::prepare(const std::string& name, const std::string& query) {
+}
@@ -10,8 +10,10 @@
 
 #include <string>
 #include <vector>
+#include "DatabaseCursor.hpp"
 #include "DatabaseResult.hpp"
 #include "DbConfiguration.hpp"
+#include "DbParams.hpp"
 
 static const int SUCCESS =  0;
 /**
@@ -28,6 +30,17 @@ public :
    */
   virtual int
   process(std::string request, int transacId = -1) = 0;
+  /**
+   * \brief Run several requests which do not return rows, sending them
+   * together when the database allows it rather than one round trip each
+   * \param requests The requests, each a SINGLE SQL statement without a semicolon
+   * \param transacId the id of the transaction if one is used
+   * \return raises an exception on the first failing request; the requests
+   * are not guaranteed to be all or nothing outside of a transaction
+   */
+  virtual int
+  processBatch(const std::vector<std::string>& requests, int transacId = -1);
+
   /**
   * \brief To make a connection to the database
   * \fn int connect()
@@ -43,6 +56,14 @@ public :
   */
   virtual DatabaseResult*
   getResult(std::string request, int transacId = -1) = 0;
+  /**
+  * \brief To stream the rows of a select request instead of loading them
+  * \param request The request to process
+  * \param transacId the id of the transaction if one is used
+  * \return A cursor on the rows, holding a connection until it is destroyed
+  */
+  virtual DatabaseCursor*
+  getCursor(std::string request, int transacId = -1) = 0;
   /**
    * \brief To get the type of database
    * \return An enum identifying the type of database
@@ -97,6 +118,34 @@ virtual ~Database();
    */
   virtual std::string escapeData(const std::string& data) = 0;
 
+  /**
+   * \brief Register a statement to run through the prepared statement API
+   * \param name The name of the statement
+   * \param query The request, with a '?' per parameter and no semicolon
+   */
+  virtual void
+  prepare(const std::string& name, const std::string& query);
+
+  /**
+   * \brief Run a prepared statement which does not return rows
+   * \param name The name of the statement
+   * \param params The parameters of the statement
+   * \param transacId the id of the transaction if one is used
+   * \return raises an exception on error
+   */
+  virtual int
+  processPrepared(const std::string& name, const DbParams& params, int transacId = -1) = 0;
+
+  /**
+   * \brief Run a prepared statement returning rows
+   * \param name The name of the statement
+   * \param params The parameters of the statement
+   * \param transacId the id of the transaction if one is used
+   * \return An object which encapsulates the database results
+   */
+  virtual DatabaseResult*
+  getPreparedResult(const std::string& name, const DbParams& params, int transacId = -1) = 0;
+
 
 protected :
   /**
@@ -23,6 +23,9 @@ public:
    * \brief The database type
    */
   typedef enum {
+    POSTGRESQL,
+    ORACLE,
+    MYSQL,
     MOCK
   } db_type_t;
 
@@ -29,3 +29,18 @@ Database* DbFactory::getDatabaseInstance()
   return mdb;
 }
 
+void
+DbFactory::setDatabaseInstance(Database* database)
+{
+  mdb = database;
+}
+
+void
+DbFactory::createReplicaInstances(DbConfiguration config)
+{
+}
+
+Database* DbFactory::getReadDatabaseInstance()
+{
+  return mdb;
+}
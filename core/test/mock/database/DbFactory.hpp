@@ -44,6 +44,27 @@ public :
   Database*
   getDatabaseInstance();
 
+  /**
+   * \brief Replace the single instance of the database, for the tests
+   * \param database the database, not deleted by the factory
+   */
+  static void
+  setDatabaseInstance(Database* database);
+
+  /**
+   * \brief Create the read-only replicas, none in the mock
+   * \param dbConfig  the configuration of the database
+   */
+  void
+  createReplicaInstances(DbConfiguration dbConfig);
+
+  /**
+   * \brief Get a database for the queries which can read slightly stale data
+   * \return the single instance of the database
+   */
+  Database*
+  getReadDatabaseInstance();
+
 private :
   /**
    * \brief The unique instance of the database
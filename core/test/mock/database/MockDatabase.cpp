@@ -6,6 +6,34 @@
  */
 #include "MockDatabase.hpp"
 
+// anonymous namespace
+namespace {
+  /**
+   * \class MockCursor
+   * \brief Cursor without rows
+   */
+  class MockCursor : public DatabaseCursor {
+  public:
+    bool
+    next() { return false; }
+
+    size_t
+    getNbFields() const { return 0; }
+
+    std::string
+    getFieldName(size_t col) const { return ""; }
+
+    bool
+    isNull(size_t col) const { return true; }
+
+    DbStringRef
+    getRef(size_t col) const {
+      DbStringRef ref = {"", 0};
+      return ref;
+    }
+  };
+}
+
 int
 MockDatabase::process(std::string request, int transacId){
   return SUCCESS;
@@ -56,6 +84,11 @@ MockDatabase::getResult(std::string request, int transacId) {
   return new DatabaseResult(result, param);
 }
 
+DatabaseCursor*
+MockDatabase::getCursor(std::string request, int transacId) {
+  return new MockCursor();
+}
+
 int
 MockDatabase::startTransaction() {
   return 1;
@@ -84,3 +117,14 @@ MockDatabase::escapeData(const std::string& data) {
   return data;
 }
 
+int
+MockDatabase::processPrepared(const std::string& name, const DbParams& params, int transacId) {
+  return SUCCESS;
+}
+
+DatabaseResult*
+MockDatabase::getPreparedResult(const std::string& name, const DbParams& params, int transacId) {
+  std::vector<std::vector<std::string> > result;
+  std::vector<std::string> param;
+  return new DatabaseResult(result, param);
+}
@@ -50,6 +50,14 @@ public :
   */
   DatabaseResult*
   getResult(std::string request, int transacId = -1);
+  /**
+  * \brief To stream the rows of a select request instead of loading them
+  * \param request The request to process
+  * \param transacId the id of the transaction if one is used
+  * \return A cursor on the rows, holding a connection until it is destroyed
+  */
+  DatabaseCursor*
+  getCursor(std::string request, int transacId = -1);
   /**
    * \brief To get the type of database
    * \return An enum identifying the type of database
@@ -99,6 +107,26 @@ public :
   virtual std::string
   escapeData(const std::string& data);
 
+  /**
+   * \brief Run a prepared statement which does not return rows
+   * \param name The name of the statement
+   * \param params The parameters of the statement
+   * \param transacId the id of the transaction if one is used
+   * \return 0 on success, an error code otherwise
+   */
+  virtual int
+  processPrepared(const std::string& name, const DbParams& params, int transacId = -1);
+
+  /**
+   * \brief Run a prepared statement returning rows
+   * \param name The name of the statement
+   * \param params The parameters of the statement
+   * \param transacId the id of the transaction if one is used
+   * \return An object which encapsulates the database results
+   */
+  virtual DatabaseResult*
+  getPreparedResult(const std::string& name, const DbParams& params, int transacId = -1);
+
 private :
   /////////////////////////////////
   // Attributes
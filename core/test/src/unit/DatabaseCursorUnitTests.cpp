@@ -0,0 +1,79 @@
+#include <boost/test/unit_test.hpp>
+#include <string>
+#include <vector>
+#include "DatabaseCursor.hpp"
+
+namespace {
+  /**
+   * \brief Cursor on a single row of values, "NULL" standing for NULL
+   */
+  class RowCursor : public DatabaseCursor {
+  public:
+    explicit RowCursor(const std::vector<std::string>& row) : mrow(row) {}
+
+    bool
+    next() { return false; }
+
+    size_t
+    getNbFields() const { return mrow.size(); }
+
+    std::string
+    getFieldName(size_t col) const { return ""; }
+
+    bool
+    isNull(size_t col) const { return mrow[col] == "NULL"; }
+
+    DbStringRef
+    getRef(size_t col) const {
+      DbStringRef ref = {mrow[col].data(), mrow[col].size()};
+      return ref;
+    }
+
+  private:
+    std::vector<std::string> mrow;
+  };
+}
+
+BOOST_AUTO_TEST_SUITE( DatabaseCursor_unit_tests )
+
+BOOST_AUTO_TEST_CASE( test_getInt_n )
+{
+  std::vector<std::string> row;
+  row.push_back("42");
+  row.push_back("-7");
+  row.push_back("NULL");
+  row.push_back("12abc");
+  row.push_back("");
+  row.push_back("4294967296");
+  RowCursor cursor(row);
+
+  BOOST_REQUIRE_EQUAL(cursor.getInt(0), 42);
+  BOOST_REQUIRE_EQUAL(cursor.getInt(1), -7);
+  BOOST_REQUIRE_EQUAL(cursor.getInt(2), -1);
+  BOOST_REQUIRE_EQUAL(cursor.getInt(3), -1);
+  BOOST_REQUIRE_EQUAL(cursor.getInt(4, 0), 0);
+  BOOST_REQUIRE_EQUAL(cursor.getInt(5), -1);
+  BOOST_REQUIRE_EQUAL(cursor.getInt64(5), 4294967296LL);
+  BOOST_REQUIRE_EQUAL(cursor.getString(3), "12abc");
+  BOOST_MESSAGE("Test integer accessors OK");
+}
+
+BOOST_AUTO_TEST_CASE( test_getTime_n )
+{
+  std::vector<std::string> row;
+  row.push_back("1970-01-02");
+  row.push_back("2013-03-14 15:09:26");
+  row.push_back("2013-03-14 15:09:26.535897");
+  row.push_back("NULL");
+  row.push_back("14/03/2013");
+  RowCursor cursor(row);
+
+  BOOST_REQUIRE_EQUAL(cursor.getTime(0), 86400);
+  BOOST_REQUIRE_EQUAL(cursor.getTime(1), 1363273766);
+  BOOST_REQUIRE_EQUAL(cursor.getTime(2), 1363273766);
+  BOOST_REQUIRE_EQUAL(cursor.getTime(3), 0);
+  BOOST_REQUIRE_EQUAL(cursor.getTime(4), 0);
+  BOOST_MESSAGE("Test date accessor OK");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,202 @@
+#include <boost/test/unit_test.hpp>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <boost/bind.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include "MockDatabase.hpp"
+#include "DatabaseResult.hpp"
+#include "DbFactory.hpp"
+#include "IdAllocator.hpp"
+
+/**
+ * \brief A mock database keeping the idcounter table, a transaction locks
+ * the whole table until it ends
+ */
+class CounterDatabase : public MockDatabase {
+public:
+  CounterDatabase()
+    : MockDatabase(DbConfiguration()), mreserved(0), mcreated(0) {}
+
+  int
+  process(std::string request, int transacId = -1) {
+    boost::unique_lock<boost::mutex> lock(mtable, boost::defer_lock);
+    if (transacId == -1) {
+      lock.lock();
+    }
+    std::string name = getName(request);
+    if (request.find("UPDATE idcounter SET value=value+") == 0) {
+      std::map<std::string, long long>::iterator it = mcounters.find(name);
+      if (it != mcounters.end()) {
+        it->second += ID_BLOCK_SIZE;
+        ++mreserved;
+      }
+    } else if (request.find("INSERT INTO idcounter") == 0) {
+      // the rows stored before the counter existed are kept
+      if (mcounters.find(name) == mcounters.end()) {
+        mcounters[name] = mexisting[name];
+        ++mcreated;
+      }
+    }
+    return SUCCESS;
+  }
+
+  DatabaseResult*
+  getResult(std::string request, int transacId = -1) {
+    boost::unique_lock<boost::mutex> lock(mtable, boost::defer_lock);
+    if (transacId == -1) {
+      lock.lock();
+    }
+    std::vector<std::vector<std::string> > rows;
+    std::map<std::string, long long>::const_iterator it = mcounters.find(getName(request));
+    if (it != mcounters.end()) {
+      rows.push_back(std::vector<std::string>(1, boost::lexical_cast<std::string>(it->second)));
+    }
+    return new DatabaseResult(rows, std::vector<std::string>(1, "value"));
+  }
+
+  int
+  startTransaction() {
+    mtable.lock();
+    return 1;
+  }
+
+  void
+  endTransaction(int transactionID) {
+    mtable.unlock();
+  }
+
+  void
+  cancelTransaction(int transactionID) {
+    mtable.unlock();
+  }
+
+  /**
+   * \brief Set the last primary key of a table without counter
+   */
+  void
+  setExisting(const std::string& table, long long lastKey) {
+    mexisting[table] = lastKey;
+  }
+
+  /**
+   * \brief The number of blocks reserved
+   */
+  int
+  getReserved() {
+    boost::lock_guard<boost::mutex> lock(mtable);
+    return mreserved;
+  }
+
+  /**
+   * \brief The number of counters created
+   */
+  int
+  getCreated() {
+    boost::lock_guard<boost::mutex> lock(mtable);
+    return mcreated;
+  }
+
+private:
+  /**
+   * \brief The name of the counter, the first quoted word of the request
+   */
+  static std::string
+  getName(const std::string& request) {
+    size_t begin = request.find('\'') + 1;
+    return request.substr(begin, request.find('\'', begin) - begin);
+  }
+
+  boost::mutex mtable;
+  std::map<std::string, long long> mcounters;
+  std::map<std::string, long long> mexisting;
+  int mreserved;
+  int mcreated;
+};
+
+/**
+ * \brief Installs a counter database
+ */
+struct CounterFixture {
+  CounterFixture() {
+    DbFactory::setDatabaseInstance(&database);
+  }
+
+  ~CounterFixture() {
+    DbFactory::setDatabaseInstance(NULL);
+  }
+
+  CounterDatabase database;
+};
+
+/**
+ * \brief Take ids from an allocator
+ */
+static void
+allocate(IdAllocator* allocator, int count, std::vector<long long>* ids) {
+  for (int i = 0; i < count; ++i) {
+    ids->push_back(allocator->nextCounter(vishnu::JOB));
+  }
+}
+
+BOOST_AUTO_TEST_SUITE( IdAllocator_unit_tests )
+
+BOOST_FIXTURE_TEST_CASE( test_first_counter_n, CounterFixture )
+{
+  database.setExisting("job", 41);
+  IdAllocator allocator;
+
+  // the counter is created after the ids stored without it
+  BOOST_CHECK_EQUAL(allocator.nextCounter(vishnu::JOB), 42);
+  BOOST_CHECK_EQUAL(allocator.nextCounter(vishnu::JOB), 43);
+  BOOST_CHECK_EQUAL(database.getCreated(), 1);
+  BOOST_CHECK_EQUAL(database.getReserved(), 1);
+
+  // each type has its own counter
+  BOOST_CHECK_EQUAL(allocator.nextCounter(vishnu::USER), 1);
+  BOOST_CHECK_EQUAL(database.getCreated(), 2);
+}
+
+BOOST_FIXTURE_TEST_CASE( test_block_refill_n, CounterFixture )
+{
+  IdAllocator allocator;
+  for (long long expected = 1; expected <= ID_BLOCK_SIZE; ++expected) {
+    BOOST_REQUIRE_EQUAL(allocator.nextCounter(vishnu::JOB), expected);
+  }
+  BOOST_CHECK_EQUAL(database.getReserved(), 1);
+
+  // the block is used up, the next one follows it
+  BOOST_CHECK_EQUAL(allocator.nextCounter(vishnu::JOB), ID_BLOCK_SIZE + 1);
+  BOOST_CHECK_EQUAL(database.getReserved(), 2);
+}
+
+BOOST_FIXTURE_TEST_CASE( test_two_allocators_b, CounterFixture )
+{
+  // two servers share the database, several threads in each
+  IdAllocator first;
+  IdAllocator second;
+  const int nbThreads = 4;
+  const int nbIds = 3 * ID_BLOCK_SIZE + 7;
+  std::vector<std::vector<long long> > ids(2 * nbThreads);
+  boost::thread_group threads;
+  for (int i = 0; i < nbThreads; ++i) {
+    threads.create_thread(boost::bind(&allocate, &first, nbIds, &ids[2 * i]));
+    threads.create_thread(boost::bind(&allocate, &second, nbIds, &ids[2 * i + 1]));
+  }
+  threads.join_all();
+
+  std::set<long long> unique;
+  for (size_t i = 0; i < ids.size(); ++i) {
+    BOOST_REQUIRE_EQUAL(ids[i].size(), static_cast<size_t>(nbIds));
+    unique.insert(ids[i].begin(), ids[i].end());
+  }
+  BOOST_CHECK_EQUAL(unique.size(), ids.size() * nbIds);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+// THE END
@@ -0,0 +1,142 @@
+/**
+ * \file QueryBuildBench.cpp
+ * \brief Measures the construction of the session validation request by
+ * concurrent threads, escaping through a pooled connection, escaping
+ * locally or binding the values
+ * usage: query_build_bench [nbThreads] [nbQueries] [poolSize]
+ */
+#include <iostream>
+#include <string>
+#include <boost/bind.hpp>
+#include <boost/format.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/thread.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include "DbConnectionPool.hpp"
+#include "DbParams.hpp"
+#include "SqlEscape.hpp"
+#include "constants.hpp"
+
+namespace {
+  const std::string SESSION_KEY = "3f2a1c'4be5d6f7a8b9c0d1e2f3a4b5c6d7e8f9";
+  const std::string MACHINE_ID = "machine_1";
+
+  /**
+   * \brief Build the request the way validateAuthKey used to
+   */
+  template <typename Escape>
+  std::string
+  buildQuery(Escape escape) {
+    return (boost::format("SELECT vsession.numsessionid, machine.name, machine.nummachineid,"
+                          "  users.numuserid, users.userid, users.privilege, "
+                          "  account.aclogin, account.home"
+                          " FROM vsession, users, account, machine"
+                          " WHERE vsession.sessionkey='%1%'"
+                          "  AND vsession.state=%2%"
+                          "  AND users.numuserid=vsession.users_numuserid"
+                          "  AND users.numuserid=account.users_numuserid"
+                          "  AND account.status=%3%"
+                          "  AND account.machine_nummachineid=machine.nummachineid"
+                          "  AND machine.machineid='%4%';")
+            % escape(SESSION_KEY)
+            % vishnu::SESSION_ACTIVE
+            % vishnu::STATUS_ACTIVE
+            % escape(MACHINE_ID)).str();
+  }
+
+  /**
+   * \brief Escape holding a slot of the pool, like escapeData did
+   */
+  struct PooledEscape {
+    DbConnectionPool* pool;
+
+    std::string
+    operator()(const std::string& data) const {
+      bool idle;
+      int pos = pool->acquire(idle);
+      std::string res = SqlEscape::escapeMySQL(data, false);
+      pool->release(pos);
+      return res;
+    }
+  };
+
+  /**
+   * \brief Escape without a connection
+   */
+  struct LocalEscape {
+    std::string
+    operator()(const std::string& data) const {
+      return SqlEscape::escapeMySQL(data, false);
+    }
+  };
+
+  void
+  runPooled(DbConnectionPool* pool, int nbQueries) {
+    PooledEscape escape = {pool};
+    for (int i = 0; i < nbQueries; ++i) {
+      buildQuery(escape);
+    }
+  }
+
+  void
+  runLocal(int nbQueries) {
+    for (int i = 0; i < nbQueries; ++i) {
+      buildQuery(LocalEscape());
+    }
+  }
+
+  void
+  runBound(int nbQueries) {
+    for (int i = 0; i < nbQueries; ++i) {
+      DbParams()
+        .add(SESSION_KEY)
+        .add(vishnu::SESSION_ACTIVE)
+        .add(vishnu::STATUS_ACTIVE)
+        .add(MACHINE_ID);
+    }
+  }
+
+  /**
+   * \brief Run a function in nbThreads threads and print the throughput
+   */
+  void
+  bench(const std::string& label, boost::function<void()> func,
+        int nbThreads, int nbQueries) {
+    using boost::posix_time::microsec_clock;
+    using boost::posix_time::ptime;
+
+    ptime start = microsec_clock::universal_time();
+    boost::thread_group threads;
+    for (int i = 0; i < nbThreads; ++i) {
+      threads.create_thread(func);
+    }
+    threads.join_all();
+    double elapsed = static_cast<double>(
+      (microsec_clock::universal_time() - start).total_microseconds()) / 1000.;
+
+    std::cout << boost::format("%1%: %2% ms, %3% queries/s\n")
+      % label
+      % elapsed
+      % static_cast<long>(nbThreads * nbQueries / (elapsed / 1000.));
+  }
+}
+
+int
+main(int argc, char** argv) {
+  int nbThreads = (argc > 1) ? boost::lexical_cast<int>(argv[1]) : 32;
+  int nbQueries = (argc > 2) ? boost::lexical_cast<int>(argv[2]) : 100000;
+  unsigned poolSize = (argc > 3) ? boost::lexical_cast<unsigned>(argv[3]) : 10;
+
+  std::cout << boost::format("%1% threads, %2% queries each, pool of %3%\n")
+    % nbThreads % nbQueries % poolSize;
+
+  DbConnectionPool pool(poolSize, 0, 0);
+  bench("pooled escape", boost::bind(&runPooled, &pool, nbQueries), nbThreads, nbQueries);
+  DbPoolMetrics metrics = pool.getMetrics();
+  std::cout << boost::format("  %1% checkouts, %2% waited, %3% ms waited in total\n")
+    % metrics.acquisitions % metrics.waits % metrics.totalWait;
+
+  bench("local escape ", boost::bind(&runLocal, nbQueries), nbThreads, nbQueries);
+  bench("bound params ", boost::bind(&runBound, nbQueries), nbThreads, nbQueries);
+  return 0;
+}
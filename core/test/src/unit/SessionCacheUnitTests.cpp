@@ -0,0 +1,78 @@
+#include <boost/test/unit_test.hpp>
+#include <string>
+#include "SessionCache.hpp"
+
+namespace {
+  UserSessionInfo
+  makeInfo(const std::string& userid) {
+    UserSessionInfo info;
+    info.num_session = 1;
+    info.num_user = 2;
+    info.userid = userid;
+    info.user_privilege = 0;
+    info.user_aclogin = "login";
+    info.user_achome = "/home/login";
+    info.machine_name = "machine";
+    info.num_machine = "3";
+    return info;
+  }
+}
+
+BOOST_AUTO_TEST_SUITE( SessionCache_unit_tests )
+
+BOOST_AUTO_TEST_CASE( test_info_n )
+{
+  SessionCache& cache = SessionCache::getInstance();
+  cache.setTtl(DEFAULT_SESSION_CACHE_TTL);
+  cache.clear();
+
+  UserSessionInfo info;
+  BOOST_REQUIRE(!cache.getInfo("key1", "machine_1", info));
+  cache.putInfo("key1", "machine_1", makeInfo("user_1"));
+  BOOST_REQUIRE(cache.getInfo("key1", "machine_1", info));
+  BOOST_REQUIRE_EQUAL(info.user_aclogin, "login");
+  // the machine is part of the key
+  BOOST_REQUIRE(!cache.getInfo("key1", "", info));
+  BOOST_MESSAGE("Test session info cache OK");
+}
+
+BOOST_AUTO_TEST_CASE( test_invalidate_n )
+{
+  SessionCache& cache = SessionCache::getInstance();
+  cache.setTtl(DEFAULT_SESSION_CACHE_TTL);
+  cache.clear();
+  UserSessionInfo info;
+
+  cache.putInfo("key1", "machine_1", makeInfo("user_1"));
+  cache.putInfo("key1", "", makeInfo("user_1"));
+  cache.putInfo("key2", "", makeInfo("user_2"));
+  cache.setChecked("key1", "user_1");
+  cache.setChecked("key2", "user_2");
+
+  cache.invalidateSession("key1");
+  BOOST_REQUIRE(!cache.getInfo("key1", "machine_1", info));
+  BOOST_REQUIRE(!cache.getInfo("key1", "", info));
+  BOOST_REQUIRE(!cache.isChecked("key1"));
+  BOOST_REQUIRE(cache.getInfo("key2", "", info));
+
+  cache.invalidateUser("user_2");
+  BOOST_REQUIRE(!cache.getInfo("key2", "", info));
+  BOOST_REQUIRE(!cache.isChecked("key2"));
+  BOOST_MESSAGE("Test session cache invalidation OK");
+}
+
+BOOST_AUTO_TEST_CASE( test_disabled_n )
+{
+  SessionCache& cache = SessionCache::getInstance();
+  cache.setTtl(0);
+  UserSessionInfo info;
+
+  cache.putInfo("key1", "", makeInfo("user_1"));
+  cache.setChecked("key1", "user_1");
+  BOOST_REQUIRE(!cache.getInfo("key1", "", info));
+  BOOST_REQUIRE(!cache.isChecked("key1"));
+  cache.setTtl(DEFAULT_SESSION_CACHE_TTL);
+  BOOST_MESSAGE("Test disabled session cache OK");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,43 @@
+#include <boost/test/unit_test.hpp>
+#include <string>
+#include "SqlEscape.hpp"
+
+BOOST_AUTO_TEST_SUITE( SqlEscape_unit_tests )
+
+BOOST_AUTO_TEST_CASE( test_escapeMySQL_n )
+{
+  std::string input("it's a \"quote\"\\\n\r");
+  input += '\0';
+  input += '\032';
+
+  BOOST_REQUIRE_EQUAL(SqlEscape::escapeMySQL("plain", false), "plain");
+  BOOST_REQUIRE_EQUAL(SqlEscape::escapeMySQL(input, false),
+                      "it\\'s a \\\"quote\\\"\\\\\\n\\r\\0\\Z");
+  BOOST_REQUIRE_EQUAL(SqlEscape::escapeMySQL("it's\\", true), "it''s\\");
+  BOOST_MESSAGE("Test escape MySQL OK");
+}
+
+BOOST_AUTO_TEST_CASE( test_escapePostgreSQL_n )
+{
+  std::string input("it's\\");
+  input += '\0';
+  input += "ignored";
+
+  BOOST_REQUIRE_EQUAL(SqlEscape::escapePostgreSQL(input, true), "it''s\\");
+  BOOST_REQUIRE_EQUAL(SqlEscape::escapePostgreSQL(input, false), "it''s\\\\");
+  BOOST_MESSAGE("Test escape PostgreSQL OK");
+}
+
+BOOST_AUTO_TEST_CASE( test_isSafeCharset_n )
+{
+  BOOST_REQUIRE(SqlEscape::isSafeCharset("utf8mb4"));
+  BOOST_REQUIRE(SqlEscape::isSafeCharset("latin1"));
+  BOOST_REQUIRE(SqlEscape::isSafeCharset("UTF8"));
+  BOOST_REQUIRE(SqlEscape::isSafeCharset("SQL_ASCII"));
+  BOOST_REQUIRE(!SqlEscape::isSafeCharset("sjis"));
+  BOOST_REQUIRE(!SqlEscape::isSafeCharset("GBK"));
+  BOOST_REQUIRE(!SqlEscape::isSafeCharset("BIG5"));
+  BOOST_MESSAGE("Test safe charsets OK");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -112,6 +112,7 @@ create_dir core/database
 copy_file core/database/database_\*.sql core/database/
 copy_file core/database/postgre_\*.sql core/database/
 copy_file core/database/mysql_\*.sql core/database/
+copy_file core/database/database_migrate.sh core/database/
 
 # dependency of emf
 create_dir core/deps